@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * NEON memcpy(), memmove(), memset() and memcmp() for Cortex-A
+ *
+ * Large areas are handled 64 bytes at a time through four q registers, the
+ * remainder with word and byte loops. NEON loads and stores accept any
+ * alignment, but on Cortex-A9 a store crossing a 16 byte boundary costs an
+ * extra cycle, so the destination is aligned first. These replace
+ * memcpy.S and memset.S when the string_neon GN argument is set.
+ *
+ * Built with -fno-tree-loop-distribute-patterns so that the byte loops are
+ * not turned back into calls to the functions they implement.
+ */
+
+#include <arm_neon.h>
+
+#include <linux/types.h>
+#include <asm/string.h>
+
+#define NEON_BLOCK	64
+/* Below this the alignment prologue costs more than NEON saves */
+#define NEON_MIN	128
+#define NEON_ALIGN	16
+/* Distance to preload ahead of the source, in bytes */
+#define NEON_PREFETCH	256
+
+typedef u32 __attribute__((__may_alias__)) neon_word_t;
+
+static inline bool words_aligned(const void *a, const void *b)
+{
+	return !(((uintptr_t)a | (uintptr_t)b) & (sizeof(u32) - 1));
+}
+
+static inline void copy_block(u8 *d, const u8 *s)
+{
+	uint8x16_t q0, q1, q2, q3;
+
+	q0 = vld1q_u8(s);
+	q1 = vld1q_u8(s + 16);
+	q2 = vld1q_u8(s + 32);
+	q3 = vld1q_u8(s + 48);
+	vst1q_u8(d, q0);
+	vst1q_u8(d + 16, q1);
+	vst1q_u8(d + 32, q2);
+	vst1q_u8(d + 48, q3);
+}
+
+void *memcpy(void *dest, const void *src, __kernel_size_t count)
+{
+	u8 *d = dest;
+	const u8 *s = src;
+
+	if (count >= NEON_MIN) {
+		for (; (uintptr_t)d & (NEON_ALIGN - 1); count--)
+			*d++ = *s++;
+		for (; count >= NEON_BLOCK; count -= NEON_BLOCK) {
+			__builtin_prefetch(s + NEON_PREFETCH);
+			copy_block(d, s);
+			d += NEON_BLOCK;
+			s += NEON_BLOCK;
+		}
+	}
+
+	if (words_aligned(d, s)) {
+		for (; count >= sizeof(u32); count -= sizeof(u32)) {
+			*(neon_word_t *)d = *(const neon_word_t *)s;
+			d += sizeof(u32);
+			s += sizeof(u32);
+		}
+	}
+	while (count--)
+		*d++ = *s++;
+
+	return dest;
+}
+
+void *memmove(void *dest, const void *src, __kernel_size_t count)
+{
+	u8 *d = dest;
+	const u8 *s = src;
+
+	/*
+	 * Copying forwards is safe unless the destination starts inside the
+	 * source; each block is loaded in full before any of it is stored.
+	 */
+	if (d <= s || d >= s + count)
+		return memcpy(dest, src, count);
+
+	d += count;
+	s += count;
+	if (count >= NEON_MIN) {
+		for (; (uintptr_t)d & (NEON_ALIGN - 1); count--)
+			*--d = *--s;
+		for (; count >= NEON_BLOCK; count -= NEON_BLOCK) {
+			d -= NEON_BLOCK;
+			s -= NEON_BLOCK;
+			__builtin_prefetch(s - NEON_PREFETCH);
+			copy_block(d, s);
+		}
+	}
+
+	if (words_aligned(d, s)) {
+		for (; count >= sizeof(u32); count -= sizeof(u32)) {
+			d -= sizeof(u32);
+			s -= sizeof(u32);
+			*(neon_word_t *)d = *(const neon_word_t *)s;
+		}
+	}
+	while (count--)
+		*--d = *--s;
+
+	return dest;
+}
+
+void *memset(void *s, int c, __kernel_size_t count)
+{
+	u8 *d = s;
+	u32 word;
+
+	if (count >= NEON_MIN) {
+		uint8x16_t q = vdupq_n_u8(c);
+
+		for (; (uintptr_t)d & (NEON_ALIGN - 1); count--)
+			*d++ = c;
+		for (; count >= NEON_BLOCK; count -= NEON_BLOCK) {
+			vst1q_u8(d, q);
+			vst1q_u8(d + 16, q);
+			vst1q_u8(d + 32, q);
+			vst1q_u8(d + 48, q);
+			d += NEON_BLOCK;
+		}
+	}
+
+	if (words_aligned(d, d)) {
+		word = (u8)c * 0x01010101u;
+		for (; count >= sizeof(u32); count -= sizeof(u32)) {
+			*(neon_word_t *)d = word;
+			d += sizeof(u32);
+		}
+	}
+	while (count--)
+		*d++ = c;
+
+	return s;
+}
+
+int memcmp(const void *cs, const void *ct, __kernel_size_t count)
+{
+	const u8 *a = cs;
+	const u8 *b = ct;
+	uint8x16_t q0, q1;
+	uint8x8_t d0;
+	int res;
+
+	/*
+	 * Moving a result from NEON to the core stalls the pipeline, so
+	 * check 32 bytes per transfer and leave finding the first differing
+	 * byte to the byte loop below.
+	 */
+	if (count >= NEON_MIN) {
+		for (; count >= 32; count -= 32) {
+			q0 = veorq_u8(vld1q_u8(a), vld1q_u8(b));
+			q1 = veorq_u8(vld1q_u8(a + 16), vld1q_u8(b + 16));
+			q0 = vorrq_u8(q0, q1);
+			d0 = vorr_u8(vget_low_u8(q0), vget_high_u8(q0));
+			if (vget_lane_u64(vreinterpret_u64_u8(d0), 0))
+				break;
+			a += 32;
+			b += 32;
+		}
+	}
+
+	for (; count; count--, a++, b++) {
+		res = *a - *b;
+		if (res)
+			return res;
+	}
+
+	return 0;
+}
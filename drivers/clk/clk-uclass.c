@@ -762,16 +762,20 @@ int clk_get_by_id(ulong id, struct clk **clkp)
 	if (ret)
 		return ret;
 
+	ret = -ENOENT;
+	dm_core_lock();
 	uclass_foreach_dev(dev, uc) {
 		struct clk *clk = dev_get_clk_ptr(dev);
 
 		if (clk && clk->id == id) {
 			*clkp = clk;
-			return 0;
+			ret = 0;
+			break;
 		}
 	}
+	dm_core_unlock();
 
-	return -ENOENT;
+	return ret;
 }
 
 bool clk_is_match(const struct clk *p, const struct clk *q)
@@ -14,6 +14,7 @@
 #include "log.h"
 #include "dm/device_compat.h"
 #include "dm/lists.h"
+#include "dt-structs.h"
 #include "asm/io.h"
 #include "asm/arch/clk.h"
 #include "asm/arch/hardware.h"
@@ -463,6 +464,12 @@ static struct clk_ops zynq_clk_ops = {
 static int zynq_clk_probe(struct udevice *dev)
 {
 	struct zynq_clk_priv *priv = dev_get_priv(dev);
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dtd_xlnx_ps7_clkc *dtplat = dev_get_plat(dev);
+
+	/* clk_get_by_name() needs the tree, the GEM EMIO rx clocks stay unknown */
+	priv->ps_clk_freq = dtplat->ps_clk_frequency;
+#else
 #ifndef CONFIG_SPL_BUILD
 	unsigned int i;
 	char name[16];
@@ -480,6 +487,7 @@ static int zynq_clk_probe(struct udevice *dev)
 
 	priv->ps_clk_freq = fdtdec_get_uint(dm_fdt_blob(), dev_of_offset(dev),
 					    "ps-clk-frequency", 33333333UL);
+#endif
 
 	return 0;
 }
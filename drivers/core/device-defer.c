@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Deferred probing
+ *
+ * A driver whose supplier is not ready yet returns -EPROBE_DEFER from its
+ * probe() method. The device is then put on a pending list instead of being
+ * treated as failed, and the whole list is retried after another device
+ * probes successfully, since that device may be the missing supplier. The
+ * retry waits until the outermost device_probe() call has returned, so it
+ * neither nests inside the supplier's probe nor adds to its probe time. Drivers
+ * can record why they deferred with dev_err_probe(), which the 'dm -df'
+ * shell command shows for every device still waiting.
+ */
+
+#define LOG_CATEGORY LOGC_DM
+
+#include <rtems/malloc.h>
+#include <rtems/thread.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common.h>
+#include <log.h>
+#include <dm/device.h>
+#include <dm/device_compat.h>
+#include <dm/device-internal.h>
+#include <dm/util.h>
+#include <linux/errno.h>
+#include <linux/list.h>
+#include <linux/string.h>
+
+#define DEFER_REASON_LEN	48
+
+/**
+ * struct device_deferred - A device waiting for its probe to be retried
+ *
+ * @node: Entry in deferred_list
+ * @dev: Device which returned -EPROBE_DEFER
+ * @reason: Last reason given through dev_err_probe(), may be empty
+ * @retries: Number of times the probe was retried and deferred again
+ * @pass: Retry pass which last picked this entry
+ * @busy: true while the entry's device is being probed by a retry pass
+ * @deferred: Set when the device defers, cleared before each retry
+ */
+struct device_deferred {
+	struct list_head node;
+	struct udevice *dev;
+	char reason[DEFER_REASON_LEN];
+	int retries;
+	uint pass;
+	bool busy;
+	bool deferred;
+};
+
+static LIST_HEAD(deferred_list);
+static rtems_mutex deferred_lock = RTEMS_MUTEX_INITIALIZER("dm defer");
+static uint deferred_pass;
+static int deferred_depth;
+static bool deferred_pending;
+static bool deferred_retrying;
+static bool deferred_again;
+
+static struct device_deferred *device_deferred_find(struct udevice *dev)
+{
+	struct device_deferred *entry;
+
+	list_for_each_entry(entry, &deferred_list, node) {
+		if (entry->dev == dev)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static struct device_deferred *device_deferred_get(struct udevice *dev)
+{
+	struct device_deferred *entry;
+
+	entry = device_deferred_find(dev);
+	if (entry)
+		return entry;
+
+	entry = rtems_calloc(1, sizeof(*entry));
+	if (!entry)
+		return NULL;
+	entry->dev = dev;
+	list_add_tail(&entry->node, &deferred_list);
+
+	return entry;
+}
+
+static void device_deferred_free(struct device_deferred *entry)
+{
+	list_del(&entry->node);
+	free(entry);
+}
+
+void device_defer(struct udevice *dev)
+{
+	struct device_deferred *entry;
+
+	rtems_mutex_lock(&deferred_lock);
+	entry = device_deferred_get(dev);
+	if (entry)
+		entry->deferred = true;
+	else
+		dm_warn("%s: cannot queue deferred probe\n", dev->name);
+	rtems_mutex_unlock(&deferred_lock);
+}
+
+void device_defer_cancel(struct udevice *dev)
+{
+	struct device_deferred *entry;
+
+	rtems_mutex_lock(&deferred_lock);
+	entry = device_deferred_find(dev);
+	/* A retry pass owns a busy entry and frees it once the probe returns */
+	if (entry && !entry->busy)
+		device_deferred_free(entry);
+	else if (entry)
+		entry->deferred = false;
+	rtems_mutex_unlock(&deferred_lock);
+}
+
+void device_defer_trigger(void)
+{
+	struct device_deferred *entry;
+	struct udevice *dev;
+
+	rtems_mutex_lock(&deferred_lock);
+	if (list_empty(&deferred_list)) {
+		rtems_mutex_unlock(&deferred_lock);
+		return;
+	}
+
+	/*
+	 * Only one pass runs at a time. A success seen while it runs, either
+	 * from the pass itself or from another task, asks it to go round again
+	 * rather than starting a nested pass.
+	 */
+	if (deferred_retrying) {
+		deferred_again = true;
+		rtems_mutex_unlock(&deferred_lock);
+		return;
+	}
+	deferred_retrying = true;
+
+	do {
+		deferred_again = false;
+		deferred_pass++;
+		for (;;) {
+			dev = NULL;
+			list_for_each_entry(entry, &deferred_list, node) {
+				if (!entry->busy && entry->pass != deferred_pass) {
+					entry->busy = true;
+					entry->pass = deferred_pass;
+					entry->deferred = false;
+					dev = entry->dev;
+					break;
+				}
+			}
+			if (!dev)
+				break;
+
+			rtems_mutex_unlock(&deferred_lock);
+			device_probe(dev);
+			rtems_mutex_lock(&deferred_lock);
+
+			entry->busy = false;
+			if (entry->deferred)
+				entry->retries++;
+			else
+				device_deferred_free(entry);
+		}
+	} while (deferred_again);
+
+	deferred_retrying = false;
+	rtems_mutex_unlock(&deferred_lock);
+}
+
+void device_defer_enter(void)
+{
+	rtems_mutex_lock(&deferred_lock);
+	deferred_depth++;
+	rtems_mutex_unlock(&deferred_lock);
+}
+
+void device_defer_leave(bool probed)
+{
+	bool retry;
+
+	rtems_mutex_lock(&deferred_lock);
+	if (probed)
+		deferred_pending = true;
+	retry = !--deferred_depth && deferred_pending;
+	if (retry)
+		deferred_pending = false;
+	rtems_mutex_unlock(&deferred_lock);
+
+	if (retry)
+		device_defer_trigger();
+}
+
+int device_defer_count(void)
+{
+	struct list_head *pos;
+	int count = 0;
+
+	rtems_mutex_lock(&deferred_lock);
+	list_for_each(pos, &deferred_list)
+		count++;
+	rtems_mutex_unlock(&deferred_lock);
+
+	return count;
+}
+
+int dev_err_probe(struct udevice *dev, int err, const char *fmt, ...)
+{
+	struct device_deferred *entry;
+	char reason[DEFER_REASON_LEN];
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(reason, sizeof(reason), fmt, args);
+	va_end(args);
+
+	if (err != -EPROBE_DEFER) {
+		dev_err(dev, "error %d: %s\n", err, reason);
+		return err;
+	}
+
+	dev_dbg(dev, "deferred: %s\n", reason);
+	rtems_mutex_lock(&deferred_lock);
+	entry = device_deferred_get(dev);
+	if (entry)
+		strlcpy(entry->reason, reason, sizeof(entry->reason));
+	rtems_mutex_unlock(&deferred_lock);
+
+	return err;
+}
+
+void dm_dump_deferred(void)
+{
+	struct device_deferred *entry;
+	int count = 0;
+
+	puts("Device                          Driver                  Retries  Reason\n");
+	puts("---------------------------------------------------------------------\n");
+	rtems_mutex_lock(&deferred_lock);
+	list_for_each_entry(entry, &deferred_list, node) {
+		printf("%-31.31s %-22.22s %7d  %s\n", entry->dev->name,
+		       entry->dev->driver->name, entry->retries,
+		       entry->reason[0] ? entry->reason : "-");
+		count++;
+	}
+	rtems_mutex_unlock(&deferred_lock);
+	printf("\n%d device(s) waiting for a supplier\n", count);
+}
@@ -12,11 +12,13 @@
 
 #include <stdlib.h>
 #include <rtems/malloc.h>
+#include <rtems/rtems/cache.h>
 
 #include <common.h>
 #include <log.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
+#include <dm/slab.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -84,6 +86,8 @@ int device_unbind(struct udevice *dev)
 	if (!(dev_get_flags(dev) & DM_FLAG_BOUND))
 		return log_msg_ret("not-bound", -EINVAL);
 
+	device_defer_cancel(dev);
+
 	drv = dev->driver;
 	assert(drv);
 
@@ -98,24 +102,25 @@ int device_unbind(struct udevice *dev)
 		return log_msg_ret("child unbind", ret);
 
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_PDATA) {
-		free(dev_get_plat(dev));
+		dm_slab_free(dev_get_plat(dev));
 		dev_set_plat(dev, NULL);
 	}
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev_get_uclass_plat(dev));
+		dm_slab_free(dev_get_uclass_plat(dev));
 		dev_set_uclass_plat(dev, NULL);
 	}
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_PARENT_PDATA) {
-		free(dev_get_parent_plat(dev));
+		dm_slab_free(dev_get_parent_plat(dev));
 		dev_set_parent_plat(dev, NULL);
 	}
+	dm_core_lock();
 	ret = uclass_unbind_device(dev);
+	if (!ret && dev->parent)
+		list_del(&dev->sibling_node);
+	dm_core_unlock();
 	if (ret)
 		return log_msg_ret("uc", ret);
 
-	if (dev->parent)
-		list_del(&dev->sibling_node);
-
 	devres_release_all(dev);
 
 	if (dev_get_flags(dev) & DM_FLAG_NAME_ALLOCED)
@@ -125,6 +130,15 @@ int device_unbind(struct udevice *dev)
 	return 0;
 }
 
+/* Free data from alloc_priv(), which uses the same @flags */
+static void free_priv(void *priv, uint flags)
+{
+	if (flags & DM_FLAG_ALLOC_PRIV_DMA)
+		rtems_cache_coherent_free(priv);
+	else
+		dm_slab_free(priv);
+}
+
 /**
  * device_free() - Free memory buffers allocated by a device
  * @dev:	Device that is to be started
@@ -134,12 +148,13 @@ void device_free(struct udevice *dev)
 	int size;
 
 	if (dev->driver->priv_auto) {
-		free(dev_get_priv(dev));
+		free_priv(dev_get_priv(dev), dev->driver->flags);
 		dev_set_priv(dev, NULL);
 	}
 	size = dev->uclass->uc_drv->per_device_auto;
 	if (size) {
-		free(dev_get_uclass_priv(dev));
+		free_priv(dev_get_uclass_priv(dev),
+			  dev->uclass->uc_drv->flags);
 		dev_set_uclass_priv(dev, NULL);
 	}
 	if (dev->parent) {
@@ -149,7 +164,8 @@ void device_free(struct udevice *dev)
 					per_child_auto;
 		}
 		if (size) {
-			free(dev_get_parent_priv(dev));
+			free_priv(dev_get_parent_priv(dev),
+				  dev->driver->flags);
 			dev_set_parent_priv(dev, NULL);
 		}
 	}
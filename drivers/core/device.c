@@ -13,6 +13,8 @@
 
 #include <bsp/fdt.h>
 
+#include <base/boottime.h>
+
 #include <stdlib.h>
 #include <common.h>
 #include <log.h>
@@ -28,6 +30,7 @@
 #include <dm/pinctrl.h>
 #include <dm/platdata.h>
 #include <dm/read.h>
+#include <dm/slab.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -39,10 +42,9 @@
 #define ARCH_DMA_MINALIGN CPU_ALIGNMENT
 #endif
 
-static int device_bind_common(struct udevice *parent, const struct driver *drv,
-			      const char *name, void *plat,
-			      ulong driver_data, ofnode node,
-			      uint of_plat_size, struct udevice **devp)
+static int device_do_bind(struct udevice *parent, const struct driver *drv,
+			  const char *name, void *plat, ulong driver_data,
+			  ofnode node, uint of_plat_size, struct udevice **devp)
 {
 	struct udevice *dev;
 	struct uclass *uc;
@@ -82,6 +84,11 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	dev->driver = drv;
 	dev->uclass = uc;
 
+	if ((drv->flags & DM_FLAG_PROBE_LAZY) ||
+	    (uc->uc_drv->flags & DM_UC_FLAG_PROBE_LAZY) ||
+	    (ofnode_valid(node) && ofnode_read_bool(node, "u-boot,dm-lazy")))
+		dev_or_flags(dev, DM_FLAG_PROBE_LAZY);
+
 	dev->seq_ = -1;
 	if (CONFIG_IS_ENABLED(DM_SEQ_ALIAS) &&
 	    (uc->uc_drv->flags & DM_UC_FLAG_SEQ_ALIAS)) {
@@ -114,9 +121,18 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			if (of_plat_size < drv->plat_auto)
 				alloc = true;
 		}
+		/*
+		 * A lazy device gets its plat when it is first probed, unless
+		 * a bind method might want it before that, or there is
+		 * of-platdata to copy into it
+		 */
+		if (alloc && !plat && (dev_get_flags(dev) & DM_FLAG_PROBE_LAZY) &&
+		    !drv->bind && !uc->uc_drv->post_bind &&
+		    !(parent && parent->driver->child_post_bind))
+			alloc = false;
 		if (alloc) {
 			dev_or_flags(dev, DM_FLAG_ALLOC_PDATA);
-			ptr = calloc(1, drv->plat_auto);
+			ptr = dm_slab_alloc(drv->plat_auto);
 			if (!ptr) {
 				ret = -ENOMEM;
 				goto fail_alloc1;
@@ -135,7 +151,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	size = uc->uc_drv->per_device_plat_auto;
 	if (size) {
 		dev_or_flags(dev, DM_FLAG_ALLOC_UCLASS_PDATA);
-		ptr = calloc(1, size);
+		ptr = dm_slab_alloc(size);
 		if (!ptr) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
@@ -149,7 +165,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			size = parent->uclass->uc_drv->per_child_plat_auto;
 		if (size) {
 			dev_or_flags(dev, DM_FLAG_ALLOC_PARENT_PDATA);
-			ptr = calloc(1, size);
+			ptr = dm_slab_alloc(size);
 			if (!ptr) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
@@ -205,17 +221,17 @@ fail_bind:
 fail_uclass_bind:
 	list_del(&dev->sibling_node);
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_PARENT_PDATA) {
-		free(dev_get_parent_plat(dev));
+		dm_slab_free(dev_get_parent_plat(dev));
 		dev_set_parent_plat(dev, NULL);
 	}
 fail_alloc3:
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev_get_uclass_plat(dev));
+		dm_slab_free(dev_get_uclass_plat(dev));
 		dev_set_uclass_plat(dev, NULL);
 	}
 fail_alloc2:
 	if (dev_get_flags(dev) & DM_FLAG_ALLOC_PDATA) {
-		free(dev_get_plat(dev));
+		dm_slab_free(dev_get_plat(dev));
 		dev_set_plat(dev, NULL);
 	}
 
@@ -227,6 +243,23 @@ fail_alloc1:
 	return ret;
 }
 
+static int device_bind_common(struct udevice *parent, const struct driver *drv,
+			      const char *name, void *plat,
+			      ulong driver_data, ofnode node,
+			      uint of_plat_size, struct udevice **devp)
+{
+	boottime_t start = boottime_begin();
+	int ret;
+
+	dm_core_lock();
+	ret = device_do_bind(parent, drv, name, plat, driver_data, node,
+			     of_plat_size, devp);
+	dm_core_unlock();
+	boottime_end(name, BOOTTIME_BIND, start);
+
+	return ret;
+}
+
 int device_bind_with_driver_data(struct udevice *parent,
 				 const struct driver *drv, const char *name,
 				 ulong driver_data, ofnode node,
@@ -275,6 +308,7 @@ int device_reparent(struct udevice *dev, struct udevice *new_parent)
 	assert(dev);
 	assert(new_parent);
 
+	dm_core_lock();
 	list_for_each_entry_safe(pos, n, &dev->parent->child_head,
 				 sibling_node) {
 		if (pos->driver != dev->driver)
@@ -286,6 +320,7 @@ int device_reparent(struct udevice *dev, struct udevice *new_parent)
 
 		break;
 	}
+	dm_core_unlock();
 
 	return 0;
 }
@@ -328,7 +363,7 @@ static void *alloc_priv(int size, uint flags)
 #endif
 		}
 	} else {
-		priv = rtems_calloc(1, size);
+		priv = dm_slab_alloc(size);
 	}
 
 	return priv;
@@ -382,6 +417,24 @@ static int device_alloc_priv(struct udevice *dev)
 	return 0;
 }
 
+/* Allocate the plat which device_bind_common() left out for a lazy device */
+static int device_alloc_lazy_plat(struct udevice *dev)
+{
+	const struct driver *drv = dev->driver;
+	void *ptr;
+
+	if (!drv->plat_auto || dev_get_plat(dev))
+		return 0;
+
+	ptr = dm_slab_alloc(drv->plat_auto);
+	if (!ptr)
+		return -ENOMEM;
+	dev_or_flags(dev, DM_FLAG_ALLOC_PDATA);
+	dev_set_plat(dev, ptr);
+
+	return 0;
+}
+
 int device_of_to_plat(struct udevice *dev)
 {
 	const struct driver *drv;
@@ -414,6 +467,10 @@ int device_of_to_plat(struct udevice *dev)
 				return 0;
 		}
 
+		ret = device_alloc_lazy_plat(dev);
+		if (ret)
+			goto fail;
+
 		ret = device_alloc_priv(dev);
 		if (ret)
 			goto fail;
@@ -474,9 +531,29 @@ static int device_get_dma_constraints(struct udevice *dev)
 	return 0;
 }
 
-int device_probe(struct udevice *dev)
+/*
+ * Test and set DM_FLAG_ACTIVATED in one step, so that of two tasks probing
+ * the same device only one goes on to probe it
+ *
+ * @return true if the caller set the flag and must probe @dev
+ */
+static bool device_claim_probe(struct udevice *dev)
+{
+	bool claimed;
+
+	dm_core_lock();
+	claimed = !(dev_get_flags(dev) & DM_FLAG_ACTIVATED);
+	if (claimed)
+		dev_or_flags(dev, DM_FLAG_ACTIVATED);
+	dm_core_unlock();
+
+	return claimed;
+}
+
+static int device_do_probe(struct udevice *dev)
 {
 	const struct driver *drv;
+	bool claimed = false;
 	int ret;
 
 	if (!dev)
@@ -497,18 +574,17 @@ int device_probe(struct udevice *dev)
 		ret = device_probe(dev->parent);
 		if (ret)
 			goto fail;
-
-		/*
-		 * The device might have already been probed during
-		 * the call to device_probe() on its parent device
-		 * (e.g. PCI bridge devices). Test the flags again
-		 * so that we don't mess up the device.
-		 */
-		if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
-			return 0;
 	}
 
-	dev_or_flags(dev, DM_FLAG_ACTIVATED);
+	/*
+	 * The device might have already been probed during the call to
+	 * device_probe() on its parent device (e.g. PCI bridge devices), or
+	 * by another task since the test above. Claim it so that we don't
+	 * mess up the device.
+	 */
+	claimed = device_claim_probe(dev);
+	if (!claimed)
+		return 0;
 
 	/*
 	 * Process pinctrl for everything except the root device, and
@@ -574,6 +650,8 @@ int device_probe(struct udevice *dev)
 	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
 		pinctrl_select_state(dev, "default");
 
+	device_defer_cancel(dev);
+
 	return 0;
 fail_uclass:
 	if (device_remove(dev, DM_REMOVE_NORMAL)) {
@@ -581,9 +659,40 @@ fail_uclass:
 			__func__, dev->name);
 	}
 fail:
+	dm_core_lock();
+	if (!claimed && (dev_get_flags(dev) & DM_FLAG_ACTIVATED)) {
+		/* Another task has claimed the device, leave it to that one */
+		dm_core_unlock();
+		return ret;
+	}
 	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
-
 	device_free(dev);
+	dm_core_unlock();
+
+	/* Drop any entry dev_err_probe() queued for an earlier deferral */
+	if (ret == -EPROBE_DEFER)
+		device_defer(dev);
+	else
+		device_defer_cancel(dev);
+
+	return ret;
+}
+
+int device_probe(struct udevice *dev)
+{
+	boottime_t start;
+	int ret;
+
+	/* Only time real probes, not the check on an active device */
+	if (!dev || (dev_get_flags(dev) & DM_FLAG_ACTIVATED))
+		return device_do_probe(dev);
+
+	device_defer_enter();
+	start = boottime_begin();
+	ret = device_do_probe(dev);
+	boottime_end(dev->name, BOOTTIME_PROBE, start);
+	/* This device may be the supplier a deferred device is waiting for */
+	device_defer_leave(!ret);
 
 	return ret;
 }
@@ -817,9 +926,10 @@ int device_get_by_ofplat_idx(uint idx, struct udevice **devp)
 
 		dev = base + idx;
 	} else {
-		struct driver_rt *drt = gd_dm_driver_rt() + idx;
-
-		dev = drt->dev;
+		/* dtoc gives a phandle to a node without a driver index -1 */
+		if (idx >= ll_entry_count(struct driver_info, driver_info))
+			return -ENOENT;
+		dev = gd_dm_driver_rt()[idx].dev;
 	}
 	*devp = NULL;
 
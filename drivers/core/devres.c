@@ -17,8 +17,10 @@
 #include <linux/kernel.h>
 #include <linux/list.h>
 #include <dm/device.h>
+#include <dm/device-internal.h>
 #include <dm/devres.h>
 #include <dm/root.h>
+#include <dm/slab.h>
 #include <dm/util.h>
 
 
@@ -83,7 +85,7 @@ void *_devres_alloc(dr_release_t release, size_t size, gfp_t gfp)
 	struct devres *dr;
 
 	(void) gfp;
-	dr = rtems_malloc(tot_size);
+	dr = dm_slab_alloc(tot_size);
 	if (unlikely(!dr))
 		return NULL;
 
@@ -100,7 +102,7 @@ void devres_free(void *res)
 		struct devres *dr = container_of(res, struct devres, data);
 
 		assert_noisy(list_empty(&dr->entry));
-		free(dr);
+		dm_slab_free(dr);
 	}
 }
 
@@ -116,23 +118,29 @@ void devres_add(struct udevice *dev, void *res)
 		dr->phase = DEVRES_PHASE_OFDATA;
 	else
 		dr->phase = DEVRES_PHASE_BIND;
+	dm_core_lock();
 	list_add_tail(&dr->entry, &dev->devres_head);
+	dm_core_unlock();
 }
 
 void *devres_find(struct udevice *dev, dr_release_t release,
 		  dr_match_t match, void *match_data)
 {
 	struct devres *dr;
+	void *res = NULL;
 
+	dm_core_lock();
 	list_for_each_entry_reverse(dr, &dev->devres_head, entry) {
 		if (dr->release != release)
 			continue;
 		if (match && !match(dev, dr->data, match_data))
 			continue;
-		return dr->data;
+		res = dr->data;
+		break;
 	}
+	dm_core_unlock();
 
-	return NULL;
+	return res;
 }
 
 void *devres_get(struct udevice *dev, void *new_res,
@@ -141,12 +149,14 @@ void *devres_get(struct udevice *dev, void *new_res,
 	struct devres *new_dr = container_of(new_res, struct devres, data);
 	void *res;
 
+	dm_core_lock();
 	res = devres_find(dev, new_dr->release, match, match_data);
 	if (!res) {
 		devres_add(dev, new_res);
 		res = new_res;
 		new_res = NULL;
 	}
+	dm_core_unlock();
 	devres_free(new_res);
 
 	return res;
@@ -157,6 +167,7 @@ void *devres_remove(struct udevice *dev, dr_release_t release,
 {
 	void *res;
 
+	dm_core_lock();
 	res = devres_find(dev, release, match, match_data);
 	if (res) {
 		struct devres *dr = container_of(res, struct devres, data);
@@ -164,6 +175,7 @@ void *devres_remove(struct udevice *dev, dr_release_t release,
 		list_del_init(&dr->entry);
 		devres_log(dev, dr, "REM");
 	}
+	dm_core_unlock();
 
 	return res;
 }
@@ -205,8 +217,10 @@ static void release_nodes(struct udevice *dev, struct list_head *head,
 			break;
 		devres_log(dev, dr, "REL");
 		dr->release(dev, dr->data);
+		dm_core_lock();
 		list_del(&dr->entry);
-		kfree(dr);
+		dm_core_unlock();
+		dm_slab_free(dr);
 	}
 }
 
@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Size-class allocator for driver model bookkeeping
+ *
+ * Every size class owns a list of fixed-size pages taken from the heap, each
+ * split into equal objects linked on a per-page free list. Pages with a free
+ * object are kept at the head of the list, so allocation looks at one page
+ * only. Freeing an object finds its page by address; a page which becomes
+ * empty is given back to the heap unless it is the last one of its class.
+ * Requests above the largest class go to the heap with a small header and
+ * are kept on a list, so that a pointer owned by neither a page nor that
+ * list is reported and leaked rather than handed to free().
+ *
+ * Objects are only freed on the unbind and remove paths, so the linear page
+ * lookup in dm_slab_free() stays off the boot path.
+ */
+
+#define LOG_CATEGORY LOGC_DM
+
+#include <rtems/malloc.h>
+#include <rtems/thread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common.h>
+#include <log.h>
+#include <dm/slab.h>
+#include <linux/kernel.h>
+#include <linux/list.h>
+
+#ifndef CONFIG_DM_SLAB_PAGE_SIZE
+#define CONFIG_DM_SLAB_PAGE_SIZE	2048
+#endif
+
+/**
+ * struct slab_page - A page of equally sized objects
+ *
+ * @node: Entry in the page list of the owning class
+ * @free: First free object, each free object holds the next one
+ * @inuse: Number of objects handed out
+ * @data: Objects
+ */
+struct slab_page {
+	struct list_head node;
+	void *free;
+	unsigned int inuse;
+	unsigned long long data[];
+};
+
+/**
+ * struct slab_class - Pages serving one object size
+ *
+ * @pages: Pages of this class, those with a free object first
+ * @size: Object size in bytes
+ * @per_page: Number of objects in a page
+ * @npages: Number of pages in @pages
+ * @objects: Number of objects handed out
+ * @peak: Largest value @objects has reached
+ */
+struct slab_class {
+	struct list_head pages;
+	unsigned int size;
+	unsigned int per_page;
+	unsigned int npages;
+	unsigned long objects;
+	unsigned long peak;
+};
+
+/**
+ * struct slab_large - Header of an allocation above the largest class
+ *
+ * @node: Entry in slab_large_list
+ * @size: Requested size in bytes
+ * @data: Memory handed out
+ */
+struct slab_large {
+	struct list_head node;
+	size_t size;
+	unsigned long long data[];
+};
+
+#define SLAB_CLASS(_i, _size) \
+	{ .pages = LIST_HEAD_INIT(slab_classes[_i].pages), .size = (_size) }
+
+static struct slab_class slab_classes[] = {
+	SLAB_CLASS(0, 16),
+	SLAB_CLASS(1, 32),
+	SLAB_CLASS(2, 64),
+	SLAB_CLASS(3, 128),
+	SLAB_CLASS(4, 256),
+	SLAB_CLASS(5, 512),
+};
+
+static LIST_HEAD(slab_large_list);
+static struct dm_slab_stats slab_stats;
+static rtems_mutex slab_lock = RTEMS_MUTEX_INITIALIZER("dm slab");
+
+#define SLAB_PAGE_OBJECTS(_size) \
+	((CONFIG_DM_SLAB_PAGE_SIZE - sizeof(struct slab_page)) / (_size))
+
+static struct slab_class *slab_class_for(size_t size)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(slab_classes); i++) {
+		if (size <= slab_classes[i].size)
+			return &slab_classes[i];
+	}
+
+	return NULL;
+}
+
+/* Must be called with slab_lock held */
+static struct slab_page *slab_page_new(struct slab_class *sc)
+{
+	struct slab_page *page;
+	char *obj;
+	int i;
+
+	if (!sc->per_page)
+		sc->per_page = SLAB_PAGE_OBJECTS(sc->size);
+
+	page = rtems_malloc(CONFIG_DM_SLAB_PAGE_SIZE);
+	if (!page)
+		return NULL;
+
+	page->inuse = 0;
+	page->free = NULL;
+	obj = (char *)page->data + (sc->per_page - 1) * sc->size;
+	for (i = 0; i < sc->per_page; i++, obj -= sc->size) {
+		*(void **)obj = page->free;
+		page->free = obj;
+	}
+	list_add(&page->node, &sc->pages);
+	sc->npages++;
+
+	slab_stats.pages++;
+	if (slab_stats.pages > slab_stats.pages_peak)
+		slab_stats.pages_peak = slab_stats.pages;
+
+	return page;
+}
+
+/* Must be called with slab_lock held */
+static struct slab_page *slab_page_find(const void *ptr,
+					struct slab_class **scp)
+{
+	struct slab_page *page;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(slab_classes); i++) {
+		list_for_each_entry(page, &slab_classes[i].pages, node) {
+			if ((char *)ptr >= (char *)page->data &&
+			    (char *)ptr < (char *)page + CONFIG_DM_SLAB_PAGE_SIZE) {
+				*scp = &slab_classes[i];
+				return page;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with slab_lock held */
+static struct slab_large *slab_large_find(const void *ptr)
+{
+	struct slab_large *large;
+
+	list_for_each_entry(large, &slab_large_list, node) {
+		if (ptr == large->data)
+			return large;
+	}
+
+	return NULL;
+}
+
+static void *slab_alloc_large(size_t size)
+{
+	struct slab_large *large;
+
+	large = rtems_calloc(1, sizeof(*large) + size);
+	if (!large)
+		return NULL;
+	large->size = size;
+
+	rtems_mutex_lock(&slab_lock);
+	list_add(&large->node, &slab_large_list);
+	slab_stats.large += size;
+	if (slab_stats.large > slab_stats.large_peak)
+		slab_stats.large_peak = slab_stats.large;
+	rtems_mutex_unlock(&slab_lock);
+
+	return large->data;
+}
+
+void *dm_slab_alloc(size_t size)
+{
+	struct slab_class *sc;
+	struct slab_page *page;
+	void *obj;
+
+	sc = slab_class_for(size);
+	if (!sc)
+		return slab_alloc_large(size);
+
+	rtems_mutex_lock(&slab_lock);
+	page = list_first_entry_or_null(&sc->pages, struct slab_page, node);
+	if (!page || !page->free) {
+		page = slab_page_new(sc);
+		if (!page) {
+			rtems_mutex_unlock(&slab_lock);
+			return NULL;
+		}
+	}
+
+	obj = page->free;
+	page->free = *(void **)obj;
+	page->inuse++;
+	if (!page->free)
+		list_move_tail(&page->node, &sc->pages);
+
+	sc->objects++;
+	if (sc->objects > sc->peak)
+		sc->peak = sc->objects;
+	slab_stats.objects++;
+	slab_stats.bytes += sc->size;
+	if (slab_stats.bytes > slab_stats.bytes_peak)
+		slab_stats.bytes_peak = slab_stats.bytes;
+	rtems_mutex_unlock(&slab_lock);
+
+	memset(obj, '\0', sc->size);
+
+	return obj;
+}
+
+void dm_slab_free(void *ptr)
+{
+	struct slab_large *large;
+	struct slab_class *sc;
+	struct slab_page *page;
+
+	if (!ptr)
+		return;
+
+	rtems_mutex_lock(&slab_lock);
+	page = slab_page_find(ptr, &sc);
+	if (!page) {
+		large = slab_large_find(ptr);
+		if (!large) {
+			rtems_mutex_unlock(&slab_lock);
+			log_err("%p was not allocated by dm_slab_alloc(), leaking it\n",
+				ptr);
+			return;
+		}
+		list_del(&large->node);
+		slab_stats.large -= large->size;
+		rtems_mutex_unlock(&slab_lock);
+		free(large);
+		return;
+	}
+
+	if (((char *)ptr - (char *)page->data) % sc->size ||
+	    (char *)ptr >= (char *)page->data + sc->per_page * sc->size ||
+	    !page->inuse) {
+		rtems_mutex_unlock(&slab_lock);
+		log_err("%p is not a live %u byte object, leaking it\n", ptr,
+			sc->size);
+		return;
+	}
+
+	if (!page->free)
+		list_move(&page->node, &sc->pages);
+	*(void **)ptr = page->free;
+	page->free = ptr;
+	page->inuse--;
+
+	sc->objects--;
+	slab_stats.objects--;
+	slab_stats.bytes -= sc->size;
+
+	if (!page->inuse && sc->npages > 1) {
+		list_del(&page->node);
+		sc->npages--;
+		slab_stats.pages--;
+		free(page);
+	}
+	rtems_mutex_unlock(&slab_lock);
+}
+
+void dm_slab_get_stats(struct dm_slab_stats *stats)
+{
+	rtems_mutex_lock(&slab_lock);
+	*stats = slab_stats;
+	rtems_mutex_unlock(&slab_lock);
+}
+
+void dm_dump_slab(void)
+{
+	struct dm_slab_stats stats;
+	struct slab_class *sc;
+	int i;
+
+	printf(" Size  Per page  Pages  Objects   Peak\n");
+	printf("--------------------------------------\n");
+	rtems_mutex_lock(&slab_lock);
+	for (i = 0; i < ARRAY_SIZE(slab_classes); i++) {
+		sc = &slab_classes[i];
+		printf("%5u  %8u  %5u  %7lu  %5lu\n", sc->size,
+		       (unsigned int)SLAB_PAGE_OBJECTS(sc->size), sc->npages,
+		       sc->objects, sc->peak);
+	}
+	stats = slab_stats;
+	rtems_mutex_unlock(&slab_lock);
+
+	printf("\n%lu objects, %lu bytes (peak %lu) in %lu pages of %u bytes (peak %lu)\n",
+	       stats.objects, stats.bytes, stats.bytes_peak, stats.pages,
+	       CONFIG_DM_SLAB_PAGE_SIZE, stats.pages_peak);
+	printf("Above %u bytes: %lu bytes (peak %lu)\n",
+	       slab_classes[ARRAY_SIZE(slab_classes) - 1].size, stats.large,
+	       stats.large_peak);
+}
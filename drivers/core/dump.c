@@ -8,6 +8,7 @@
 #include <common.h>
 #include <dm.h>
 #include <mapmem.h>
+#include <dm/device-internal.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/uclass-internal.h>
@@ -22,7 +23,8 @@ static void show_devices(struct udevice *dev, int depth, int last_flag)
 	printf(IS_ENABLED(CONFIG_SPL_BUILD) ? " %s  %d  [ %c ]   %s  " :
 	       " %-10.10s  %3d  [ %c ]   %-20.20s  ", dev->uclass->uc_drv->name,
 	       dev_get_uclass_index(dev, NULL),
-	       flags & DM_FLAG_ACTIVATED ? '+' : ' ', dev->driver->name);
+	       flags & DM_FLAG_ACTIVATED ? '+' :
+	       flags & DM_FLAG_PROBE_LAZY ? '~' : ' ', dev->driver->name);
 
 	for (i = depth; i >= 0; i--) {
 		is_last = (last_flag >> i) & 1;
@@ -93,10 +95,12 @@ void dm_dump_uclass(void)
 		printf("uclass %d: %s\n", id, uc->uc_drv->name);
 		if (list_empty(&uc->dev_head))
 			continue;
+		dm_core_lock();
 		uclass_foreach_dev(dev, uc) {
 			dm_display_line(dev, i);
 			i++;
 		}
+		dm_core_unlock();
 		puts("\n");
 	}
 }
@@ -149,6 +153,7 @@ void dm_dump_drivers(void)
 		}
 
 		i = 0;
+		dm_core_lock();
 		uclass_foreach_dev(udev, uc) {
 			if (udev->driver != entry)
 				continue;
@@ -158,6 +163,7 @@ void dm_dump_drivers(void)
 			printf("%-25.25s\n", udev->name);
 			i++;
 		}
+		dm_core_unlock();
 		if (!i)
 			puts("<none>\n");
 	}
@@ -1,61 +1,230 @@
+/*
+ * Threaded interrupt handlers
+ *
+ * Each processor gets its own interrupt server tasks, created on first use:
+ * a normal lane and a high priority lane selected with IRQF_THREAD_HIGH.
+ * A submission made while the request of the same interrupt is still
+ * pending is folded into it with a single atomic exchange, so a storm only
+ * wakes the thread once. Every threaded interrupt records the ISR to thread
+ * latency and the thread runtime into log2 histograms ('dm -i').
+ */
+#include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
-#include <rtems/sysinit.h>
+#include <sys/cpuset.h>
+
+#include <rtems.h>
+#include <rtems/counter.h>
+#include <rtems/malloc.h>
+#include <rtems/thread.h>
 #include <rtems/bspIo.h>
 
 #include "dm/interrupt.h"
 #include "dm/device.h"
 #include "dm/devres.h"
 #include "dm/device_compat.h"
+#include "linux/list.h"
+
+#ifndef CONFIG_IRQ_THREAD_PRIORITY
+#define CONFIG_IRQ_THREAD_PRIORITY 10
+#endif
+#ifndef CONFIG_IRQ_THREAD_HIGH_PRIORITY
+#define CONFIG_IRQ_THREAD_HIGH_PRIORITY 5
+#endif
+#ifndef CONFIG_IRQ_THREAD_STACK_SIZE
+#define CONFIG_IRQ_THREAD_STACK_SIZE 4096
+#endif
+
+#define IRQ_LANE_NORMAL  0
+#define IRQ_LANE_HIGH    1
+#define IRQ_LANES        2
+
+/* Bucket 0 counts spans under 1us, bucket n spans of [2^(n-1), 2^n) us */
+#define IRQ_HIST_BUCKETS 16
 
+struct irq_hist {
+    uint32_t bucket[IRQ_HIST_BUCKETS];
+    uint32_t max_us;
+};
+
+struct irq_server {
+    rtems_interrupt_server_control control;
+    uint32_t index;
+};
 
 struct irq_devres {
     rtems_interrupt_server_request req;
+    struct list_head node;
     rtems_interrupt_handler handler;
+    rtems_interrupt_handler thread_fn;
     void *arg;
+    rtems_interrupt_handler isr;
+    void *isr_arg;
+    const char *name;
+    unsigned int irq;
+    uint8_t cpu;
+    uint8_t lane;
+    atomic_bool pending;
+    rtems_counter_ticks stamp;
+    uint32_t wakeups;
+    uint32_t coalesced;
+    struct irq_hist latency;
+    struct irq_hist runtime;
 };
 
+static struct irq_server **irq_servers;
+static LIST_HEAD(irq_threads);
+static rtems_mutex irq_lock = RTEMS_MUTEX_INITIALIZER("irq threads");
+
+static void irq_hist_add(struct irq_hist *hist, rtems_counter_ticks ticks)
+{
+    uint32_t us = rtems_counter_ticks_to_nanoseconds(ticks) / 1000;
+    int n = us ? 32 - __builtin_clz(us) : 0;
+
+    if (n >= IRQ_HIST_BUCKETS)
+        n = IRQ_HIST_BUCKETS - 1;
+    hist->bucket[n]++;
+    if (us > hist->max_us)
+        hist->max_us = us;
+}
+
+/* Upper bound in us of the bucket holding the @permille'th span */
+static uint32_t irq_hist_percentile(const struct irq_hist *hist,
+    unsigned int permille)
+{
+    uint64_t total = 0, seen = 0;
+    int n;
+
+    for (n = 0; n < IRQ_HIST_BUCKETS; n++)
+        total += hist->bucket[n];
+    if (total == 0)
+        return 0;
+
+    for (n = 0; n < IRQ_HIST_BUCKETS - 1; n++) {
+        seen += hist->bucket[n];
+        if (seen * 1000 >= total * permille)
+            return n ? (1u << n) - 1 : 0;
+    }
+    return hist->max_us;
+}
+
+/* Must be called with irq_lock held */
+static struct irq_server *irq_server_get(uint32_t cpu, int lane)
+{
+    rtems_interrupt_server_config config = {
+        .name = rtems_build_name('I', lane ? 'R' : 'Q',
+            '0' + cpu / 10 % 10, '0' + cpu % 10),
+        .priority = lane ? CONFIG_IRQ_THREAD_HIGH_PRIORITY :
+            CONFIG_IRQ_THREAD_PRIORITY,
+        .storage_size = CONFIG_IRQ_THREAD_STACK_SIZE,
+        .modes = RTEMS_PREEMPT | RTEMS_NO_ASR | RTEMS_NO_TIMESLICE,
+        .attributes = RTEMS_LOCAL
+    };
+    uint32_t ncpus = rtems_scheduler_get_processor_maximum();
+    struct irq_server *srv;
+    rtems_status_code sc;
+
+    if (irq_servers == NULL) {
+        irq_servers = rtems_calloc(ncpus * IRQ_LANES, sizeof(*irq_servers));
+        if (irq_servers == NULL)
+            return NULL;
+    }
+    srv = irq_servers[cpu * IRQ_LANES + lane];
+    if (srv != NULL)
+        return srv;
+
+    srv = rtems_calloc(1, sizeof(*srv));
+    if (srv == NULL)
+        return NULL;
+    sc = rtems_interrupt_server_create(&srv->control, &config, &srv->index);
+    if (sc != RTEMS_SUCCESSFUL) {
+        printk("***Error: %s()-> %s\n", __func__, rtems_status_text(sc));
+        free(srv);
+        return NULL;
+    }
+    if (ncpus > 1) {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        rtems_task_set_affinity(srv->control.server, sizeof(set), &set);
+    }
+
+    irq_servers[cpu * IRQ_LANES + lane] = srv;
+    return srv;
+}
+
 static void devm_irq_release(struct udevice *dev, void *res)
 {
     struct irq_devres *this = res;
 
-    rtems_interrupt_handler_remove(this->req.entry.vector, 
-        this->handler, this->arg);
+    rtems_interrupt_handler_remove(this->irq, this->isr, this->isr_arg);
+    if (this->thread_fn) {
+        rtems_interrupt_server_request_destroy(&this->req);
+        rtems_mutex_lock(&irq_lock);
+        list_del(&this->node);
+        rtems_mutex_unlock(&irq_lock);
+    }
 }
 
 static int devm_irq_match(struct udevice *dev, void *res, void *data)
 {
     struct irq_devres *this = res, *match = data;
 
-    return this->req.entry.vector == match->req.entry.vector && 
-            this->req.action.arg == match->req.action.arg;
+    return this->irq == match->irq && this->arg == match->arg;
+}
+
+static void threaded_irq_thread(void *arg)
+{
+    struct irq_devres *dr = arg;
+    rtems_counter_ticks start, end;
+
+    start = rtems_counter_read();
+    /* Interrupts from here on need another pass of the thread */
+    atomic_store_explicit(&dr->pending, false, memory_order_release);
+    irq_hist_add(&dr->latency, rtems_counter_difference(start, dr->stamp));
+
+    dr->thread_fn(dr->arg);
+
+    end = rtems_counter_read();
+    irq_hist_add(&dr->runtime, rtems_counter_difference(end, start));
 }
 
-static void threaded_irq_wrappwer(void *arg)
+static void threaded_irq_wrapper(void *arg)
 {
     struct irq_devres *dr = arg;
-    
-    dr->handler(dr->req.action.arg);
+
+    if (dr->handler)
+        dr->handler(dr->arg);
+
+    if (atomic_exchange_explicit(&dr->pending, true, memory_order_acquire)) {
+        dr->coalesced++;
+        return;
+    }
+    dr->stamp = rtems_counter_read();
+    dr->wakeups++;
     rtems_interrupt_server_request_submit(&dr->req);
 }
 
 int devm_request_threaded_irq(struct udevice *dev, unsigned int irq,
-                  rtems_interrupt_handler handler, 
+                  rtems_interrupt_handler handler,
                   rtems_interrupt_handler thread_fn,
                   unsigned long irqflags, const char *devname,
                   void *arg)
 {
     struct irq_devres *dr;
+    struct irq_server *srv;
     rtems_option flags;
     rtems_status_code sc;
     int cpu;
-    
+
     if (handler == NULL && thread_fn == NULL) {
         dev_err(dev, "Interrupt(%u) handler invalid\n", irq);
         return -EINVAL;
     }
-    
+
     cpu = IRQF_CPU_NR(irqflags);
-    if (cpu > rtems_scheduler_get_processor()) {
+    if (cpu >= rtems_scheduler_get_processor_maximum()) {
         dev_err(dev, "Interrupt(%d) cpu(%d) is invalid\n", irq, cpu);
         return -EINVAL;
     }
@@ -73,43 +242,52 @@ int devm_request_threaded_irq(struct udevice *dev, unsigned int irq,
         flags = RTEMS_INTERRUPT_SHARED;
     else
         flags = RTEMS_INTERRUPT_UNIQUE;
-        
-    rtems_interrupt_server_request_initialize(cpu, &dr->req,
-        thread_fn, arg);
-    if (handler) {
-        if (!thread_fn) {
-            sc = rtems_interrupt_handler_install(irq, devname,
-                flags, handler, arg);
-            if (sc != RTEMS_SUCCESSFUL) 
-                goto _free_dr;
-            dr->handler = handler;
-            dr->arg = arg;
-        } else {
-            sc = rtems_interrupt_handler_install(irq, devname,
-                flags, threaded_irq_wrappwer, dr);
-            if (sc != RTEMS_SUCCESSFUL) 
-                goto _free_dr;
-            dr->handler = threaded_irq_wrappwer;
-            dr->arg = dr;
-        }
+
+    dr->handler = handler;
+    dr->thread_fn = thread_fn;
+    dr->arg = arg;
+    dr->name = devname;
+    dr->irq = irq;
+    dr->cpu = cpu;
+    dr->lane = (irqflags & IRQF_THREAD_HIGH) ? IRQ_LANE_HIGH : IRQ_LANE_NORMAL;
+
+    if (!thread_fn) {
+        dr->isr = handler;
+        dr->isr_arg = arg;
     } else {
-        sc = rtems_interrupt_handler_install(irq, devname, flags,
-            (rtems_interrupt_handler)rtems_interrupt_server_request_submit, 
-            &dr->req);
-        if (sc != RTEMS_SUCCESSFUL)
-            goto _free_dr;
-        dr->handler = 
-            (rtems_interrupt_handler)rtems_interrupt_server_request_submit;
-        dr->arg = &dr->req;
+        rtems_mutex_lock(&irq_lock);
+        srv = irq_server_get(cpu, dr->lane);
+        rtems_mutex_unlock(&irq_lock);
+        if (srv == NULL) {
+            devres_free(dr);
+            dev_err(dev, "No interrupt thread for interrupt(%u)\n", irq);
+            return -ENOMEM;
+        }
+        rtems_interrupt_server_request_initialize(srv->index, &dr->req,
+            threaded_irq_thread, dr);
+        atomic_init(&dr->pending, false);
+        dr->isr = threaded_irq_wrapper;
+        dr->isr_arg = dr;
     }
 
-    dr->req.entry.vector = irq;
+    sc = rtems_interrupt_handler_install(irq, devname, flags,
+        dr->isr, dr->isr_arg);
+    if (sc != RTEMS_SUCCESSFUL)
+        goto _free_dr;
+
+    if (thread_fn) {
+        rtems_mutex_lock(&irq_lock);
+        list_add_tail(&dr->node, &irq_threads);
+        rtems_mutex_unlock(&irq_lock);
+    }
     devres_add(dev, dr);
     return 0;
-    
+
 _free_dr:
+    if (thread_fn)
+        rtems_interrupt_server_request_destroy(&dr->req);
     devres_free(dr);
-    dev_err(dev, "Install interrupt(%u) failed: %s\n", irq, 
+    dev_err(dev, "Install interrupt(%u) failed: %s\n", irq,
         rtems_status_text(sc));
     return rtems_status_code_to_errno(sc);
 }
@@ -118,25 +296,45 @@ void devm_free_irq(struct udevice *dev, unsigned int irq, void *arg)
 {
     struct irq_devres match_data;
 
-    match_data.req.action.arg = arg;
-    match_data.req.entry.vector = irq;
+    match_data.arg = arg;
+    match_data.irq = irq;
     devres_destroy(dev, devm_irq_release, devm_irq_match,
                  &match_data);
 }
 
-#if !defined(__rtems_libbsd__)
-static void irq_init(void)
+static void irq_hist_print(const char *what, const struct irq_hist *hist)
 {
-    rtems_status_code sc;
+    int n;
 
-    sc = rtems_interrupt_server_initialize(10, 4096,
-        RTEMS_PREEMPT | RTEMS_NO_ASR | RTEMS_NO_TIMESLICE,
-        RTEMS_LOCAL, NULL);
-    if (sc != RTEMS_SUCCESSFUL)
-        printk("***Error: %s()-> %s\n", __func__, rtems_status_text(sc));
+    printf("    %-8s", what);
+    for (n = 0; n < IRQ_HIST_BUCKETS; n++)
+        printf(" %u", hist->bucket[n]);
+    printf("\n");
 }
 
-RTEMS_SYSINIT_ITEM(irq_init,
-    RTEMS_SYSINIT_CLASSIC_USER_TASKS,
-    RTEMS_SYSINIT_ORDER_MIDDLE);
-#endif /* !__rtems_libbsd__ */
+void dm_dump_irq_threads(bool histogram)
+{
+    struct irq_devres *dr;
+
+    printf("IRQ   CPU Lane  Wakeups  Coalesced  Latency(us) p50/p99/max"
+        "  Run(us) p99/max  Name\n");
+    rtems_mutex_lock(&irq_lock);
+    list_for_each_entry(dr, &irq_threads, node) {
+        printf("%-5u %3u %-4s %8u %10u  %6u/%6u/%6u  %7u/%6u  %s\n",
+            dr->irq, dr->cpu, dr->lane == IRQ_LANE_HIGH ? "high" : "norm",
+            dr->wakeups, dr->coalesced,
+            irq_hist_percentile(&dr->latency, 500),
+            irq_hist_percentile(&dr->latency, 990),
+            dr->latency.max_us,
+            irq_hist_percentile(&dr->runtime, 990),
+            dr->runtime.max_us, dr->name);
+        if (histogram) {
+            irq_hist_print("latency", &dr->latency);
+            irq_hist_print("runtime", &dr->runtime);
+        }
+    }
+    rtems_mutex_unlock(&irq_lock);
+    if (histogram)
+        printf("\nBucket 0 counts spans under 1us, bucket n spans of "
+            "[2^(n-1), 2^n) us\n");
+}
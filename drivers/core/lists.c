@@ -8,6 +8,9 @@
 
 #define LOG_CATEGORY LOGC_DM
 
+#include <stdlib.h>
+#include <rtems/malloc.h>
+
 #include <common.h>
 #include <errno.h>
 #include <log.h>
@@ -23,12 +26,181 @@
 
 #pragma GCC optimize(1) //TODO: remove it later
 
+/**
+ * struct lists_entry - One slot of a driver lookup hash table
+ *
+ * @key: Driver name or compatible string, NULL if the slot is free
+ * @hash: Hash value of @key
+ * @drv: Driver providing @key
+ * @of_id: Matching entry in the driver's of_match table (compatible index
+ *	only)
+ */
+struct lists_entry {
+	const char *key;
+	u32 hash;
+	struct driver *drv;
+	const struct udevice_id *of_id;
+};
+
+/**
+ * struct lists_index - Lookup tables built once from the linker lists
+ *
+ * Drivers, compatible strings and uclass drivers never change at run time, so
+ * they are indexed once by lists_init() and then looked up without walking
+ * the linker lists again.
+ *
+ * @names: Open-addressed hash table of driver names
+ * @name_mask: Number of slots in @names minus one
+ * @compats: Open-addressed hash table of compatible strings
+ * @compat_mask: Number of slots in @compats minus one
+ * @uclasses: uclass drivers indexed by uclass ID
+ * @valid: true once the tables have been built
+ */
+struct lists_index {
+	struct lists_entry *names;
+	uint name_mask;
+	struct lists_entry *compats;
+	uint compat_mask;
+	struct uclass_driver *uclasses[UCLASS_COUNT];
+	bool valid;
+};
+
+static struct lists_index lists_idx;
+
+/* FNV-1a, which is cheap and spreads short strings well enough */
+static u32 lists_hash(const char *str)
+{
+	u32 hash = 2166136261u;
+
+	while (*str) {
+		hash ^= (u8)*str++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static uint lists_table_size(uint n_ents)
+{
+	uint size = 16;
+
+	/* Keep the load factor below one half */
+	while (size < n_ents * 2)
+		size <<= 1;
+
+	return size;
+}
+
+static struct lists_entry *lists_index_find(struct lists_entry *table,
+					     uint mask, const char *key)
+{
+	u32 hash = lists_hash(key);
+	uint i;
+
+	for (i = hash & mask; table[i].key; i = (i + 1) & mask) {
+		if (table[i].hash == hash && !strcmp(table[i].key, key))
+			return &table[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Insert an entry unless the key is already present. The first driver in
+ * linker-list order wins, which matches the behaviour of a linear search.
+ */
+static void lists_index_add(struct lists_entry *table, uint mask,
+			    const char *key, struct driver *drv,
+			    const struct udevice_id *of_id)
+{
+	u32 hash = lists_hash(key);
+	uint i;
+
+	for (i = hash & mask; table[i].key; i = (i + 1) & mask) {
+		if (table[i].hash == hash && !strcmp(table[i].key, key))
+			return;
+	}
+	table[i].key = key;
+	table[i].hash = hash;
+	table[i].drv = drv;
+	table[i].of_id = of_id;
+}
+
+int lists_init(void)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct uclass_driver *uclass =
+		ll_entry_start(struct uclass_driver, uclass_driver);
+	const int n_uc_ents = ll_entry_count(struct uclass_driver,
+					     uclass_driver);
+	struct lists_index *idx = &lists_idx;
+	const struct udevice_id *of_id;
+	struct uclass_driver *uc_entry;
+	struct driver *entry;
+	uint n_compats = 0;
+	uint size;
+
+	if (idx->valid)
+		return 0;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++)
+			n_compats++;
+	}
+
+	size = lists_table_size(n_ents);
+	idx->names = rtems_calloc(size, sizeof(struct lists_entry));
+	if (!idx->names)
+		return -ENOMEM;
+	idx->name_mask = size - 1;
+
+	size = lists_table_size(n_compats);
+	idx->compats = rtems_calloc(size, sizeof(struct lists_entry));
+	if (!idx->compats) {
+		free(idx->names);
+		idx->names = NULL;
+		return -ENOMEM;
+	}
+	idx->compat_mask = size - 1;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		lists_index_add(idx->names, idx->name_mask, entry->name, entry,
+				NULL);
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++)
+			lists_index_add(idx->compats, idx->compat_mask,
+					of_id->compatible, entry, of_id);
+	}
+
+	/* Walk backwards so that the first uclass driver for an ID wins */
+	for (uc_entry = uclass + n_uc_ents; uc_entry != uclass;) {
+		uc_entry--;
+		if (uc_entry->id >= 0 && uc_entry->id < UCLASS_COUNT)
+			idx->uclasses[uc_entry->id] = uc_entry;
+	}
+	idx->valid = true;
+	log_debug("indexed %d drivers, %u compatible strings\n", n_ents,
+		  n_compats);
+
+	return 0;
+}
+
 struct driver *lists_driver_lookup_name(const char *name)
 {
 	struct driver *drv = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
 	struct driver *entry;
 
+	if (lists_idx.valid) {
+		struct lists_entry *ent;
+
+		ent = lists_index_find(lists_idx.names, lists_idx.name_mask,
+				       name);
+		return ent ? ent->drv : NULL;
+	}
+
 	for (entry = drv; entry != drv + n_ents; entry++) {
 		if (!strcmp(name, entry->name))
 			return entry;
@@ -45,6 +217,12 @@ struct uclass_driver *lists_uclass_lookup(enum uclass_id id)
 	const int n_ents = ll_entry_count(struct uclass_driver, uclass_driver);
 	struct uclass_driver *entry;
 
+	if (lists_idx.valid) {
+		if (id < 0 || id >= UCLASS_COUNT)
+			return NULL;
+		return lists_idx.uclasses[id];
+	}
+
 	for (entry = uclass; entry != uclass + n_ents; entry++) {
 		if (entry->id == id)
 			return entry;
@@ -183,11 +361,46 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   bool pre_reloc_only)
+/**
+ * lists_find_compatible() - Find the driver matching a compatible string
+ *
+ * @compat:	The compatible string to search for
+ * @drvp:	Returns the first driver (in linker-list order) that matches
+ * @of_idp:	Returns the matching entry in the driver's of_match table
+ * @return 0 if there is a match, -ENOENT if no match
+ */
+static int lists_find_compatible(const char *compat, struct driver **drvp,
+				 const struct udevice_id **of_idp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+	if (lists_idx.valid) {
+		struct lists_entry *ent;
+
+		ent = lists_index_find(lists_idx.compats,
+				       lists_idx.compat_mask, compat);
+		if (!ent)
+			return -ENOENT;
+		*drvp = ent->drv;
+		*of_idp = ent->of_id;
+		return 0;
+	}
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat)) {
+			*drvp = entry;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -224,13 +437,8 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		log_debug("   - attempt to match compatible string '%s'\n",
 			  compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		ret = lists_find_compatible(compat, &entry, &id);
+		if (ret)
 			continue;
 
 		if (pre_reloc_only) {
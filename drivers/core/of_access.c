@@ -52,6 +52,16 @@ static const char *of_stdout_options;
 
 static rtems_mutex of_mutex = RTEMS_MUTEX_INITIALIZER("of-mutex");
 
+/* phandle -> node table, indexed by phandle (NULL if not built) */
+static struct device_node **of_phandle_table;
+
+/* highest phandle covered by of_phandle_table */
+static phandle of_phandle_max;
+
+/* Interned property names, open addressing (NULL if not set up) */
+static const char **of_name_table;
+static uint of_name_mask;
+
 /**
  * struct alias_prop - Alias property in 'aliases' node
  *
@@ -128,6 +138,84 @@ int of_simple_size_cells(const struct device_node *np)
 	return 2;
 }
 
+static uint of_name_hash(const char *name)
+{
+	uint hash = 2166136261u;
+
+	while (*name)
+		hash = (hash ^ (u8)*name++) * 16777619u;
+
+	return hash;
+}
+
+void of_name_table_init(const char **table, uint size)
+{
+	of_name_table = table;
+	of_name_mask = size - 1;
+}
+
+static const char *of_name_lookup(const char *name, bool insert)
+{
+	uint i, n;
+
+	if (!of_name_table)
+		return NULL;
+
+	i = of_name_hash(name) & of_name_mask;
+	for (n = 0; n <= of_name_mask; n++) {
+		if (!of_name_table[i]) {
+			if (!insert)
+				return NULL;
+			of_name_table[i] = name;
+			return name;
+		}
+		if (!strcmp(of_name_table[i], name))
+			return of_name_table[i];
+		i = (i + 1) & of_name_mask;
+	}
+
+	return NULL;
+}
+
+const char *of_name_intern(const char *name)
+{
+	return of_name_lookup(name, true);
+}
+
+const char *of_name_find(const char *name)
+{
+	return of_name_lookup(name, false);
+}
+
+/* Binary search of the node's sorted index, comparing interned pointers */
+static struct property *of_find_sorted_property(const struct device_node *np,
+						const char *name)
+{
+	struct property *pp;
+	uintptr_t key;
+	int lo, hi, mid;
+
+	/* A name nobody interned is not a property of any node */
+	key = (uintptr_t)of_name_find(name);
+	if (!key)
+		return NULL;
+
+	lo = 0;
+	hi = np->prop_count;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		pp = &np->properties[np->prop_order[mid]];
+		if ((uintptr_t)pp->name == key)
+			return pp;
+		if ((uintptr_t)pp->name < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
 struct property *of_find_property(const struct device_node *np,
 				  const char *name, int *lenp)
 {
@@ -136,12 +224,20 @@ struct property *of_find_property(const struct device_node *np,
 	if (!np)
 		return NULL;
 
-	for (pp = np->properties; pp; pp = pp->next) {
-		if (strcmp(pp->name, name) == 0) {
-			if (lenp)
-				*lenp = pp->length;
-			break;
+	if (np->prop_order) {
+		pp = of_find_sorted_property(np, name);
+		if (pp && lenp)
+			*lenp = pp->length;
+	} else {
+		for (pp = np->properties; pp < np->properties + np->prop_count;
+		     pp++) {
+			if (strcmp(pp->name, name) == 0)
+				break;
 		}
+		if (pp == np->properties + np->prop_count)
+			pp = NULL;
+		else if (lenp)
+			*lenp = pp->length;
 	}
 	if (!pp && lenp)
 		*lenp = -FDT_ERR_NOTFOUND;
@@ -190,10 +286,12 @@ const struct property *of_get_first_property(const struct device_node *np)
 const struct property *of_get_next_property(const struct device_node *np,
 					    const struct property *property)
 {
-	if (!np)
+	if (!np || !property)
 		return NULL;
 
-	return property->next;
+	property++;
+
+	return property < np->properties + np->prop_count ? property : NULL;
 }
 
 const void *of_get_property_by_prop(const struct device_node *np,
@@ -346,7 +444,7 @@ static struct device_node *__of_find_node_by_path(struct device_node *parent,
 }
 
 #define for_each_property_of_node(dn, pp) \
-	for (pp = dn->properties; pp != NULL; pp = pp->next)
+	for (pp = dn->properties; pp < dn->properties + dn->prop_count; pp++)
 
 struct device_node *of_find_node_opts_by_path(const char *path,
 					      const char **opts)
@@ -444,6 +542,47 @@ struct device_node *of_find_node_by_prop_value(struct device_node *from,
 	return np;
 }
 
+int of_build_phandle_table(struct device_node *root)
+{
+	struct device_node **table;
+	struct device_node *np;
+	phandle max = 0;
+	uint count = 0;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle > max)
+			max = np->phandle;
+		count++;
+	}
+	if (!max)
+		return 0;
+
+	/*
+	 * dtc hands out phandles densely from 1, so the table is normally no
+	 * bigger than the node count. Don't waste memory on a sparse tree.
+	 */
+	if (max > count * 2) {
+		debug("%s: phandles too sparse (max %u, %u nodes)\n", __func__,
+		      max, count);
+		return -E2BIG;
+	}
+
+	table = rtems_calloc(max + 1, sizeof(*table));
+	if (!table)
+		return -ENOMEM;
+
+	/* Keep the first node for a duplicated phandle, as the walk does */
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle && !table[np->phandle])
+			table[np->phandle] = np;
+	}
+	of_phandle_max = max;
+	of_phandle_table = table;
+	debug("%s: %u phandles, %u nodes\n", __func__, max, count);
+
+	return 0;
+}
+
 struct device_node *of_find_node_by_phandle(phandle handle)
 {
 	struct device_node *np;
@@ -451,6 +590,10 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	if (!handle)
 		return NULL;
 
+	/* The table covers every node, so a miss below the limit is final */
+	if (of_phandle_table && handle <= of_phandle_max)
+		return of_node_get(of_phandle_table[handle]);
+
 	for_each_of_allnodes(np)
 		if (np->phandle == handle)
 			break;
@@ -82,6 +82,24 @@ static int of_irq_translate(const struct of_phandle_args *ofirq,
     return of_default_irq_translate(ofirq, irq, type);
 }
 
+int of_irq_translate_cells(const uint32_t *cells, int count,
+			   unsigned int *irq, unsigned int *type)
+{
+	const struct of_irq_ops *ops = OF_IRQ_START();
+	struct of_phandle_args oirq;
+	int i;
+
+	if (ops == OF_IRQ_END() || count > OF_MAX_PHANDLE_ARGS)
+		return -EINVAL;
+
+	oirq.np = NULL;
+	oirq.args_count = count;
+	for (i = 0; i < count; i++)
+		oirq.args[i] = cells[i];
+
+	return ops->translate(&oirq, irq, type);
+}
+
 static struct device_node *of_irq_find_parent(struct device_node *child)
 {
 	struct device_node *p;
@@ -10,6 +10,7 @@
 #include <fdt_support.h>
 #include <log.h>
 #include <rtems/malloc.h>
+#include <rtems/thread.h>
 #include <linux/libfdt.h>
 #include <dm/of_access.h>
 #include <dm/of_addr.h>
@@ -286,6 +287,88 @@ const char *ofnode_get_name(ofnode node)
 	return fdt_get_name(dm_fdt_blob(), ofnode_to_offset(node), NULL);
 }
 
+/*
+ * phandle -> node offset cache for the flat tree. Offsets move when the blob
+ * is edited, so each hit is checked against the node's phandle before use.
+ */
+static int *ofnode_phandle_offsets;
+static uint ofnode_phandle_max;
+/* Set once the cache has been built or found not worth building */
+static bool ofnode_phandle_scanned;
+static rtems_mutex ofnode_phandle_mutex =
+	RTEMS_MUTEX_INITIALIZER("ofnode-phandle");
+
+static void ofnode_build_phandle_cache(const void *blob)
+{
+	uint max = 0;
+	uint count = 0;
+	int *offsets;
+	int offset;
+	uint i;
+
+	for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		uint phandle = fdt_get_phandle(blob, offset);
+
+		if (phandle > max)
+			max = phandle;
+		count++;
+	}
+	if (!max)
+		return;
+
+	/* As of_build_phandle_table(): a sparse tree keeps the linear lookup */
+	if (max > count * 2) {
+		debug("%s: phandles too sparse (max %u, %u nodes)\n", __func__,
+		      max, count);
+		return;
+	}
+
+	offsets = rtems_calloc(max + 1, sizeof(*offsets));
+	if (!offsets)
+		return;
+	for (i = 0; i <= max; i++)
+		offsets[i] = -FDT_ERR_NOTFOUND;
+	for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		uint phandle = fdt_get_phandle(blob, offset);
+
+		if (phandle && offsets[phandle] < 0)
+			offsets[phandle] = offset;
+	}
+	ofnode_phandle_max = max;
+	ofnode_phandle_offsets = offsets;
+}
+
+static int ofnode_flat_find_phandle(uint phandle)
+{
+	const void *blob = dm_fdt_blob();
+	int offset;
+
+	if (!ofnode_phandle_scanned) {
+		rtems_mutex_lock(&ofnode_phandle_mutex);
+		if (!ofnode_phandle_scanned) {
+			ofnode_build_phandle_cache(blob);
+			ofnode_phandle_scanned = true;
+		}
+		rtems_mutex_unlock(&ofnode_phandle_mutex);
+	}
+
+	if (ofnode_phandle_offsets && phandle && phandle <= ofnode_phandle_max) {
+		offset = ofnode_phandle_offsets[phandle];
+		if (offset >= 0 && fdt_get_phandle(blob, offset) == phandle)
+			return offset;
+	}
+
+	/* Not cached, or the blob has changed since the cache was built */
+	offset = fdt_node_offset_by_phandle(blob, phandle);
+	if (offset >= 0 && ofnode_phandle_offsets &&
+	    phandle <= ofnode_phandle_max)
+		ofnode_phandle_offsets[phandle] = offset;
+
+	return offset;
+}
+
 ofnode ofnode_get_by_phandle(uint phandle)
 {
 	ofnode node;
@@ -293,8 +376,7 @@ ofnode ofnode_get_by_phandle(uint phandle)
 	if (of_live_active())
 		node = np_to_ofnode(of_find_node_by_phandle(phandle));
 	else
-		node.of_offset = fdt_node_offset_by_phandle(dm_fdt_blob(),
-							    phandle);
+		node.of_offset = ofnode_flat_find_phandle(phandle);
 
 	return node;
 }
@@ -984,9 +1066,8 @@ ofnode ofnode_by_prop_value(ofnode from, const char *propname,
 int ofnode_write_prop(ofnode node, const char *propname, int len,
 		      const void *value)
 {
-	const struct device_node *np = ofnode_to_np(node);
+	struct device_node *np = (struct device_node *)ofnode_to_np(node);
 	struct property *pp;
-	struct property *pp_last = NULL;
 	struct property *new;
 
 	if (!of_live_active())
@@ -995,35 +1076,40 @@ int ofnode_write_prop(ofnode node, const char *propname, int len,
 	if (!np)
 		return -EINVAL;
 
-	for (pp = np->properties; pp; pp = pp->next) {
-		if (strcmp(pp->name, propname) == 0) {
-			/* Property exists -> change value */
-			pp->value = (void *)value;
-			pp->length = len;
-			return 0;
-		}
-		pp_last = pp;
+	pp = of_find_property(np, propname, NULL);
+	if (pp) {
+		/* Property exists -> change value */
+		pp->value = (void *)value;
+		pp->length = len;
+		return 0;
 	}
 
-	if (!pp_last)
+	if (!np->prop_count)
 		return -ENOENT;
 
-	/* Property does not exist -> append new property */
-	new = rtems_malloc(sizeof(struct property));
+	/*
+	 * Property does not exist -> append new property. The properties are
+	 * an array, so copy it one entry larger. The old array is left alone,
+	 * as callers may still hold pointers into it.
+	 */
+	new = rtems_malloc((np->prop_count + 1) * sizeof(struct property));
 	if (!new)
 		return -ENOMEM;
 
-	new->name = strdup(propname);
-	if (!new->name) {
+	pp = &new[np->prop_count];
+	pp->name = strdup(propname);
+	if (!pp->name) {
 		free(new);
 		return -ENOMEM;
 	}
-
-	new->value = (void *)value;
-	new->length = len;
-	new->next = NULL;
-
-	pp_last->next = new;
+	pp->value = (void *)value;
+	pp->length = len;
+	memcpy(new, np->properties, np->prop_count * sizeof(struct property));
+
+	/* The sorted index does not cover the new property, search linearly */
+	np->prop_order = NULL;
+	np->properties = new;
+	np->prop_count++;
 
 	return 0;
 }
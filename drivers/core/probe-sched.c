@@ -0,0 +1,658 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Dependency-ordered device probing
+ *
+ * All bound devices are put into a graph whose edges are the parent link and
+ * the phandle references a device makes to its suppliers (clocks, resets,
+ * pinctrl, GPIOs and the interrupt parent). A device is probed only once all
+ * of its suppliers have been probed. With CONFIG_DM_PROBE_PARALLEL on an SMP
+ * system, devices which are ready at the same time are probed by a small pool
+ * of worker tasks, so slow probes on independent subtrees overlap.
+ *
+ * Workers share the driver model's lists and arrays through dm_core_lock(),
+ * which covers binding, uclass membership and lookups, devres and the claim
+ * of a device for probing. Parallel probing still relies on the device tree
+ * describing the suppliers: a driver which looks up an undeclared supplier
+ * from its probe() method never probes it twice, but may be handed it while
+ * a worker is still inside the supplier's probe().
+ *
+ * Devices flagged DM_FLAG_PROBE_LAZY are skipped and left for their first
+ * user to probe.
+ */
+
+#define LOG_CATEGORY LOGC_DM
+
+#include <rtems.h>
+#include <rtems/malloc.h>
+#include <rtems/thread.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <common.h>
+#include <log.h>
+#include <dm/device.h>
+#include <dm/device-internal.h>
+#include <dm/ofnode.h>
+#include <dm/root.h>
+#include <dm/uclass.h>
+#include <dm/util.h>
+#include <linux/ctype.h>
+#include <linux/list.h>
+
+/* Maximum number of tasks (including the caller) probing at once */
+#ifndef CONFIG_DM_PROBE_WORKERS
+#define CONFIG_DM_PROBE_WORKERS		4
+#endif
+
+#ifndef CONFIG_DM_PROBE_STACK_SIZE
+#define CONFIG_DM_PROBE_STACK_SIZE	8192
+#endif
+
+#define DM_PROBE_NAME_LEN		32
+
+/**
+ * struct dm_probe_node - A device in the probe dependency graph
+ *
+ * @dev: Device to probe
+ * @pending: Number of suppliers not yet probed
+ * @first: Index of the first consumer in dm_probe_sched.consumers
+ * @count: Number of consumers
+ * @done: true once the device has been probed (successfully or not)
+ */
+struct dm_probe_node {
+	struct udevice *dev;
+	int pending;
+	int first;
+	int count;
+	bool done;
+};
+
+/**
+ * struct dm_probe_edge - A supplier -> consumer dependency
+ *
+ * @supplier: Index of the supplier node
+ * @consumer: Index of the consumer node
+ */
+struct dm_probe_edge {
+	int supplier;
+	int consumer;
+};
+
+/**
+ * struct dm_probe_stat - Probe result for one device
+ *
+ * @name: Device name (copied, the device may be unbound later)
+ * @drv: Driver name
+ * @time_ns: Time spent in device_probe()
+ * @ret: Value returned by device_probe()
+ */
+struct dm_probe_stat {
+	char name[DM_PROBE_NAME_LEN];
+	const char *drv;
+	u64 time_ns;
+	int ret;
+};
+
+/**
+ * struct dm_probe_sched - State of the probe scheduler
+ *
+ * @nodes: All devices in the graph, in device-tree order
+ * @n_nodes: Number of entries in @nodes
+ * @hash: Open-addressed ofnode -> node index + 1 table
+ * @hash_mask: Number of slots in @hash minus one
+ * @edges: Dependencies collected while building the graph
+ * @n_edges: Number of entries in @edges
+ * @consumers: Consumer node indices, grouped by supplier
+ * @ready: FIFO of nodes whose suppliers have all been probed
+ * @head: Next entry to take from @ready
+ * @tail: Next free entry in @ready
+ * @running: Number of probes in progress
+ * @workers: Number of worker tasks still running
+ * @lock: Protects the scheduling state and the statistics
+ * @cond: Signalled when a node becomes ready or a worker exits
+ */
+struct dm_probe_sched {
+	struct dm_probe_node *nodes;
+	int n_nodes;
+	int *hash;
+	uint hash_mask;
+	struct dm_probe_edge *edges;
+	int n_edges;
+	int *consumers;
+	int *ready;
+	int head;
+	int tail;
+	int running;
+	int workers;
+	rtems_mutex lock;
+	rtems_condition_variable cond;
+};
+
+static struct dm_probe_sched dm_probe_sched = {
+	.lock = RTEMS_MUTEX_INITIALIZER("dm-probe"),
+	.cond = RTEMS_CONDITION_VARIABLE_INITIALIZER("dm-probe"),
+};
+
+static struct dm_probe_stat *dm_probe_stats;
+static int dm_probe_stats_count;
+static int dm_probe_stats_size;
+static u64 dm_probe_elapsed_ns;
+static int dm_probe_tasks;
+
+static uint dm_probe_hash(ofnode node)
+{
+	return ((ulong)node.of_offset >> 2) * 2654435761u;
+}
+
+static void dm_probe_hash_add(struct dm_probe_sched *ps, ofnode node, int idx)
+{
+	uint i;
+
+	for (i = dm_probe_hash(node) & ps->hash_mask; ps->hash[i];
+	     i = (i + 1) & ps->hash_mask)
+		;
+	ps->hash[i] = idx + 1;
+}
+
+static int dm_probe_hash_find(struct dm_probe_sched *ps, ofnode node)
+{
+	uint i;
+
+	for (i = dm_probe_hash(node) & ps->hash_mask; ps->hash[i];
+	     i = (i + 1) & ps->hash_mask) {
+		int idx = ps->hash[i] - 1;
+
+		if (ofnode_equal(dev_ofnode(ps->nodes[idx].dev), node))
+			return idx;
+	}
+
+	return -1;
+}
+
+/* Find the device owning a node, or the nearest ancestor that has one */
+static int dm_probe_find_owner(struct dm_probe_sched *ps, ofnode node)
+{
+	int idx;
+
+	while (ofnode_valid(node)) {
+		idx = dm_probe_hash_find(ps, node);
+		if (idx >= 0)
+			return idx;
+		node = ofnode_get_parent(node);
+	}
+
+	return -1;
+}
+
+static int dm_probe_add_edge(struct dm_probe_sched *ps, int supplier,
+			     int consumer)
+{
+	struct dm_probe_edge *edges;
+
+	if (supplier < 0 || supplier == consumer)
+		return 0;
+
+	/* Grow in steps of 64 edges */
+	if (!(ps->n_edges & 63)) {
+		edges = realloc(ps->edges,
+				(ps->n_edges + 64) * sizeof(*edges));
+		if (!edges)
+			return -ENOMEM;
+		ps->edges = edges;
+	}
+	ps->edges[ps->n_edges].supplier = supplier;
+	ps->edges[ps->n_edges].consumer = consumer;
+	ps->n_edges++;
+
+	return 0;
+}
+
+/*
+ * Check whether a property holds supplier phandles and return the name of
+ * the property giving the number of argument cells (NULL for none)
+ */
+static bool dm_probe_dep_prop(const char *name, const char **cellsp)
+{
+	static const struct {
+		const char *name;
+		const char *cells;
+	} props[] = {
+		{ "clocks", "#clock-cells" },
+		{ "assigned-clocks", "#clock-cells" },
+		{ "resets", "#reset-cells" },
+		{ "interrupt-parent", NULL },
+	};
+	size_t len;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(props); i++) {
+		if (!strcmp(name, props[i].name)) {
+			*cellsp = props[i].cells;
+			return true;
+		}
+	}
+
+	/* pinctrl-0, pinctrl-1, ... each list pin configuration nodes */
+	if (!strncmp(name, "pinctrl-", 8) && isdigit(name[8])) {
+		*cellsp = NULL;
+		return true;
+	}
+
+	/* gpios, foo-gpios and the deprecated foo-gpio, but not ngpios */
+	len = strlen(name);
+	if ((!strcmp(name, "gpios") ||
+	     (len > 6 && !strcmp(name + len - 6, "-gpios")) ||
+	     (len > 5 && !strcmp(name + len - 5, "-gpio")))) {
+		*cellsp = "#gpio-cells";
+		return true;
+	}
+
+	return false;
+}
+
+static int dm_probe_add_refs(struct dm_probe_sched *ps, int idx)
+{
+	ofnode node = dev_ofnode(ps->nodes[idx].dev);
+	struct ofnode_phandle_args args;
+	const char *name, *cells;
+	struct ofprop prop;
+	int count, i, ret;
+
+	if (!ofnode_valid(node))
+		return 0;
+
+	for (ret = ofnode_get_first_property(node, &prop); !ret;
+	     ret = ofnode_get_next_property(&prop)) {
+		if (!ofnode_get_property_by_prop(&prop, &name, NULL))
+			continue;
+		if (!dm_probe_dep_prop(name, &cells))
+			continue;
+
+		count = ofnode_count_phandle_with_args(node, name, cells, 0);
+		for (i = 0; i < count; i++) {
+			if (ofnode_parse_phandle_with_args(node, name, cells, 0,
+							   i, &args))
+				continue;
+			ret = dm_probe_add_edge(ps,
+					dm_probe_find_owner(ps, args.node),
+					idx);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+static int dm_probe_count(struct udevice *dev)
+{
+	struct udevice *child;
+	int count = 0;
+
+	list_for_each_entry(child, &dev->child_head, sibling_node)
+		count += 1 + dm_probe_count(child);
+
+	return count;
+}
+
+static void dm_probe_collect(struct dm_probe_sched *ps, struct udevice *dev)
+{
+	struct udevice *child;
+
+	list_for_each_entry(child, &dev->child_head, sibling_node) {
+		ps->nodes[ps->n_nodes++].dev = child;
+		dm_probe_collect(ps, child);
+	}
+}
+
+/* Index of a device's parent in the graph, -1 for children of the root */
+static int dm_probe_parent(struct dm_probe_sched *ps, int idx)
+{
+	struct udevice *parent = ps->nodes[idx].dev->parent;
+	int i;
+
+	if (dev_has_ofnode(parent)) {
+		i = dm_probe_hash_find(ps, dev_ofnode(parent));
+		if (i >= 0 && ps->nodes[i].dev == parent)
+			return i;
+	}
+
+	/* Parents are collected before their children, so look backwards */
+	for (i = idx - 1; i >= 0; i--) {
+		if (ps->nodes[i].dev == parent)
+			return i;
+	}
+
+	return -1;
+}
+
+static int dm_probe_build(struct dm_probe_sched *ps, struct udevice *root)
+{
+	uint size = 16;
+	int *fill;
+	int i, ret;
+
+	ps->n_nodes = 0;
+	ps->n_edges = 0;
+	ps->nodes = rtems_calloc(dm_probe_count(root) + 1,
+				 sizeof(struct dm_probe_node));
+	if (!ps->nodes)
+		return -ENOMEM;
+	dm_probe_collect(ps, root);
+
+	while (size < ps->n_nodes * 2)
+		size <<= 1;
+	ps->hash = rtems_calloc(size, sizeof(int));
+	ps->ready = rtems_calloc(ps->n_nodes + 1, sizeof(int));
+	if (!ps->hash || !ps->ready)
+		return -ENOMEM;
+	ps->hash_mask = size - 1;
+	for (i = 0; i < ps->n_nodes; i++) {
+		if (dev_has_ofnode(ps->nodes[i].dev))
+			dm_probe_hash_add(ps, dev_ofnode(ps->nodes[i].dev), i);
+	}
+
+	for (i = 0; i < ps->n_nodes; i++) {
+		ret = dm_probe_add_edge(ps, dm_probe_parent(ps, i), i);
+		if (ret)
+			return ret;
+		ret = dm_probe_add_refs(ps, i);
+		if (ret)
+			return ret;
+	}
+
+	/* Group the consumers of each supplier together */
+	ps->consumers = rtems_calloc(ps->n_edges + 1, sizeof(int));
+	fill = rtems_calloc(ps->n_nodes + 1, sizeof(int));
+	if (!ps->consumers || !fill) {
+		free(fill);
+		return -ENOMEM;
+	}
+	for (i = 0; i < ps->n_edges; i++) {
+		ps->nodes[ps->edges[i].supplier].count++;
+		ps->nodes[ps->edges[i].consumer].pending++;
+	}
+	for (i = 1; i < ps->n_nodes; i++)
+		ps->nodes[i].first = ps->nodes[i - 1].first +
+				     ps->nodes[i - 1].count;
+	for (i = 0; i < ps->n_edges; i++) {
+		struct dm_probe_node *sup = &ps->nodes[ps->edges[i].supplier];
+
+		ps->consumers[sup->first + fill[ps->edges[i].supplier]++] =
+			ps->edges[i].consumer;
+	}
+	free(fill);
+
+	ps->head = 0;
+	ps->tail = 0;
+	for (i = 0; i < ps->n_nodes; i++) {
+		if (!ps->nodes[i].pending)
+			ps->ready[ps->tail++] = i;
+	}
+	log_debug("probe graph: %d devices, %d dependencies\n", ps->n_nodes,
+		  ps->n_edges);
+
+	return 0;
+}
+
+static void dm_probe_free(struct dm_probe_sched *ps)
+{
+	free(ps->nodes);
+	free(ps->hash);
+	free(ps->edges);
+	free(ps->consumers);
+	free(ps->ready);
+	ps->nodes = NULL;
+	ps->hash = NULL;
+	ps->edges = NULL;
+	ps->consumers = NULL;
+	ps->ready = NULL;
+}
+
+/* Must be called with the scheduler lock held, if the scheduler is running */
+static void dm_probe_record(struct udevice *dev, u64 time_ns, int ret)
+{
+	struct dm_probe_stat *stat;
+
+	if (dm_probe_stats_count == dm_probe_stats_size) {
+		stat = realloc(dm_probe_stats, (dm_probe_stats_size + 32) *
+			       sizeof(*stat));
+		if (!stat)
+			return;
+		dm_probe_stats = stat;
+		dm_probe_stats_size += 32;
+	}
+	stat = &dm_probe_stats[dm_probe_stats_count++];
+	strlcpy(stat->name, dev->name, sizeof(stat->name));
+	stat->drv = dev->driver->name;
+	stat->time_ns = time_ns;
+	stat->ret = ret;
+}
+
+static int dm_probe_timed(struct udevice *dev, u64 *time_ns)
+{
+	u64 start = rtems_clock_get_uptime_nanoseconds();
+	int ret;
+
+	ret = device_probe(dev);
+	*time_ns = rtems_clock_get_uptime_nanoseconds() - start;
+	if (ret)
+		log_debug("%s: probe failed: %d\n", dev->name, ret);
+
+	return ret;
+}
+
+/* Probe ready devices until nothing more can make progress */
+static void dm_probe_run(struct dm_probe_sched *ps)
+{
+	struct dm_probe_node *node;
+	u64 time_ns;
+	int idx, i, ret;
+	bool lazy;
+
+	rtems_mutex_lock(&ps->lock);
+	for (;;) {
+		if (ps->head == ps->tail) {
+			if (!ps->running)
+				break;
+			rtems_condition_variable_wait(&ps->cond, &ps->lock);
+			continue;
+		}
+
+		idx = ps->ready[ps->head++];
+		node = &ps->nodes[idx];
+		ps->running++;
+		rtems_mutex_unlock(&ps->lock);
+
+		/* A lazy supplier is probed by whichever consumer needs it */
+		lazy = dev_get_flags(node->dev) & DM_FLAG_PROBE_LAZY;
+		ret = 0;
+		time_ns = 0;
+		if (!lazy)
+			ret = dm_probe_timed(node->dev, &time_ns);
+
+		rtems_mutex_lock(&ps->lock);
+		ps->running--;
+		node->done = true;
+		if (!lazy)
+			dm_probe_record(node->dev, time_ns, ret);
+
+		/* Consumers still try when a supplier fails */
+		for (i = node->first; i < node->first + node->count; i++) {
+			struct dm_probe_node *con = &ps->nodes[ps->consumers[i]];
+
+			if (!--con->pending)
+				ps->ready[ps->tail++] = ps->consumers[i];
+		}
+		rtems_condition_variable_broadcast(&ps->cond);
+	}
+	rtems_mutex_unlock(&ps->lock);
+}
+
+#if defined(RTEMS_SMP) && CONFIG_IS_ENABLED(DM_PROBE_PARALLEL)
+static rtems_task dm_probe_worker(rtems_task_argument arg)
+{
+	struct dm_probe_sched *ps = (struct dm_probe_sched *)arg;
+
+	dm_probe_run(ps);
+
+	rtems_mutex_lock(&ps->lock);
+	ps->workers--;
+	rtems_condition_variable_broadcast(&ps->cond);
+	rtems_mutex_unlock(&ps->lock);
+
+	rtems_task_exit();
+}
+
+static void dm_probe_start_workers(struct dm_probe_sched *ps)
+{
+	rtems_task_priority prio;
+	rtems_status_code sc;
+	uint32_t n_tasks;
+	rtems_id id;
+	int i;
+
+	n_tasks = min_t(uint32_t, rtems_scheduler_get_processor_maximum(),
+			CONFIG_DM_PROBE_WORKERS);
+	rtems_task_set_priority(RTEMS_SELF, RTEMS_CURRENT_PRIORITY, &prio);
+
+	for (i = 1; i < n_tasks; i++) {
+		sc = rtems_task_create(rtems_build_name('D', 'M', 'P', '0' + i),
+				       prio, CONFIG_DM_PROBE_STACK_SIZE,
+				       RTEMS_DEFAULT_MODES,
+				       RTEMS_FLOATING_POINT, &id);
+		if (sc != RTEMS_SUCCESSFUL) {
+			dm_warn("probe worker %d: %s\n", i,
+				rtems_status_text(sc));
+			break;
+		}
+
+		rtems_mutex_lock(&ps->lock);
+		ps->workers++;
+		rtems_mutex_unlock(&ps->lock);
+
+		sc = rtems_task_start(id, dm_probe_worker,
+				      (rtems_task_argument)ps);
+		if (sc != RTEMS_SUCCESSFUL) {
+			rtems_mutex_lock(&ps->lock);
+			ps->workers--;
+			rtems_mutex_unlock(&ps->lock);
+			rtems_task_delete(id);
+			break;
+		}
+	}
+	dm_probe_tasks = ps->workers + 1;
+}
+#else
+static void dm_probe_start_workers(struct dm_probe_sched *ps)
+{
+	dm_probe_tasks = 1;
+}
+#endif
+
+static int dm_probe_cmp_ptr(const void *a, const void *b)
+{
+	const struct udevice *da = *(struct udevice * const *)a;
+	const struct udevice *db = *(struct udevice * const *)b;
+
+	return da < db ? -1 : da > db;
+}
+
+/*
+ * Probe whatever the graph did not cover: devices caught in a dependency
+ * cycle and devices bound by another device's probe() method
+ */
+static void dm_probe_sweep(struct udevice *dev, struct udevice **seen,
+			   int n_seen)
+{
+	struct udevice *child;
+	u64 time_ns;
+	int ret;
+
+	list_for_each_entry(child, &dev->child_head, sibling_node) {
+		if (!(dev_get_flags(child) & DM_FLAG_PROBE_LAZY) &&
+		    !bsearch(&child, seen, n_seen, sizeof(*seen),
+			     dm_probe_cmp_ptr)) {
+			ret = dm_probe_timed(child, &time_ns);
+			dm_probe_record(child, time_ns, ret);
+		}
+		dm_probe_sweep(child, seen, n_seen);
+	}
+}
+
+int dm_probe_devices(struct udevice *root)
+{
+	struct dm_probe_sched *ps = &dm_probe_sched;
+	struct udevice **seen;
+	u64 start;
+	int n_seen = 0;
+	int i, ret;
+
+	start = rtems_clock_get_uptime_nanoseconds();
+	ret = dm_probe_build(ps, root);
+	if (ret) {
+		dm_warn("Cannot build probe graph: %d\n", ret);
+		dm_probe_free(ps);
+		dm_probe_tasks = 1;
+		dm_probe_sweep(root, NULL, 0);
+		goto out;
+	}
+
+	dm_probe_start_workers(ps);
+	dm_probe_run(ps);
+
+	/* Wait for the workers to finish their last probe and exit */
+	rtems_mutex_lock(&ps->lock);
+	while (ps->workers)
+		rtems_condition_variable_wait(&ps->cond, &ps->lock);
+	rtems_mutex_unlock(&ps->lock);
+
+	/* The scheduler only tracks done nodes, reuse its buffer */
+	seen = (struct udevice **)ps->ready;
+	for (i = 0; i < ps->n_nodes; i++) {
+		if (ps->nodes[i].done)
+			seen[n_seen++] = ps->nodes[i].dev;
+	}
+	qsort(seen, n_seen, sizeof(*seen), dm_probe_cmp_ptr);
+	dm_probe_sweep(root, seen, n_seen);
+	dm_probe_free(ps);
+out:
+	dm_probe_elapsed_ns = rtems_clock_get_uptime_nanoseconds() - start;
+
+	ret = device_defer_count();
+	if (ret)
+		log_info("%d device(s) still deferred, see 'dm -df'\n", ret);
+
+	return 0;
+}
+
+static int dm_probe_cmp_time(const void *a, const void *b)
+{
+	const struct dm_probe_stat *sa = a, *sb = b;
+
+	return sa->time_ns < sb->time_ns ? 1 : sa->time_ns > sb->time_ns ?
+		-1 : 0;
+}
+
+void dm_dump_probe_stats(void)
+{
+	u64 total = 0;
+	int i;
+
+	qsort(dm_probe_stats, dm_probe_stats_count, sizeof(*dm_probe_stats),
+	      dm_probe_cmp_time);
+
+	puts("Device                          Driver                  Time(us)  Ret\n");
+	puts("---------------------------------------------------------------------\n");
+	for (i = 0; i < dm_probe_stats_count; i++) {
+		struct dm_probe_stat *stat = &dm_probe_stats[i];
+
+		printf("%-31.31s %-22.22s %9lu  %d\n", stat->name, stat->drv,
+		       (ulong)(stat->time_ns / 1000), stat->ret);
+		total += stat->time_ns;
+	}
+	printf("\n%d devices, %lu us probing, %lu us elapsed, %d task(s)\n",
+	       dm_probe_stats_count, (ulong)(total / 1000),
+	       (ulong)(dm_probe_elapsed_ns / 1000), dm_probe_tasks);
+}
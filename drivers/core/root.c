@@ -8,6 +8,7 @@
 
 #include <rtems/malloc.h>
 #include <rtems/sysinit.h>
+#include <rtems/thread.h>
 
 #include <common.h>
 #include <errno.h>
@@ -25,6 +26,7 @@
 #include <dm/read.h>
 #include <dm/root.h>
 #include <dm/uclass.h>
+#include <dm/uclass-internal.h>
 #include <dm/util.h>
 #include <linux/list.h>
 
@@ -43,6 +45,24 @@ void *_dm_priv_base;
 struct driver_rt *_dm_driver_rt;
 #endif
 
+/*
+ * Serialises changes to the driver model's shared lists and arrays (uclass
+ * list, per-uclass device arrays, child lists, devres lists). Recursive, as
+ * a bind method may bind children.
+ */
+static rtems_recursive_mutex dm_core_mutex =
+	RTEMS_RECURSIVE_MUTEX_INITIALIZER("dm-core");
+
+void dm_core_lock(void)
+{
+	rtems_recursive_mutex_lock(&dm_core_mutex);
+}
+
+void dm_core_unlock(void)
+{
+	rtems_recursive_mutex_unlock(&dm_core_mutex);
+}
+
 static struct driver_info root_info = {
 	.name = "root_driver",
 };
@@ -100,6 +120,11 @@ int dm_init(bool of_live)
 		_uclass_root = &DM_UCLASS_ROOT_S_NON_CONST;
 		INIT_LIST_HEAD(DM_UCLASS_ROOT_NON_CONST);
 	}
+	uclass_index_reset();
+
+	ret = lists_init();
+	if (ret)
+		dm_warn("Driver lookup index unavailable: %d\n", ret);
 
 	if (IS_ENABLED(CONFIG_OF_PLATDATA_INST)) {
 		ret = dm_setup_inst();
@@ -333,16 +358,6 @@ struct acpi_ops root_acpi_ops = {
 };
 #endif
 
-static void dm_devices_probe(struct udevice *dev)
-{
-	struct udevice *child;
-	
-	list_for_each_entry(child, &dev->child_head, sibling_node) {
-		device_probe(child);
-		dm_devices_probe(child);
-	}
-}
-
 static void dm_root_init(void)
 {
 	int ret = dm_init_and_scan(false);
@@ -352,8 +367,7 @@ static void dm_root_init(void)
 
 static int device_drivers_init(void)
 {
-	dm_devices_probe(_dm_root);
-	return 0;
+	return dm_probe_devices(_dm_root);
 }
 
 module_driver(device_drivers_init, 
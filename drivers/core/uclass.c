@@ -19,7 +19,21 @@
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
+#include <linux/kernel.h>
 
+/* Entries by which the per-uclass device arrays grow */
+#define UCLASS_ARRAY_STEP	8
+
+/*
+ * Uclasses by id. Entries are filled in when a uclass is added, or found on
+ * the list the first time for uclasses which were not added at run time.
+ */
+static struct uclass *uclass_index[UCLASS_COUNT];
+
+void uclass_index_reset(void)
+{
+	memset(uclass_index, '\0', sizeof(uclass_index));
+}
 
 struct uclass *uclass_find(enum uclass_id key)
 {
@@ -27,19 +41,88 @@ struct uclass *uclass_find(enum uclass_id key)
 
 	if (!_dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+	if ((unsigned int)key >= UCLASS_COUNT)
+		return NULL;
+	if (uclass_index[key])
+		return uclass_index[key];
+
 	list_for_each_entry(uc, _uclass_root, sibling_node) {
-		if (uc->uc_drv->id == key)
+		if (uc->uc_drv->id == key) {
+			uclass_index[key] = uc;
 			return uc;
+		}
 	}
 
 	return NULL;
 }
 
+/**
+ * uclass_grow() - Make room in a per-uclass device array
+ *
+ * @arrayp: Array to grow, updated with its new address
+ * @sizep: Number of entries allocated, updated
+ * @count: Number of entries needed
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+static int uclass_grow(struct udevice ***arrayp, int *sizep, int count)
+{
+	struct udevice **array;
+	int size;
+
+	if (count <= *sizep)
+		return 0;
+
+	size = ROUND(count, UCLASS_ARRAY_STEP);
+	array = realloc(*arrayp, size * sizeof(*array));
+	if (!array)
+		return -ENOMEM;
+	memset(array + *sizep, '\0', (size - *sizep) * sizeof(*array));
+	*arrayp = array;
+	*sizep = size;
+
+	return 0;
+}
+
+/* Add a device which has just been put on its uclass list */
+static void uclass_index_add(struct udevice *dev)
+{
+	struct uclass *uc = dev->uclass;
+
+	uc->devs[uc->dev_count++] = dev;
+	if (dev->seq_ >= 0 && !uc->seq_devs[dev->seq_])
+		uc->seq_devs[dev->seq_] = dev;
+}
+
+/* Drop a device which has just been taken off its uclass list */
+static void uclass_index_del(struct udevice *dev)
+{
+	struct uclass *uc = dev->uclass;
+	struct udevice *iter;
+	int i;
+
+	for (i = 0; i < uc->dev_count; i++) {
+		if (uc->devs[i] == dev) {
+			uc->dev_count--;
+			memmove(&uc->devs[i], &uc->devs[i + 1],
+				(uc->dev_count - i) * sizeof(*uc->devs));
+			break;
+		}
+	}
+
+	if (dev->seq_ < 0 || dev->seq_ >= uc->seq_size ||
+	    uc->seq_devs[dev->seq_] != dev)
+		return;
+
+	/* Another device may have been given the same alias */
+	uc->seq_devs[dev->seq_] = NULL;
+	uclass_foreach_dev(iter, uc) {
+		if (iter->seq_ == dev->seq_) {
+			uc->seq_devs[dev->seq_] = iter;
+			break;
+		}
+	}
+}
+
 /**
  * uclass_add() - Create new uclass in list
  * @id: Id number to create
@@ -84,6 +167,7 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
 	list_add(&uc->sibling_node, DM_UCLASS_ROOT_NON_CONST);
+	uclass_index[uc_drv->id] = uc;
 
 	if (uc_drv->init) {
 		ret = uc_drv->init(uc);
@@ -100,6 +184,7 @@ fail:
 		uclass_set_priv(uc, NULL);
 	}
 	list_del(&uc->sibling_node);
+	uclass_index[uc_drv->id] = NULL;
 fail_mem:
 	free(uc);
 
@@ -132,9 +217,15 @@ int uclass_destroy(struct uclass *uc)
 	uc_drv = uc->uc_drv;
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
+	dm_core_lock();
 	list_del(&uc->sibling_node);
+	if (uclass_index[uc_drv->id] == uc)
+		uclass_index[uc_drv->id] = NULL;
+	dm_core_unlock();
 	if (uc_drv->priv_auto)
 		free(uclass_get_priv(uc));
+	free(uc->devs);
+	free(uc->seq_devs);
 	free(uc);
 
 	return 0;
@@ -143,17 +234,20 @@ int uclass_destroy(struct uclass *uc)
 int uclass_get(enum uclass_id id, struct uclass **ucp)
 {
 	struct uclass *uc;
+	int ret = 0;
 
 	*ucp = NULL;
+	dm_core_lock();
 	uc = uclass_find(id);
-	if (!uc) {
-		if (CONFIG_IS_ENABLED(OF_PLATDATA_INST))
-			return -ENOENT;
-		return uclass_add(id, ucp);
-	}
-	*ucp = uc;
+	if (uc)
+		*ucp = uc;
+	else if (CONFIG_IS_ENABLED(OF_PLATDATA_INST))
+		ret = -ENOENT;
+	else
+		ret = uclass_add(id, ucp);
+	dm_core_unlock();
 
-	return 0;
+	return ret;
 }
 
 const char *uclass_get_name(enum uclass_id id)
@@ -195,17 +289,17 @@ int dev_get_uclass_index(struct udevice *dev, struct uclass **ucp)
 	struct uclass *uc = dev->uclass;
 	int i = 0;
 
-	if (list_empty(&uc->dev_head))
-		return -ENODEV;
-
+	dm_core_lock();
 	uclass_foreach_dev(iter, uc) {
 		if (iter == dev) {
+			dm_core_unlock();
 			if (ucp)
 				*ucp = uc;
 			return i;
 		}
 		i++;
 	}
+	dm_core_unlock();
 
 	return -ENODEV;
 }
@@ -213,24 +307,19 @@ int dev_get_uclass_index(struct udevice *dev, struct uclass **ucp)
 int uclass_find_device(enum uclass_id id, int index, struct udevice **devp)
 {
 	struct uclass *uc;
-	struct udevice *dev;
 	int ret;
 
 	*devp = NULL;
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
-	if (list_empty(&uc->dev_head))
-		return -ENODEV;
 
-	uclass_foreach_dev(dev, uc) {
-		if (!index--) {
-			*devp = dev;
-			return 0;
-		}
-	}
+	dm_core_lock();
+	if (index >= 0 && index < uc->dev_count)
+		*devp = uc->devs[index];
+	dm_core_unlock();
 
-	return -ENODEV;
+	return *devp ? 0 : -ENODEV;
 }
 
 int uclass_find_first_device(enum uclass_id id, struct udevice **devp)
@@ -242,10 +331,11 @@ int uclass_find_first_device(enum uclass_id id, struct udevice **devp)
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
-	if (list_empty(&uc->dev_head))
-		return 0;
 
-	*devp = list_first_entry(&uc->dev_head, struct udevice, uclass_node);
+	dm_core_lock();
+	*devp = list_first_entry_or_null(&uc->dev_head, struct udevice,
+					 uclass_node);
+	dm_core_unlock();
 
 	return 0;
 }
@@ -255,10 +345,11 @@ int uclass_find_next_device(struct udevice **devp)
 	struct udevice *dev = *devp;
 
 	*devp = NULL;
-	if (list_is_last(&dev->uclass_node, &dev->uclass->dev_head))
-		return 0;
-
-	*devp = list_entry(dev->uclass_node.next, struct udevice, uclass_node);
+	dm_core_lock();
+	if (!list_is_last(&dev->uclass_node, &dev->uclass->dev_head))
+		*devp = list_entry(dev->uclass_node.next, struct udevice,
+				   uclass_node);
+	dm_core_unlock();
 
 	return 0;
 }
@@ -277,20 +368,22 @@ int uclass_find_device_by_name(enum uclass_id id, const char *name,
 	if (ret)
 		return ret;
 
+	dm_core_lock();
 	uclass_foreach_dev(dev, uc) {
 		if (!strcmp(dev->name, name)) {
 			*devp = dev;
-			return 0;
+			break;
 		}
 	}
+	dm_core_unlock();
 
-	return -ENODEV;
+	return *devp ? 0 : -ENODEV;
 }
 
 int uclass_find_next_free_seq(struct uclass *uc)
 {
-	struct udevice *dev;
 	int max = -1;
+	int i;
 
 	/* If using aliases, start with the highest alias value */
 	if (CONFIG_IS_ENABLED(DM_SEQ_ALIAS) &&
@@ -298,10 +391,14 @@ int uclass_find_next_free_seq(struct uclass *uc)
 		max = dev_read_alias_highest_id(uc->uc_drv->name);
 
 	/* Avoid conflict with existing devices */
-	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
-		if (dev->seq_ > max)
-			max = dev->seq_;
+	dm_core_lock();
+	for (i = uc->seq_size - 1; i > max; i--) {
+		if (uc->seq_devs[i]) {
+			max = i;
+			break;
+		}
 	}
+	dm_core_unlock();
 	/*
 	 * At this point, max will be -1 if there are no existing aliases or
 	 * devices
@@ -313,7 +410,6 @@ int uclass_find_next_free_seq(struct uclass *uc)
 int uclass_find_device_by_seq(enum uclass_id id, int seq, struct udevice **devp)
 {
 	struct uclass *uc;
-	struct udevice *dev;
 	int ret;
 
 	*devp = NULL;
@@ -324,13 +420,13 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq, struct udevice **devp)
 	if (ret)
 		return ret;
 
-	uclass_foreach_dev(dev, uc) {
-		log_debug("   - %d '%s'\n", dev->seq_, dev->name);
-		if (dev->seq_ == seq) {
-			*devp = dev;
-			log_debug("   - found\n");
-			return 0;
-		}
+	dm_core_lock();
+	if (seq >= 0 && seq < uc->seq_size)
+		*devp = uc->seq_devs[seq];
+	dm_core_unlock();
+	if (*devp) {
+		log_debug("   - found '%s'\n", (*devp)->name);
+		return 0;
 	}
 	log_debug("   - not found\n");
 
@@ -351,14 +447,16 @@ int uclass_find_device_by_of_offset(enum uclass_id id, int node,
 	if (ret)
 		return ret;
 
+	dm_core_lock();
 	uclass_foreach_dev(dev, uc) {
 		if (dev_of_offset(dev) == node) {
 			*devp = dev;
-			return 0;
+			break;
 		}
 	}
+	dm_core_unlock();
 
-	return -ENODEV;
+	return *devp ? 0 : -ENODEV;
 }
 
 int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
@@ -376,17 +474,19 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+	dm_core_lock();
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
 		if (ofnode_equal(dev_ofnode(dev), node)) {
 			*devp = dev;
-			goto done;
+			break;
 		}
 	}
-	ret = -ENODEV;
+	dm_core_unlock();
+	if (!*devp)
+		ret = -ENODEV;
 
-done:
 	log(LOGC_DM, LOGL_DEBUG, "   - result for %s: %s (ret=%d)\n",
 	    ofnode_get_name(node), *devp ? (*devp)->name : "(none)", ret);
 	return ret;
@@ -409,6 +509,7 @@ int uclass_find_device_by_phandle(enum uclass_id id, struct udevice *parent,
 	if (ret)
 		return ret;
 
+	dm_core_lock();
 	uclass_foreach_dev(dev, uc) {
 		uint phandle;
 
@@ -416,11 +517,12 @@ int uclass_find_device_by_phandle(enum uclass_id id, struct udevice *parent,
 
 		if (phandle == find_phandle) {
 			*devp = dev;
-			return 0;
+			break;
 		}
 	}
+	dm_core_unlock();
 
-	return -ENODEV;
+	return *devp ? 0 : -ENODEV;
 }
 #endif
 
@@ -428,7 +530,7 @@ int uclass_get_device_by_driver(enum uclass_id id,
 				const struct driver *find_drv,
 				struct udevice **devp)
 {
-	struct udevice *dev;
+	struct udevice *dev, *found = NULL;
 	struct uclass *uc;
 	int ret;
 
@@ -436,12 +538,18 @@ int uclass_get_device_by_driver(enum uclass_id id,
 	if (ret)
 		return ret;
 
+	dm_core_lock();
 	uclass_foreach_dev(dev, uc) {
-		if (dev->driver == find_drv)
-			return uclass_get_device_tail(dev, 0, devp);
+		if (dev->driver == find_drv) {
+			found = dev;
+			break;
+		}
 	}
+	dm_core_unlock();
+	if (!found)
+		return -ENODEV;
 
-	return -ENODEV;
+	return uclass_get_device_tail(found, 0, devp);
 }
 
 int uclass_get_device_tail(struct udevice *dev, int ret, struct udevice **devp)
@@ -530,6 +638,7 @@ int uclass_get_device_by_phandle_id(enum uclass_id id, uint phandle_id,
 	if (ret)
 		return ret;
 
+	dm_core_lock();
 	uclass_foreach_dev(dev, uc) {
 		uint phandle;
 
@@ -537,11 +646,14 @@ int uclass_get_device_by_phandle_id(enum uclass_id id, uint phandle_id,
 
 		if (phandle == phandle_id) {
 			*devp = dev;
-			return uclass_get_device_tail(dev, ret, devp);
+			break;
 		}
 	}
+	dm_core_unlock();
+	if (!*devp)
+		return -ENODEV;
 
-	return -ENODEV;
+	return uclass_get_device_tail(*devp, 0, devp);
 }
 
 int uclass_get_device_by_phandle(enum uclass_id id, struct udevice *parent,
@@ -656,7 +768,17 @@ int uclass_bind_device(struct udevice *dev)
 	int ret;
 
 	uc = dev->uclass;
-	list_add_tail(&dev->uclass_node, &uc->dev_head);
+	dm_core_lock();
+	ret = uclass_grow(&uc->devs, &uc->devs_size, uc->dev_count + 1);
+	if (!ret && dev->seq_ >= 0)
+		ret = uclass_grow(&uc->seq_devs, &uc->seq_size, dev->seq_ + 1);
+	if (!ret) {
+		list_add_tail(&dev->uclass_node, &uc->dev_head);
+		uclass_index_add(dev);
+	}
+	dm_core_unlock();
+	if (ret)
+		return ret;
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -671,7 +793,10 @@ int uclass_bind_device(struct udevice *dev)
 	return 0;
 err:
 	/* There is no need to undo the parent's post_bind call */
+	dm_core_lock();
 	list_del(&dev->uclass_node);
+	uclass_index_del(dev);
+	dm_core_unlock();
 
 	return ret;
 }
@@ -688,7 +813,10 @@ int uclass_unbind_device(struct udevice *dev)
 			return ret;
 	}
 
+	dm_core_lock();
 	list_del(&dev->uclass_node);
+	uclass_index_del(dev);
+	dm_core_unlock();
 	return 0;
 }
 
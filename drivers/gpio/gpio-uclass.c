@@ -38,12 +38,28 @@ static void gpio_desc_init(struct gpio_desc *desc,
 	desc->flags = 0;
 }
 
+/*
+ * Device found by the last gpio_to_device() call. The legacy API looks up
+ * every GPIO by number, usually on the same bank as the previous one.
+ */
+static struct udevice *gpio_last_dev;
+
 static int gpio_to_device(unsigned int gpio, struct gpio_desc *desc)
 {
 	struct gpio_dev_priv *uc_priv;
 	struct udevice *dev;
 	int ret;
 
+	dev = gpio_last_dev;
+	if (dev) {
+		uc_priv = dev_get_uclass_priv(dev);
+		if (gpio >= uc_priv->gpio_base &&
+		    gpio < uc_priv->gpio_base + uc_priv->gpio_count) {
+			gpio_desc_init(desc, dev, gpio - uc_priv->gpio_base);
+			return 0;
+		}
+	}
+
 	for (ret = uclass_first_device(UCLASS_GPIO, &dev);
 	     dev;
 	     ret = uclass_next_device(&dev)) {
@@ -51,6 +67,7 @@ static int gpio_to_device(unsigned int gpio, struct gpio_desc *desc)
 		if (gpio >= uc_priv->gpio_base &&
 		    gpio < uc_priv->gpio_base + uc_priv->gpio_count) {
 			gpio_desc_init(desc, dev, gpio - uc_priv->gpio_base);
+			gpio_last_dev = dev;
 			return 0;
 		}
 	}
@@ -561,6 +578,145 @@ int dm_gpio_set_value(const struct gpio_desc *desc, int value)
 	return dm_gpio_set_value_nocheck(desc, value);
 }
 
+int dm_gpio_get_port(struct udevice *dev, uint offset, ulong mask,
+		     ulong *valuep)
+{
+	const struct dm_gpio_ops *ops = gpio_get_ops(dev);
+	ulong value = 0;
+	uint bit;
+	int ret;
+
+	if (ops->get_port) {
+		ret = ops->get_port(dev, offset, mask, &value);
+		if (ret)
+			return ret;
+		*valuep = value & mask;
+		return 0;
+	}
+
+	if (!ops->get_value)
+		return -ENOSYS;
+	for (; mask; mask &= mask - 1) {
+		bit = __ffs(mask);
+		ret = ops->get_value(dev, offset + bit);
+		if (ret < 0)
+			return ret;
+		if (ret)
+			value |= BIT(bit);
+	}
+	*valuep = value;
+
+	return 0;
+}
+
+int dm_gpio_set_port(struct udevice *dev, uint offset, ulong mask,
+		     ulong value)
+{
+	const struct dm_gpio_ops *ops = gpio_get_ops(dev);
+	uint bit;
+	int ret;
+
+	if (ops->set_port)
+		return ops->set_port(dev, offset, mask, value);
+
+	if (!ops->set_value)
+		return -ENOSYS;
+	for (; mask; mask &= mask - 1) {
+		bit = __ffs(mask);
+		ret = ops->set_value(dev, offset + bit, !!(value & BIT(bit)));
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int dm_gpio_get_mmio(const struct gpio_desc *desc, struct gpio_mmio *mmio)
+{
+	struct gpio_dev_priv *uc_priv;
+	const struct dm_gpio_ops *ops;
+	int ret;
+
+	ret = check_reserved(desc, "get_mmio");
+	if (ret)
+		return ret;
+
+	ops = gpio_get_ops(desc->dev);
+	if (!ops->get_mmio)
+		return -ENOSYS;
+	ret = ops->get_mmio(desc->dev, desc->offset, mmio);
+	if (ret)
+		return ret;
+
+	uc_priv = dev_get_uclass_priv(desc->dev);
+	mmio->lock = &uc_priv->lock;
+
+	return 0;
+}
+
+int gpio_port_init(struct gpio_port *port, const struct gpio_desc *desc_list,
+		   int count)
+{
+	const struct gpio_desc *desc;
+	uint base, bit;
+	int ret, i;
+
+	if (count <= 0)
+		return -EINVAL;
+
+	base = desc_list[0].offset;
+	for (i = 0; i < count; i++) {
+		desc = &desc_list[i];
+		ret = check_reserved(desc, "port_init");
+		if (ret)
+			return ret;
+		if (desc->dev != desc_list[0].dev)
+			return -EXDEV;
+		if (desc->flags & (GPIOD_OPEN_DRAIN | GPIOD_OPEN_SOURCE))
+			return -EINVAL;
+		base = min(base, desc->offset);
+	}
+
+	port->dev = desc_list[0].dev;
+	port->base = base;
+	port->mask = 0;
+	port->invert = 0;
+	for (i = 0; i < count; i++) {
+		desc = &desc_list[i];
+		bit = desc->offset - base;
+		if (bit >= BITS_PER_LONG)
+			return -ERANGE;
+		port->mask |= BIT(bit);
+		if (desc->flags & GPIOD_ACTIVE_LOW)
+			port->invert |= BIT(bit);
+	}
+
+	return 0;
+}
+
+int gpio_port_get(const struct gpio_port *port, ulong *valuep)
+{
+	ulong value;
+	int ret;
+
+	ret = dm_gpio_get_port(port->dev, port->base, port->mask, &value);
+	if (ret)
+		return ret;
+	*valuep = (value ^ port->invert) & port->mask;
+
+	return 0;
+}
+
+int gpio_port_set(const struct gpio_port *port, ulong mask, ulong value)
+{
+	mask &= port->mask;
+	if (!mask)
+		return 0;
+
+	return dm_gpio_set_port(port->dev, port->base, mask,
+				value ^ port->invert);
+}
+
 /* check dir flags invalid configuration */
 static int check_dir_flags(ulong flags)
 {
@@ -912,10 +1068,30 @@ int gpio_get_values_as_int(const int *gpio_list)
 
 int dm_gpio_get_values_as_int(const struct gpio_desc *desc_list, int count)
 {
+	struct gpio_port port;
 	unsigned bitmask = 1;
 	unsigned vector = 0;
+	ulong value;
 	int ret, i;
 
+	/* Read the whole list with one call when it fits in a port */
+	if (count > 1 && count <= 32) {
+		ret = gpio_port_init(&port, desc_list, count);
+		if (ret == -ENOENT || ret == -EBUSY)
+			return ret;
+		if (!ret) {
+			ret = gpio_port_get(&port, &value);
+			if (ret)
+				return ret;
+			for (i = 0; i < count; i++) {
+				if (value & BIT(desc_list[i].offset - port.base))
+					vector |= bitmask;
+				bitmask <<= 1;
+			}
+			return vector;
+		}
+	}
+
 	for (i = 0; i < count; i++) {
 		ret = dm_gpio_get_value(&desc_list[i]);
 		if (ret < 0)
@@ -1190,6 +1366,7 @@ static int gpio_renumber(struct udevice *removed_dev)
 
 	/* Ensure that we have a base for each bank */
 	base = 0;
+	dm_core_lock();
 	uclass_foreach_dev(dev, uc) {
 		if (device_active(dev) && dev != removed_dev) {
 			uc_priv = dev_get_uclass_priv(dev);
@@ -1197,6 +1374,7 @@ static int gpio_renumber(struct udevice *removed_dev)
 			base += uc_priv->gpio_count;
 		}
 	}
+	dm_core_unlock();
 
 	return 0;
 }
@@ -1239,6 +1417,8 @@ static int gpio_pre_remove(struct udevice *dev)
 			free(uc_priv->name[i]);
 	}
 	free(uc_priv->name);
+	if (gpio_last_dev == dev)
+		gpio_last_dev = NULL;
 	return gpio_renumber(dev);
 }
 
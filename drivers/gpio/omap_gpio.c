@@ -82,16 +82,26 @@ static int _get_gpio_value(const struct gpio_bank *bank, int gpio)
 	int v;
 
 	v = _get_gpio_direction(bank, gpio);
-	reg_offset = OMAP_GPIO_DATAIN + (v << 2);
+	if (v == OMAP_GPIO_DIR_IN)
+		reg_offset = OMAP_GPIO_DATAIN;
+	else
+		reg_offset = OMAP_GPIO_DATAOUT;
 	v = __raw_readl(bank->base + reg_offset);
 	return !!(v & BIT(gpio));
 }
 
+/*
+ * OE is shared by the bank; it is also changed through dm_gpio_get_mmio()
+ * under the same lock
+ */
 static int omap_gpio_direction_input(struct udevice *dev, unsigned offset)
 {
 	struct gpio_bank *bank = dev_get_priv(dev);
+	rtems_interrupt_lock_context ctx;
 
+	gpio_device_lock(dev, &ctx);
 	_set_gpio_direction(bank, offset, 1);
+	gpio_device_unlock(dev, &ctx);
 	return 0;
 }
 
@@ -99,9 +109,12 @@ static int omap_gpio_direction_output(struct udevice *dev, unsigned offset,
 				       int value)
 {
 	struct gpio_bank *bank = dev_get_priv(dev);
+	rtems_interrupt_lock_context ctx;
 
 	_set_gpio_dataout(bank, offset, value);
+	gpio_device_lock(dev, &ctx);
 	_set_gpio_direction(bank, offset, 0);
+	gpio_device_unlock(dev, &ctx);
 	return 0;
 }
 
@@ -121,6 +134,62 @@ static int omap_gpio_set_value(struct udevice *dev, unsigned offset,
 	return 0;
 }
 
+/* Check that a port mask does not reach past the end of the bank */
+static bool omap_gpio_port_valid(unsigned int offset, ulong mask)
+{
+	return offset < GPIO_PER_BANK &&
+	       !(mask & ~GENMASK(GPIO_PER_BANK - 1 - offset, 0));
+}
+
+static int omap_gpio_get_port(struct udevice *dev, unsigned int offset,
+			      ulong mask, ulong *valuep)
+{
+	struct gpio_bank *bank = dev_get_priv(dev);
+	u32 oe, in, out;
+
+	if (!omap_gpio_port_valid(offset, mask))
+		return -EINVAL;
+
+	/* Inputs read the pad, outputs the level being driven */
+	oe = __raw_readl(bank->base + OMAP_GPIO_OE);
+	in = __raw_readl(bank->base + OMAP_GPIO_DATAIN);
+	out = __raw_readl(bank->base + OMAP_GPIO_DATAOUT);
+	*valuep = ((in & oe) | (out & ~oe)) >> offset;
+	return 0;
+}
+
+static int omap_gpio_set_port(struct udevice *dev, unsigned int offset,
+			      ulong mask, ulong value)
+{
+	struct gpio_bank *bank = dev_get_priv(dev);
+	u32 pins, set;
+
+	if (!omap_gpio_port_valid(offset, mask))
+		return -EINVAL;
+
+	pins = mask << offset;
+	set = (value << offset) & pins;
+	if (set)
+		__raw_writel(set, bank->base + OMAP_GPIO_SETDATAOUT);
+	if (pins & ~set)
+		__raw_writel(pins & ~set, bank->base + OMAP_GPIO_CLEARDATAOUT);
+	return 0;
+}
+
+static int omap_gpio_get_mmio(struct udevice *dev, unsigned int offset,
+			      struct gpio_mmio *mmio)
+{
+	struct gpio_bank *bank = dev_get_priv(dev);
+
+	mmio->dir = (void __iomem *)(bank->base + OMAP_GPIO_OE);
+	mmio->dir_mask = BIT(offset);
+	mmio->dir_out = 0;
+	mmio->dir_in = BIT(offset);
+	mmio->in = (void __iomem *)(bank->base + OMAP_GPIO_DATAIN);
+	mmio->in_mask = BIT(offset);
+	return 0;
+}
+
 static int omap_gpio_get_function(struct udevice *dev, unsigned offset)
 {
 	struct gpio_bank *bank = dev_get_priv(dev);
@@ -227,6 +296,9 @@ static const struct dm_gpio_ops gpio_omap_ops = {
 	.get_value		= omap_gpio_get_value,
 	.set_value		= omap_gpio_set_value,
 	.get_function		= omap_gpio_get_function,
+	.get_port		= omap_gpio_get_port,
+	.set_port		= omap_gpio_set_port,
+	.get_mmio		= omap_gpio_get_mmio,
 };
 
 static int omap_gpio_probe(struct udevice *dev)
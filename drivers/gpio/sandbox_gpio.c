@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sandbox GPIO bank
+ *
+ * Up to 32 GPIOs held in memory. Outputs are looped back, so reading a pin
+ * returns the level last driven on it whatever its direction.
+ */
+
+#include <errno.h>
+
+#include <common.h>
+#include <asm/gpio.h>
+#include <dm.h>
+#include <dm/read.h>
+#include <dm/platdata.h>
+#include <dm/platform_data/sandbox_bus.h>
+
+struct sandbox_gpio_priv {
+	u32 dir;
+	u32 value;
+};
+
+static int sandbox_gpio_direction_input(struct udevice *dev, unsigned offset)
+{
+	struct sandbox_gpio_priv *priv = dev_get_priv(dev);
+	rtems_interrupt_lock_context ctx;
+
+	gpio_device_lock(dev, &ctx);
+	priv->dir &= ~BIT(offset);
+	gpio_device_unlock(dev, &ctx);
+	return 0;
+}
+
+static int sandbox_gpio_direction_output(struct udevice *dev, unsigned offset,
+					 int value)
+{
+	struct sandbox_gpio_priv *priv = dev_get_priv(dev);
+	rtems_interrupt_lock_context ctx;
+
+	gpio_device_lock(dev, &ctx);
+	if (value)
+		priv->value |= BIT(offset);
+	else
+		priv->value &= ~BIT(offset);
+	priv->dir |= BIT(offset);
+	gpio_device_unlock(dev, &ctx);
+	return 0;
+}
+
+static int sandbox_gpio_get_value(struct udevice *dev, unsigned offset)
+{
+	struct sandbox_gpio_priv *priv = dev_get_priv(dev);
+
+	return !!(priv->value & BIT(offset));
+}
+
+static int sandbox_gpio_set_value(struct udevice *dev, unsigned offset,
+				  int value)
+{
+	struct sandbox_gpio_priv *priv = dev_get_priv(dev);
+
+	if (value)
+		priv->value |= BIT(offset);
+	else
+		priv->value &= ~BIT(offset);
+	return 0;
+}
+
+static int sandbox_gpio_get_port(struct udevice *dev, unsigned int offset,
+				 ulong mask, ulong *valuep)
+{
+	struct sandbox_gpio_priv *priv = dev_get_priv(dev);
+
+	if (offset >= 32)
+		return -EINVAL;
+	*valuep = priv->value >> offset;
+	return 0;
+}
+
+static int sandbox_gpio_set_port(struct udevice *dev, unsigned int offset,
+				 ulong mask, ulong value)
+{
+	struct sandbox_gpio_priv *priv = dev_get_priv(dev);
+	u32 pins;
+
+	if (offset >= 32)
+		return -EINVAL;
+	pins = mask << offset;
+	priv->value = (priv->value & ~pins) | ((value << offset) & pins);
+	return 0;
+}
+
+static int sandbox_gpio_get_function(struct udevice *dev, unsigned offset)
+{
+	struct sandbox_gpio_priv *priv = dev_get_priv(dev);
+
+	return priv->dir & BIT(offset) ? GPIOF_OUTPUT : GPIOF_INPUT;
+}
+
+static const struct dm_gpio_ops sandbox_gpio_ops = {
+	.direction_input	= sandbox_gpio_direction_input,
+	.direction_output	= sandbox_gpio_direction_output,
+	.get_value		= sandbox_gpio_get_value,
+	.set_value		= sandbox_gpio_set_value,
+	.get_function		= sandbox_gpio_get_function,
+	.get_port		= sandbox_gpio_get_port,
+	.set_port		= sandbox_gpio_set_port,
+};
+
+static int sandbox_gpio_of_to_plat(struct udevice *dev)
+{
+	struct sandbox_gpio_plat *plat = dev_get_plat(dev);
+
+	if (!dev_has_ofnode(dev))
+		return 0;
+
+	plat->bank_name = dev_read_string(dev, "gpio-bank-name");
+	plat->gpio_count = dev_read_u32_default(dev, "gpio-count",
+						SANDBOX_GPIO_COUNT);
+
+	return 0;
+}
+
+static int sandbox_gpio_probe(struct udevice *dev)
+{
+	struct sandbox_gpio_plat *plat = dev_get_plat(dev);
+	struct gpio_dev_priv *uc_priv = dev_get_uclass_priv(dev);
+
+	if (!plat->gpio_count || plat->gpio_count > 32)
+		return -EINVAL;
+
+	uc_priv->bank_name = plat->bank_name ? plat->bank_name : dev->name;
+	uc_priv->gpio_count = plat->gpio_count;
+
+	return 0;
+}
+
+static const struct udevice_id sandbox_gpio_ids[] = {
+	{ .compatible = "sandbox,gpio" },
+	{ }
+};
+
+DM_DRIVER(sandbox_gpio) = {
+	.name		= "sandbox_gpio",
+	.id		= UCLASS_GPIO,
+	.of_match	= sandbox_gpio_ids,
+	.of_to_plat	= sandbox_gpio_of_to_plat,
+	.probe		= sandbox_gpio_probe,
+	.plat_auto	= sizeof(struct sandbox_gpio_plat),
+	.priv_auto	= sizeof(struct sandbox_gpio_priv),
+	.ops		= &sandbox_gpio_ops,
+};
+
+#if defined(CONFIG_SANDBOX_BUS) && !CONFIG_IS_ENABLED(OF_PLATDATA)
+static struct sandbox_gpio_plat sandbox_gpio_plat = {
+	.bank_name	= "sb",
+	.gpio_count	= SANDBOX_GPIO_COUNT,
+};
+
+U_BOOT_DRVINFO(sandbox_gpio) = {
+	.name	= "sandbox_gpio",
+	.plat	= &sandbox_gpio_plat,
+};
+#endif
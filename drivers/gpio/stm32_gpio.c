@@ -107,13 +107,16 @@ static int stm32_gpio_direction_input(struct udevice *dev, unsigned offset)
 {
 	struct stm32_gpio_priv *priv = dev_get_priv(dev);
 	struct stm32_gpio_regs *regs = priv->regs;
+	rtems_interrupt_lock_context ctx;
 	int idx;
 
 	idx = stm32_offset_to_index(dev, offset);
 	if (idx < 0)
 		return idx;
 
+	gpio_device_lock(dev, &ctx);
 	stm32_gpio_set_moder(regs, idx, STM32_GPIO_MODE_IN);
+	gpio_device_unlock(dev, &ctx);
 
 	return 0;
 }
@@ -123,13 +126,16 @@ static int stm32_gpio_direction_output(struct udevice *dev, unsigned offset,
 {
 	struct stm32_gpio_priv *priv = dev_get_priv(dev);
 	struct stm32_gpio_regs *regs = priv->regs;
+	rtems_interrupt_lock_context ctx;
 	int idx;
 
 	idx = stm32_offset_to_index(dev, offset);
 	if (idx < 0)
 		return idx;
 
+	gpio_device_lock(dev, &ctx);
 	stm32_gpio_set_moder(regs, idx, STM32_GPIO_MODE_OUT);
+	gpio_device_unlock(dev, &ctx);
 
 	writel(BSRR_BIT(idx, value), &regs->bsrr);
 
@@ -164,6 +170,79 @@ static int stm32_gpio_set_value(struct udevice *dev, unsigned offset, int value)
 	return 0;
 }
 
+/*
+ * Check a port against the pins of the bank. stm32_offset_to_index() maps
+ * offsets to indices one to one, so only the highest pin needs checking.
+ */
+static int stm32_gpio_port_check(struct udevice *dev, unsigned int offset,
+				 ulong mask)
+{
+	int idx;
+
+	if (!mask)
+		return 0;
+	idx = stm32_offset_to_index(dev, offset + __fls(mask));
+
+	return idx < 0 ? idx : 0;
+}
+
+static int stm32_gpio_get_mmio(struct udevice *dev, unsigned int offset,
+			       struct gpio_mmio *mmio)
+{
+	struct stm32_gpio_priv *priv = dev_get_priv(dev);
+	struct stm32_gpio_regs *regs = priv->regs;
+	int idx;
+
+	idx = stm32_offset_to_index(dev, offset);
+	if (idx < 0)
+		return idx;
+
+	mmio->dir = &regs->moder;
+	mmio->dir_mask = MODE_BITS_MASK << MODE_BITS(idx);
+	mmio->dir_out = STM32_GPIO_MODE_OUT << MODE_BITS(idx);
+	mmio->dir_in = STM32_GPIO_MODE_IN << MODE_BITS(idx);
+	mmio->in = &regs->idr;
+	mmio->in_mask = BIT(idx);
+
+	return 0;
+}
+
+static int stm32_gpio_get_port(struct udevice *dev, unsigned int offset,
+			       ulong mask, ulong *valuep)
+{
+	struct stm32_gpio_priv *priv = dev_get_priv(dev);
+	struct stm32_gpio_regs *regs = priv->regs;
+	int ret;
+
+	ret = stm32_gpio_port_check(dev, offset, mask);
+	if (ret)
+		return ret;
+
+	*valuep = readl(&regs->idr) >> offset;
+
+	return 0;
+}
+
+static int stm32_gpio_set_port(struct udevice *dev, unsigned int offset,
+			       ulong mask, ulong value)
+{
+	struct stm32_gpio_priv *priv = dev_get_priv(dev);
+	struct stm32_gpio_regs *regs = priv->regs;
+	u32 pins, set;
+	int ret;
+
+	ret = stm32_gpio_port_check(dev, offset, mask);
+	if (ret)
+		return ret;
+
+	/* BSRR sets the pins in its low half and resets those in its high half */
+	pins = mask << offset;
+	set = (value << offset) & pins;
+	writel(set | (pins & ~set) << STM32_GPIOS_PER_BANK, &regs->bsrr);
+
+	return 0;
+}
+
 static int stm32_gpio_get_function(struct udevice *dev, unsigned int offset)
 {
 	struct stm32_gpio_priv *priv = dev_get_priv(dev);
@@ -196,12 +275,15 @@ static int stm32_gpio_set_flags(struct udevice *dev, unsigned int offset,
 {
 	struct stm32_gpio_priv *priv = dev_get_priv(dev);
 	struct stm32_gpio_regs *regs = priv->regs;
+	rtems_interrupt_lock_context ctx;
 	int idx;
 
 	idx = stm32_offset_to_index(dev, offset);
 	if (idx < 0)
 		return idx;
 
+	/* MODER, OTYPER and PUPDR are read-modify-written for the whole bank */
+	gpio_device_lock(dev, &ctx);
 	if (flags & GPIOD_IS_OUT) {
 		bool value = flags & GPIOD_IS_OUT_ACTIVE;
 
@@ -220,6 +302,7 @@ static int stm32_gpio_set_flags(struct udevice *dev, unsigned int offset,
 		stm32_gpio_set_pupd(regs, idx, STM32_GPIO_PUPD_UP);
 	else if (flags & GPIOD_PULL_DOWN)
 		stm32_gpio_set_pupd(regs, idx, STM32_GPIO_PUPD_DOWN);
+	gpio_device_unlock(dev, &ctx);
 
 	return 0;
 }
@@ -270,6 +353,9 @@ static const struct dm_gpio_ops gpio_stm32_ops = {
 	.direction_output	= stm32_gpio_direction_output,
 	.get_value		= stm32_gpio_get_value,
 	.set_value		= stm32_gpio_set_value,
+	.get_port		= stm32_gpio_get_port,
+	.set_port		= stm32_gpio_set_port,
+	.get_mmio		= stm32_gpio_get_mmio,
 	.get_function		= stm32_gpio_get_function,
 	.set_flags		= stm32_gpio_set_flags,
 	.get_flags		= stm32_gpio_get_flags,
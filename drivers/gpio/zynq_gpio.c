@@ -274,8 +274,116 @@ static int zynq_gpio_set_value(struct udevice *dev, unsigned gpio, int value)
 	return 0;
 }
 
+/*
+ * Find the bank holding pin @offset + @bit of a port and return the port
+ * bits which fall in that bank. @shiftp returns the left shift taking bank
+ * register bits to port bits, negative when the port starts mid-bank.
+ */
+static ulong zynq_gpio_port_bank(struct udevice *dev, unsigned int offset,
+				 unsigned int bit, unsigned int *bank_num,
+				 int *shiftp)
+{
+	struct zynq_gpio_plat *plat = dev_get_plat(dev);
+	unsigned int bank_pin_num;
+	int lo, hi;
+
+	zynq_gpio_get_bank_pin(offset + bit, bank_num, &bank_pin_num, dev);
+	*shiftp = (int)bit - (int)bank_pin_num;
+	lo = max(*shiftp, 0);
+	hi = min_t(int, plat->p_data->bank_max[*bank_num] - offset,
+		   BITS_PER_LONG - 1);
+	return GENMASK(hi, lo);
+}
+
+static int zynq_gpio_get_port(struct udevice *dev, unsigned int offset,
+			      ulong mask, ulong *valuep)
+{
+	struct zynq_gpio_plat *plat = dev_get_plat(dev);
+	unsigned int bank_num;
+	ulong bits, data, value = 0;
+	int shift;
+
+	if (mask && check_gpio(offset + __fls(mask), dev) < 0)
+		return -EINVAL;
+
+	while (mask) {
+		bits = zynq_gpio_port_bank(dev, offset, __ffs(mask),
+					   &bank_num, &shift);
+		data = readl(plat->base + ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
+		data = shift >= 0 ? data << shift : data >> -shift;
+		value |= data & bits;
+		mask &= ~bits;
+	}
+	*valuep = value;
+	return 0;
+}
+
+static int zynq_gpio_set_port(struct udevice *dev, unsigned int offset,
+			      ulong mask, ulong value)
+{
+	struct zynq_gpio_plat *plat = dev_get_plat(dev);
+	unsigned int bank_num;
+	ulong bits;
+	u32 pins, data;
+	int shift;
+
+	if (mask && check_gpio(offset + __fls(mask), dev) < 0)
+		return -EINVAL;
+
+	while (mask) {
+		bits = zynq_gpio_port_bank(dev, offset, __ffs(mask),
+					   &bank_num, &shift);
+		bits &= mask;
+		mask &= ~bits;
+		pins = shift >= 0 ? bits >> shift : bits << -shift;
+		data = shift >= 0 ? value >> shift : value << -shift;
+		data &= pins;
+
+		/*
+		 * Each half of the bank has a mask/data register: the upper 16
+		 * bits mask off pins which must keep their level, the lower 16
+		 * bits hold the new levels, so no read-modify-write is needed.
+		 */
+		if (pins & 0xffff)
+			writel((~pins << ZYNQ_GPIO_MID_PIN_NUM) | (data & 0xffff),
+			       plat->base + ZYNQ_GPIO_DATA_LSW_OFFSET(bank_num));
+		if (pins >> ZYNQ_GPIO_MID_PIN_NUM)
+			writel((~pins & ZYNQ_GPIO_UPPER_MASK) |
+			       (data >> ZYNQ_GPIO_MID_PIN_NUM),
+			       plat->base + ZYNQ_GPIO_DATA_MSW_OFFSET(bank_num));
+	}
+	return 0;
+}
+
+static int zynq_gpio_get_mmio(struct udevice *dev, unsigned int offset,
+			      struct gpio_mmio *mmio)
+{
+	struct zynq_gpio_plat *plat = dev_get_plat(dev);
+	unsigned int bank_num, bank_pin_num;
+
+	if (check_gpio(offset, dev) < 0)
+		return -EINVAL;
+
+	zynq_gpio_get_bank_pin(offset, &bank_num, &bank_pin_num, dev);
+
+	/* bank 0 pins 7 and 8 are special and cannot be used as inputs */
+	if (bank_num == 0 && (bank_pin_num == 7 || bank_pin_num == 8))
+		return -EINVAL;
+
+	mmio->dir = (void __iomem *)(plat->base +
+				     ZYNQ_GPIO_DIRM_OFFSET(bank_num));
+	mmio->dir_mask = BIT(bank_pin_num);
+	mmio->dir_out = BIT(bank_pin_num);
+	mmio->dir_in = 0;
+	mmio->in = (void __iomem *)(plat->base +
+				    ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
+	mmio->in_mask = BIT(bank_pin_num);
+	return 0;
+}
+
 static int zynq_gpio_direction_input(struct udevice *dev, unsigned gpio)
 {
+	rtems_interrupt_lock_context ctx;
 	u32 reg;
 	unsigned int bank_num, bank_pin_num;
 	struct zynq_gpio_plat *plat = dev_get_plat(dev);
@@ -290,15 +398,18 @@ static int zynq_gpio_direction_input(struct udevice *dev, unsigned gpio)
 		return -1;
 
 	/* clear the bit in direction mode reg to set the pin as input */
+	gpio_device_lock(dev, &ctx);
 	reg = readl(plat->base + ZYNQ_GPIO_DIRM_OFFSET(bank_num));
 	reg &= ~BIT(bank_pin_num);
 	writel(reg, plat->base + ZYNQ_GPIO_DIRM_OFFSET(bank_num));
+	gpio_device_unlock(dev, &ctx);
 	return 0;
 }
 
 static int zynq_gpio_direction_output(struct udevice *dev, unsigned gpio,
 				      int value)
 {
+	rtems_interrupt_lock_context ctx;
 	u32 reg;
 	unsigned int bank_num, bank_pin_num;
 	struct zynq_gpio_plat *plat = dev_get_plat(dev);
@@ -309,6 +420,7 @@ static int zynq_gpio_direction_output(struct udevice *dev, unsigned gpio,
 	zynq_gpio_get_bank_pin(gpio, &bank_num, &bank_pin_num, dev);
 
 	/* set the GPIO pin as output */
+	gpio_device_lock(dev, &ctx);
 	reg = readl(plat->base + ZYNQ_GPIO_DIRM_OFFSET(bank_num));
 	reg |= BIT(bank_pin_num);
 	writel(reg, plat->base + ZYNQ_GPIO_DIRM_OFFSET(bank_num));
@@ -317,6 +429,7 @@ static int zynq_gpio_direction_output(struct udevice *dev, unsigned gpio,
 	reg = readl(plat->base + ZYNQ_GPIO_OUTEN_OFFSET(bank_num));
 	reg |= BIT(bank_pin_num);
 	writel(reg, plat->base + ZYNQ_GPIO_OUTEN_OFFSET(bank_num));
+	gpio_device_unlock(dev, &ctx);
 
 	/* set the state of the pin */
 	zynq_gpio_set_value(dev, gpio, value);
@@ -465,6 +578,9 @@ static const struct dm_gpio_ops gpio_zynq_ops = {
 	.get_value		= zynq_gpio_get_value,
 	.set_value		= zynq_gpio_set_value,
 	.get_function		= zynq_gpio_get_function,
+	.get_port		= zynq_gpio_get_port,
+	.set_port		= zynq_gpio_set_port,
+	.get_mmio		= zynq_gpio_get_mmio,
 };
 
 static const struct udevice_id zynq_gpio_ids[] = {
@@ -7,15 +7,19 @@
  */
 
 #include <errno.h>
+#include <rtems/counter.h>
 #include "common.h"
 
 #include "dm.h"
 #include "log.h"
+#include "dm/device_compat.h"
 #include "dm/i2c.h"
 #include "asm/gpio.h"
+#include "asm/io.h"
 #include "linux/delay.h"
 
 #define DEFAULT_UDELAY	5
+#define CALIBRATE_LOOPS	64
 #define RETRIES		0
 #define I2C_ACK		0
 #define I2C_NOACK	1
@@ -28,12 +32,21 @@ enum {
 
 struct i2c_gpio_bus {
 	/**
-	  * udelay - delay [us] between GPIO toggle operations,
-	  * which is 1/4 of I2C speed clock period.
+	  * quarter_ns - 1/4 of I2C speed clock period [ns], the time
+	  * between GPIO toggle operations.
 	 */
-	int udelay;
+	unsigned int quarter_ns;
+	/**
+	 * delay - what is left of quarter_ns once a toggle operation has
+	 * been paid for, in counter ticks
+	 */
+	rtems_counter_ticks delay;
+	/* toggle - measured cost of a toggle operation, in counter ticks */
+	rtems_counter_ticks toggle;
 	 /* sda, scl */
 	struct gpio_desc gpios[PIN_COUNT];
+	/* sda, scl registers, for the fast path */
+	struct gpio_mmio mmio[PIN_COUNT];
 
 	int (*get_sda)(struct i2c_gpio_bus *bus);
 	void (*set_sda)(struct i2c_gpio_bus *bus, int bit);
@@ -87,61 +100,120 @@ static void i2c_gpio_scl_set_output_only(struct i2c_gpio_bus *bus, int bit)
 	dm_gpio_clrset_flags(scl, GPIOD_MASK_DIR, flags);
 }
 
-static void i2c_gpio_write_bit(struct i2c_gpio_bus *bus, int delay, uchar bit)
+/*
+ * Fast path, used when the GPIO driver can describe its registers. Lines are
+ * driven open-drain: the output latch stays low and a line is released by
+ * making it an input, as above, but with one locked read-modify-write of the
+ * direction register instead of a trip through the GPIO uclass.
+ */
+static void i2c_gpio_mmio_dir(const struct gpio_mmio *io, int release)
+{
+	rtems_interrupt_lock_context ctx;
+	u32 reg;
+
+	rtems_interrupt_lock_acquire(io->lock, &ctx);
+	reg = readl(io->dir) & ~io->dir_mask;
+	reg |= release ? io->dir_in : io->dir_out;
+	writel(reg, io->dir);
+	rtems_interrupt_lock_release(io->lock, &ctx);
+}
+
+static inline int i2c_gpio_mmio_get(const struct gpio_mmio *io)
+{
+	return !!(readl(io->in) & io->in_mask);
+}
+
+static int i2c_gpio_mmio_sda_get(struct i2c_gpio_bus *bus)
+{
+	return i2c_gpio_mmio_get(&bus->mmio[PIN_SDA]);
+}
+
+static void i2c_gpio_mmio_sda_set(struct i2c_gpio_bus *bus, int bit)
+{
+	i2c_gpio_mmio_dir(&bus->mmio[PIN_SDA], bit);
+}
+
+static void i2c_gpio_mmio_scl_set(struct i2c_gpio_bus *bus, int bit)
+{
+	const struct gpio_mmio *scl = &bus->mmio[PIN_SCL];
+	int count = 0;
+
+	i2c_gpio_mmio_dir(scl, bit);
+	if (!bit)
+		return;
+
+	while (!i2c_gpio_mmio_get(scl) && count++ < 100000)
+		udelay(1);
+
+	if (!i2c_gpio_mmio_get(scl))
+		pr_err("timeout waiting on slave to release scl\n");
+}
+
+static inline void i2c_gpio_delay(rtems_counter_ticks delay)
+{
+	rtems_counter_delay_ticks(delay);
+}
+
+static void i2c_gpio_write_bit(struct i2c_gpio_bus *bus,
+			       rtems_counter_ticks delay, uchar bit)
 {
 	bus->set_scl(bus, 0);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_sda(bus, bit);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_scl(bus, 1);
-	udelay(2 * delay);
+	i2c_gpio_delay(2 * delay);
 }
 
-static int i2c_gpio_read_bit(struct i2c_gpio_bus *bus, int delay)
+static int i2c_gpio_read_bit(struct i2c_gpio_bus *bus,
+			     rtems_counter_ticks delay)
 {
 	int value;
 
 	bus->set_scl(bus, 1);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	value = bus->get_sda(bus);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_scl(bus, 0);
-	udelay(2 * delay);
+	i2c_gpio_delay(2 * delay);
 
 	return value;
 }
 
 /* START: High -> Low on SDA while SCL is High */
-static void i2c_gpio_send_start(struct i2c_gpio_bus *bus, int delay)
+static void i2c_gpio_send_start(struct i2c_gpio_bus *bus,
+				rtems_counter_ticks delay)
 {
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_sda(bus, 1);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_scl(bus, 1);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_sda(bus, 0);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 }
 
 /* STOP: Low -> High on SDA while SCL is High */
-static void i2c_gpio_send_stop(struct i2c_gpio_bus *bus, int delay)
+static void i2c_gpio_send_stop(struct i2c_gpio_bus *bus,
+			       rtems_counter_ticks delay)
 {
 	bus->set_scl(bus, 0);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_sda(bus, 0);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_scl(bus, 1);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_sda(bus, 1);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 }
 
 /* ack should be I2C_ACK or I2C_NOACK */
-static void i2c_gpio_send_ack(struct i2c_gpio_bus *bus, int delay, int ack)
+static void i2c_gpio_send_ack(struct i2c_gpio_bus *bus,
+			      rtems_counter_ticks delay, int ack)
 {
 	i2c_gpio_write_bit(bus, delay, ack);
 	bus->set_scl(bus, 0);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 }
 
 /**
@@ -149,7 +221,8 @@ static void i2c_gpio_send_ack(struct i2c_gpio_bus *bus, int delay, int ack)
  * to clock any confused device back into an idle state.  Also send a
  * <stop> at the end of the sequence for belts & suspenders.
  */
-static void i2c_gpio_send_reset(struct i2c_gpio_bus *bus, int delay)
+static void i2c_gpio_send_reset(struct i2c_gpio_bus *bus,
+				rtems_counter_ticks delay)
 {
 	int j;
 
@@ -160,16 +233,18 @@ static void i2c_gpio_send_reset(struct i2c_gpio_bus *bus, int delay)
 }
 
 /* Set sda high with low clock, before reading slave data */
-static void i2c_gpio_sda_high(struct i2c_gpio_bus *bus, int delay)
+static void i2c_gpio_sda_high(struct i2c_gpio_bus *bus,
+			      rtems_counter_ticks delay)
 {
 	bus->set_scl(bus, 0);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 	bus->set_sda(bus, 1);
-	udelay(delay);
+	i2c_gpio_delay(delay);
 }
 
 /* Send 8 bits and look for an acknowledgement */
-static int i2c_gpio_write_byte(struct i2c_gpio_bus *bus, int delay, uchar data)
+static int i2c_gpio_write_byte(struct i2c_gpio_bus *bus,
+			       rtems_counter_ticks delay, uchar data)
 {
 	int j;
 	int nack;
@@ -179,7 +254,7 @@ static int i2c_gpio_write_byte(struct i2c_gpio_bus *bus, int delay, uchar data)
 		data <<= 1;
 	}
 
-	udelay(delay);
+	i2c_gpio_delay(delay);
 
 	/* Look for an <ACK>(negative logic) and return it */
 	i2c_gpio_sda_high(bus, delay);
@@ -192,7 +267,8 @@ static int i2c_gpio_write_byte(struct i2c_gpio_bus *bus, int delay, uchar data)
  * if ack == I2C_ACK, ACK the byte so can continue reading, else
  * send I2C_NOACK to end the read.
  */
-static uchar i2c_gpio_read_byte(struct i2c_gpio_bus *bus, int delay, int ack)
+static uchar i2c_gpio_read_byte(struct i2c_gpio_bus *bus,
+				rtems_counter_ticks delay, int ack)
 {
 	int  data;
 	int  j;
@@ -209,7 +285,8 @@ static uchar i2c_gpio_read_byte(struct i2c_gpio_bus *bus, int delay, int ack)
 }
 
 /* send start and the slave chip address */
-int i2c_send_slave_addr(struct i2c_gpio_bus *bus, int delay, uchar chip)
+int i2c_send_slave_addr(struct i2c_gpio_bus *bus,
+			rtems_counter_ticks delay, uchar chip)
 {
 	i2c_gpio_send_start(bus, delay);
 
@@ -225,7 +302,7 @@ static int i2c_gpio_write_data(struct i2c_gpio_bus *bus, uchar chip,
 			       uchar *buffer, int len,
 			       bool end_with_repeated_start)
 {
-	unsigned int delay = bus->udelay;
+	rtems_counter_ticks delay = bus->delay;
 	int failures = 0;
 
 	debug("%s: chip %x buffer %p len %d\n", __func__, chip, buffer, len);
@@ -256,7 +333,7 @@ static int i2c_gpio_write_data(struct i2c_gpio_bus *bus, uchar chip,
 static int i2c_gpio_read_data(struct i2c_gpio_bus *bus, uchar chip,
 			      uchar *buffer, int len)
 {
-	unsigned int delay = bus->udelay;
+	rtems_counter_ticks delay = bus->delay;
 
 	debug("%s: chip %x buffer: %p len %d\n", __func__, chip, buffer, len);
 
@@ -294,7 +371,7 @@ static int i2c_gpio_xfer(struct udevice *dev, struct i2c_msg *msg, int nmsgs)
 static int i2c_gpio_probe(struct udevice *dev, uint chip, uint chip_flags)
 {
 	struct i2c_gpio_bus *bus = dev_get_priv(dev);
-	unsigned int delay = bus->udelay;
+	rtems_counter_ticks delay = bus->delay;
 	int ret;
 
 	i2c_gpio_send_start(bus, delay);
@@ -307,29 +384,105 @@ static int i2c_gpio_probe(struct udevice *dev, uint chip, uint chip_flags)
 	return ret;
 }
 
+static void i2c_gpio_update_delay(struct i2c_gpio_bus *bus)
+{
+	rtems_counter_ticks ticks;
+
+	ticks = rtems_counter_nanoseconds_to_ticks(bus->quarter_ns);
+	bus->delay = ticks > bus->toggle ? ticks - bus->toggle : 0;
+}
+
 static int i2c_gpio_set_bus_speed(struct udevice *dev, unsigned int speed_hz)
 {
 	struct i2c_gpio_bus *bus = dev_get_priv(dev);
 
-	bus->udelay = 1000000 / (speed_hz << 2);
+	if (!speed_hz)
+		return -EINVAL;
+
+	bus->quarter_ns = 1000000000 / (speed_hz << 2);
+	i2c_gpio_update_delay(bus);
 
-	i2c_gpio_send_reset(bus, bus->udelay);
+	i2c_gpio_send_reset(bus, bus->delay);
 
 	return 0;
 }
 
+/*
+ * Switch SDA and SCL to direct register access where the GPIO driver allows
+ * it. The output latches are set low first, by briefly driving SCL and then
+ * SDA low, so that switching to output pulls a line down. SDA only changes
+ * while SCL is low, so the bus sees neither a START nor a STOP.
+ */
+static void i2c_gpio_setup_mmio(struct udevice *dev, struct i2c_gpio_bus *bus)
+{
+	struct gpio_desc *sda = &bus->gpios[PIN_SDA];
+	struct gpio_desc *scl = &bus->gpios[PIN_SCL];
+	bool fast_scl;
+
+	if (sda->flags & GPIOD_ACTIVE_LOW ||
+	    dm_gpio_get_mmio(sda, &bus->mmio[PIN_SDA]))
+		return;
+
+	fast_scl = bus->set_scl == i2c_gpio_scl_set &&
+		   !(scl->flags & GPIOD_ACTIVE_LOW) &&
+		   !dm_gpio_get_mmio(scl, &bus->mmio[PIN_SCL]);
+
+	if (fast_scl)
+		dm_gpio_clrset_flags(scl, GPIOD_MASK_DIR, GPIOD_IS_OUT);
+	else
+		bus->set_scl(bus, 0);
+	dm_gpio_clrset_flags(sda, GPIOD_MASK_DIR, GPIOD_IS_OUT);
+	dm_gpio_clrset_flags(sda, GPIOD_MASK_DIR, GPIOD_IS_IN);
+	bus->get_sda = i2c_gpio_mmio_sda_get;
+	bus->set_sda = i2c_gpio_mmio_sda_set;
+	if (fast_scl) {
+		dm_gpio_clrset_flags(scl, GPIOD_MASK_DIR, GPIOD_IS_IN);
+		bus->set_scl = i2c_gpio_mmio_scl_set;
+	} else {
+		bus->set_scl(bus, 1);
+	}
+
+	dev_dbg(dev, "using direct register access%s\n",
+		fast_scl ? "" : " for sda");
+}
+
+/*
+ * Measure the cost of releasing SDA, which the bus is idle with, so that
+ * it can be taken out of each delay. Without this the toggles themselves
+ * would stretch every phase and the bus would run well below the set speed.
+ */
+static void i2c_gpio_calibrate(struct i2c_gpio_bus *bus)
+{
+	rtems_counter_ticks start;
+	int i;
+
+	start = rtems_counter_read();
+	for (i = 0; i < CALIBRATE_LOOPS; i++)
+		bus->set_sda(bus, 1);
+	bus->toggle = rtems_counter_difference(rtems_counter_read(), start) /
+		      CALIBRATE_LOOPS;
+}
+
 static int i2c_gpio_drv_probe(struct udevice *dev)
 {
+	struct i2c_gpio_bus *bus = dev_get_priv(dev);
+	int ret;
+
 	if (dev_read_bool(dev, "i2c-gpio,deblock")) {
 		/* @200kHz 9 clocks = 44us, 62us is ok */
 		const unsigned int DELAY_ABORT_SEQ = 62;
-		struct i2c_gpio_bus *bus = dev_get_priv(dev);
 
-		return i2c_deblock_gpio_loop(&bus->gpios[PIN_SDA],
-					     &bus->gpios[PIN_SCL],
-					     16, 5, DELAY_ABORT_SEQ);
+		ret = i2c_deblock_gpio_loop(&bus->gpios[PIN_SDA],
+					    &bus->gpios[PIN_SCL],
+					    16, 5, DELAY_ABORT_SEQ);
+		if (ret)
+			return ret;
 	}
 
+	i2c_gpio_setup_mmio(dev, bus);
+	i2c_gpio_calibrate(bus);
+	i2c_gpio_update_delay(bus);
+
 	return 0;
 }
 
@@ -343,8 +496,8 @@ static int i2c_gpio_of_to_plat(struct udevice *dev)
 	if (ret < 0)
 		goto error;
 
-	bus->udelay = dev_read_u32_default(dev, "i2c-gpio,delay-us",
-					   DEFAULT_UDELAY);
+	bus->quarter_ns = dev_read_u32_default(dev, "i2c-gpio,delay-us",
+					       DEFAULT_UDELAY) * 1000;
 
 	bus->get_sda = i2c_gpio_sda_get;
 	bus->set_sda = i2c_gpio_sda_set;
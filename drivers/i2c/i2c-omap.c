@@ -16,6 +16,7 @@
  */
 
 #include <rtems.h>
+#include <rtems/thread.h>
 #include <bsp/irq-generic.h>
 
 #include "dm/interrupt.h"
@@ -253,6 +254,14 @@ struct omap_i2c_dev {
 	u16			syscstate;
 	u16			westate;
 	u16			errata;
+	struct i2c_msg		*amsgs;		/* messages of xfer_async() */
+	int			anum;
+	int			aidx;		/* message on the bus */
+	uint			acookie;	/* i2c_xfer_cookie() of it */
+	bool			async;		/* xfer_async() in progress */
+	rtems_mutex		alock;		/* held by the interrupt thread,
+						 * protects the above and @buf
+						 */
 };
 
 static const u8 reg_map_ip_v1[] = {
@@ -694,11 +703,10 @@ static void omap_i2c_resize_fifo(struct omap_i2c_dev *omap, u8 size, bool is_rx)
 }
 
 /*
- * Low level master read/write transaction.
+ * Put a message on the bus, completion is signalled by the interrupt.
  */
-static int omap_i2c_xfer_msg(struct omap_i2c_dev *omap, struct i2c_msg *msg, int stop)
+static int omap_i2c_start_msg(struct omap_i2c_dev *omap, struct i2c_msg *msg, int stop)
 {
-	unsigned long timeout;
 	u16 w;
 
 	dev_dbg(omap->dev, "addr: 0x%04x, len: %d, flags: 0x%x, stop: %d\n",
@@ -771,18 +779,15 @@ static int omap_i2c_xfer_msg(struct omap_i2c_dev *omap, struct i2c_msg *msg, int
 		omap_i2c_write_reg(omap, OMAP_I2C_CON_REG, w);
 	}
 
-	/*
-	 * REVISIT: We should abort the transfer on signals, but the bus goes
-	 * into arbitration and we're currently unable to recover from it.
-	 */
-	timeout = wait_for_completion_timeout(&omap->cmd_complete,
-					      OMAP_I2C_TIMEOUT);
-	if (timeout == 0) {
-		dev_err(omap->dev, "controller timed out\n");
-		omap_i2c_reset(omap);
-		__omap_i2c_init(omap);
-		return -ETIMEDOUT;
-	}
+	return 0;
+}
+
+/*
+ * Result of the message which has just completed.
+ */
+static int omap_i2c_msg_status(struct omap_i2c_dev *omap, struct i2c_msg *msg)
+{
+	u16 w;
 
 	if (likely(!omap->cmd_err))
 		return 0;
@@ -809,6 +814,34 @@ static int omap_i2c_xfer_msg(struct omap_i2c_dev *omap, struct i2c_msg *msg, int
 	return -EIO;
 }
 
+/*
+ * Low level master read/write transaction.
+ */
+static int omap_i2c_xfer_msg(struct omap_i2c_dev *omap, struct i2c_msg *msg, int stop)
+{
+	unsigned long timeout;
+	int r;
+
+	r = omap_i2c_start_msg(omap, msg, stop);
+	if (r)
+		return r;
+
+	/*
+	 * REVISIT: We should abort the transfer on signals, but the bus goes
+	 * into arbitration and we're currently unable to recover from it.
+	 */
+	timeout = wait_for_completion_timeout(&omap->cmd_complete,
+					      OMAP_I2C_TIMEOUT);
+	if (timeout == 0) {
+		dev_err(omap->dev, "controller timed out\n");
+		omap_i2c_reset(omap);
+		__omap_i2c_init(omap);
+		return -ETIMEDOUT;
+	}
+
+	return omap_i2c_msg_status(omap, msg);
+}
+
 
 /*
  * Prepare controller for a transaction and call omap_i2c_xfer_msg
@@ -849,6 +882,95 @@ out:
 	return r;
 }
 
+/*
+ * Start a transaction whose messages are chained from the interrupt
+ * thread, see omap_i2c_async_next().
+ */
+static int
+omap_i2c_xfer_async(struct udevice *bus, struct i2c_msg msgs[], int num)
+{
+	struct omap_i2c_dev *omap = dev_get_priv(bus);
+	int r;
+
+	r = omap_i2c_wait_for_bb_valid(omap);
+	if (r < 0)
+		return r;
+
+	r = omap_i2c_wait_for_bb(omap);
+	if (r < 0)
+		return r;
+
+	if (omap->set_mpu_wkup_lat != NULL)
+		omap->set_mpu_wkup_lat(omap->dev, omap->latency);
+
+	rtems_mutex_lock(&omap->alock);
+	omap->amsgs = msgs;
+	omap->anum = num;
+	omap->aidx = 0;
+	omap->acookie = i2c_xfer_cookie(bus);
+	omap->async = true;
+	r = omap_i2c_start_msg(omap, &msgs[0], num == 1);
+	if (r)
+		omap->async = false;
+	rtems_mutex_unlock(&omap->alock);
+
+	if (r && omap->set_mpu_wkup_lat != NULL)
+		omap->set_mpu_wkup_lat(omap->dev, -1);
+
+	return r;
+}
+
+/*
+ * The caller's messages may live on its stack, so mask the controller and
+ * wait for the interrupt thread to let go of them before returning.
+ */
+static void omap_i2c_xfer_abort(struct udevice *bus)
+{
+	struct omap_i2c_dev *omap = dev_get_priv(bus);
+
+	dev_err(omap->dev, "controller timed out\n");
+	omap_i2c_write_reg(omap, OMAP_I2C_IE_REG, 0);
+	rtems_mutex_lock(&omap->alock);
+	omap->async = false;
+	omap->amsgs = NULL;
+	omap->buf = NULL;
+	omap->buf_len = 0;
+	rtems_mutex_unlock(&omap->alock);
+	omap_i2c_reset(omap);
+	__omap_i2c_init(omap);
+	if (omap->set_mpu_wkup_lat != NULL)
+		omap->set_mpu_wkup_lat(omap->dev, -1);
+}
+
+/*
+ * Called from the interrupt thread, with alock held, when a message of
+ * xfer_async() is done: start the next one, or end the transaction and
+ * return true with its result in @result and its cookie in @cookie.
+ */
+static bool omap_i2c_async_next(struct omap_i2c_dev *omap, int *result,
+				uint *cookie)
+{
+	int r;
+
+	r = omap_i2c_msg_status(omap, &omap->amsgs[omap->aidx]);
+	if (r == 0 && ++omap->aidx < omap->anum) {
+		r = omap_i2c_start_msg(omap, &omap->amsgs[omap->aidx],
+				       omap->aidx == omap->anum - 1);
+		if (r == 0)
+			return false;
+	}
+
+	omap->async = false;
+	omap->amsgs = NULL;
+	omap_i2c_wait_for_bb(omap);
+	if (omap->set_mpu_wkup_lat != NULL)
+		omap->set_mpu_wkup_lat(omap->dev, -1);
+
+	*result = r ? r : omap->anum;
+	*cookie = omap->acookie;
+	return true;
+}
+
 static inline void
 omap_i2c_complete_cmd(struct omap_i2c_dev *omap, u16 err)
 {
@@ -1047,16 +1169,33 @@ static int omap_i2c_transmit_data(struct omap_i2c_dev *omap, u8 num_bytes,
 static void omap_i2c_isr(void *dev_id)
 {
 	struct omap_i2c_dev *omap = dev_id;
+	bool done = false;
+	uint cookie;
+	int result;
 	u16 mask;
 	u16 stat;
 
+	rtems_mutex_lock(&omap->alock);
 	stat = omap_i2c_read_reg(omap, OMAP_I2C_STAT_REG);
 	mask = omap_i2c_read_reg(omap, OMAP_I2C_IE_REG);
 	if (stat & mask) {
         int ret = omap_i2c_xfer_data(omap);
-        if (ret != -EAGAIN)
+        if (ret == -EAGAIN) {
+            rtems_mutex_unlock(&omap->alock);
+            return;
+        }
+        if (omap->async) {
+            omap->cmd_err |= ret;
+            done = omap_i2c_async_next(omap, &result, &cookie);
+        } else {
             omap_i2c_complete_cmd(omap, ret);
+        }
     }
+	rtems_mutex_unlock(&omap->alock);
+
+	/* Unlocked, this may start the next queued transaction */
+	if (done)
+		i2c_xfer_complete(omap->dev, cookie, result);
 }
 
 static int omap_i2c_xfer_data(struct omap_i2c_dev *omap)
@@ -1279,6 +1418,7 @@ static int omap_i2c_probe(struct udevice *pdev)
 	omap->flags = pdata->flags;
 	omap->dev = pdev;
 	init_completion(&omap->cmd_complete);
+	rtems_mutex_init(&omap->alock, "omap i2c");
 	omap->reg_shift = (omap->flags >> OMAP_I2C_FLAG_BUS_SHIFT__SHIFT) & 3;
 
 	/*
@@ -1381,6 +1521,8 @@ static int omap_i2c_remove(struct udevice *dev)
 
 static const struct dm_i2c_ops omap_i2c_ops = {
 	.xfer		= omap_i2c_xfer,
+	.xfer_async	= omap_i2c_xfer_async,
+	.xfer_abort	= omap_i2c_xfer_abort,
 	.set_bus_speed	= omap_i2c_bus_speed,
 };
 
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sandbox I2C controller with an emulated EEPROM
+ *
+ * Transfers never leave the CPU, so the time spent in dm_i2c_xfer() is the
+ * cost of the uclass stack plus a memcpy(). The EEPROM behaves like a 24Cxx
+ * part: a write sets the address pointer from its first offset_len bytes
+ * and stores the rest, a read continues from the pointer. Both wrap at the
+ * end of the array. Any other chip address is not acknowledged.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtems/malloc.h>
+
+#include <common.h>
+#include <dm.h>
+#include <dm/i2c.h>
+#include <dm/read.h>
+#include <dm/platdata.h>
+#include <dm/platform_data/sandbox_bus.h>
+
+struct sandbox_i2c_priv {
+	u8 *eeprom;
+	uint ptr;
+};
+
+static void sandbox_i2c_copy(struct sandbox_i2c_plat *plat,
+			     struct sandbox_i2c_priv *priv, u8 *buf, int len,
+			     bool read)
+{
+	int n;
+
+	while (len) {
+		n = min(len, (int)(plat->eeprom_size - priv->ptr));
+		if (read)
+			memcpy(buf, priv->eeprom + priv->ptr, n);
+		else
+			memcpy(priv->eeprom + priv->ptr, buf, n);
+		priv->ptr = (priv->ptr + n) % plat->eeprom_size;
+		buf += n;
+		len -= n;
+	}
+}
+
+static int sandbox_i2c_xfer(struct udevice *bus, struct i2c_msg *msg,
+			    int nmsgs)
+{
+	struct sandbox_i2c_plat *plat = dev_get_plat(bus);
+	struct sandbox_i2c_priv *priv = dev_get_priv(bus);
+	int i, n, len;
+
+	for (; nmsgs > 0; nmsgs--, msg++) {
+		if (msg->addr != plat->eeprom_addr) {
+			if (msg->flags & I2C_M_IGNORE_NAK)
+				continue;
+			return -EREMOTEIO;
+		}
+
+		if (msg->flags & I2C_M_RD) {
+			sandbox_i2c_copy(plat, priv, msg->buf, msg->len, true);
+			continue;
+		}
+
+		n = min((int)msg->len, (int)plat->offset_len);
+		if (n) {
+			priv->ptr = 0;
+			for (i = 0; i < n; i++)
+				priv->ptr = priv->ptr << 8 | msg->buf[i];
+			priv->ptr %= plat->eeprom_size;
+		}
+		len = msg->len - n;
+		if (len)
+			sandbox_i2c_copy(plat, priv, msg->buf + n, len, false);
+	}
+
+	return 0;
+}
+
+static int sandbox_i2c_probe_chip(struct udevice *bus, uint chip_addr,
+				  uint chip_flags)
+{
+	struct sandbox_i2c_plat *plat = dev_get_plat(bus);
+
+	return chip_addr == plat->eeprom_addr ? 0 : -EREMOTEIO;
+}
+
+static int sandbox_i2c_set_bus_speed(struct udevice *bus, unsigned int speed)
+{
+	return 0;
+}
+
+static int sandbox_i2c_of_to_plat(struct udevice *bus)
+{
+	struct sandbox_i2c_plat *plat = dev_get_plat(bus);
+
+	if (!dev_has_ofnode(bus))
+		return 0;
+
+	plat->eeprom_addr = dev_read_u32_default(bus, "eeprom-addr",
+						 SANDBOX_I2C_EEPROM_ADDR);
+	plat->eeprom_size = dev_read_u32_default(bus, "eeprom-size",
+						 SANDBOX_I2C_EEPROM_SIZE);
+	plat->offset_len = dev_read_u32_default(bus, "offset-len", 1);
+
+	return 0;
+}
+
+static int sandbox_i2c_probe(struct udevice *bus)
+{
+	struct sandbox_i2c_plat *plat = dev_get_plat(bus);
+	struct sandbox_i2c_priv *priv = dev_get_priv(bus);
+
+	if (!plat->eeprom_size || plat->offset_len > 4)
+		return -EINVAL;
+
+	priv->eeprom = rtems_malloc(plat->eeprom_size);
+	if (!priv->eeprom)
+		return -ENOMEM;
+	memset(priv->eeprom, 0xff, plat->eeprom_size);
+
+	return 0;
+}
+
+static int sandbox_i2c_remove(struct udevice *bus)
+{
+	struct sandbox_i2c_priv *priv = dev_get_priv(bus);
+
+	free(priv->eeprom);
+	priv->eeprom = NULL;
+
+	return 0;
+}
+
+static const struct dm_i2c_ops sandbox_i2c_ops = {
+	.xfer		= sandbox_i2c_xfer,
+	.probe_chip	= sandbox_i2c_probe_chip,
+	.set_bus_speed	= sandbox_i2c_set_bus_speed,
+};
+
+static const struct udevice_id sandbox_i2c_ids[] = {
+	{ .compatible = "sandbox,i2c" },
+	{ }
+};
+
+DM_DRIVER(sandbox_i2c) = {
+	.name		= "sandbox_i2c",
+	.id		= UCLASS_I2C,
+	.of_match	= sandbox_i2c_ids,
+	.of_to_plat	= sandbox_i2c_of_to_plat,
+	.probe		= sandbox_i2c_probe,
+	.remove		= sandbox_i2c_remove,
+	.plat_auto	= sizeof(struct sandbox_i2c_plat),
+	.priv_auto	= sizeof(struct sandbox_i2c_priv),
+	.ops		= &sandbox_i2c_ops,
+};
+
+#if defined(CONFIG_SANDBOX_BUS) && !CONFIG_IS_ENABLED(OF_PLATDATA)
+static struct sandbox_i2c_plat sandbox_i2c_plat = {
+	.eeprom_addr	= SANDBOX_I2C_EEPROM_ADDR,
+	.eeprom_size	= SANDBOX_I2C_EEPROM_SIZE,
+	.offset_len	= 1,
+};
+
+U_BOOT_DRVINFO(sandbox_i2c) = {
+	.name	= "sandbox_i2c",
+	.plat	= &sandbox_i2c_plat,
+};
+#endif
@@ -20,6 +20,12 @@
 
 #define I2C_MAX_OFFSET_LEN	4
 
+/* Longest wait for a queued transfer before the bus is reset */
+#define I2C_XFER_TIMEOUT_MS	1000
+
+/* Bytes read per transaction from chips needing the address for each */
+#define I2C_BYTEWISE_BATCH	8
+
 enum {
 	PIN_SDA = 0,
 	PIN_SCL,
@@ -73,12 +79,195 @@ static int i2c_setup_offset(struct dm_i2c_chip *chip, uint offset,
 	return 0;
 }
 
+/**
+ * i2c_xfer_start() - Start queued transactions while the bus is idle
+ *
+ * @bus:	Bus to use
+ */
+static void i2c_xfer_start(struct udevice *bus)
+{
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
+	struct dm_i2c_ops *ops = i2c_get_ops(bus);
+	rtems_interrupt_lock_context ctx;
+	struct i2c_xfer *xfer;
+	int ret;
+
+	for (;;) {
+		rtems_interrupt_lock_acquire(&i2c->qlock, &ctx);
+		if (i2c->active || i2c->hold || list_empty(&i2c->queue)) {
+			rtems_interrupt_lock_release(&i2c->qlock, &ctx);
+			return;
+		}
+		xfer = list_first_entry(&i2c->queue, struct i2c_xfer, node);
+		list_del_init(&xfer->node);
+		i2c->active = xfer;
+		i2c->cookie++;
+		rtems_interrupt_lock_release(&i2c->qlock, &ctx);
+
+		ret = ops->xfer_async(bus, xfer->msgs, xfer->nmsgs);
+		if (!ret)
+			return;
+
+		rtems_interrupt_lock_acquire(&i2c->qlock, &ctx);
+		i2c->active = NULL;
+		rtems_interrupt_lock_release(&i2c->qlock, &ctx);
+		xfer->result = ret;
+		if (xfer->done)
+			xfer->done(xfer);
+	}
+}
+
+uint i2c_xfer_cookie(struct udevice *bus)
+{
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
+
+	return i2c->cookie;
+}
+
+void i2c_xfer_complete(struct udevice *bus, uint cookie, int result)
+{
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
+	rtems_interrupt_lock_context ctx;
+	struct i2c_xfer *xfer = NULL;
+
+	rtems_interrupt_lock_acquire(&i2c->qlock, &ctx);
+	/* A transfer aborted on timeout may still report in late */
+	if (cookie == i2c->cookie) {
+		xfer = i2c->active;
+		i2c->active = NULL;
+	}
+	rtems_interrupt_lock_release(&i2c->qlock, &ctx);
+	if (!xfer)
+		return;
+
+	/* Keep the bus busy before handing the result back */
+	i2c_xfer_start(bus);
+	xfer->result = result;
+	if (xfer->done)
+		xfer->done(xfer);
+}
+
+int dm_i2c_xfer_async(struct udevice *bus, struct i2c_xfer *xfer)
+{
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
+	struct dm_i2c_ops *ops = i2c_get_ops(bus);
+	rtems_interrupt_lock_context ctx;
+
+	if (!ops->xfer_async) {
+		if (!ops->xfer)
+			return -ENOSYS;
+		xfer->result = dm_i2c_xfer(bus, xfer->msgs, xfer->nmsgs);
+		if (xfer->done)
+			xfer->done(xfer);
+		return 0;
+	}
+
+	rtems_interrupt_lock_acquire(&i2c->qlock, &ctx);
+	list_add_tail(&xfer->node, &i2c->queue);
+	rtems_interrupt_lock_release(&i2c->qlock, &ctx);
+	i2c_xfer_start(bus);
+
+	return 0;
+}
+
+/* Let queued transactions run again after i2c_xfer_hold() */
+static void i2c_xfer_release(struct udevice *bus)
+{
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
+	rtems_interrupt_lock_context ctx;
+
+	rtems_interrupt_lock_acquire(&i2c->qlock, &ctx);
+	i2c->hold = false;
+	rtems_interrupt_lock_release(&i2c->qlock, &ctx);
+	i2c_xfer_start(bus);
+}
+
+/*
+ * Keep queued transactions from starting and wait for the one on the bus,
+ * so that the controller can be reprogrammed
+ */
+static int i2c_xfer_hold(struct udevice *bus)
+{
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
+	rtems_interrupt_lock_context ctx;
+	rtems_interval end;
+	bool busy;
+
+	end = rtems_clock_tick_later(
+		RTEMS_MILLISECONDS_TO_TICKS(I2C_XFER_TIMEOUT_MS));
+	for (;;) {
+		rtems_interrupt_lock_acquire(&i2c->qlock, &ctx);
+		i2c->hold = true;
+		busy = i2c->active != NULL;
+		rtems_interrupt_lock_release(&i2c->qlock, &ctx);
+		if (!busy)
+			return 0;
+		if (!rtems_clock_tick_before(end))
+			break;
+		rtems_task_wake_after(1);
+	}
+
+	i2c_xfer_release(bus);
+	return -EBUSY;
+}
+
+static void i2c_xfer_wake(struct i2c_xfer *xfer)
+{
+	rtems_binary_semaphore_post(xfer->priv);
+}
+
+/* Run a transfer through the bus queue and wait for it */
+static int i2c_xfer_queued(struct udevice *bus, struct i2c_msg *msg,
+			   int nmsgs)
+{
+	struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
+	struct dm_i2c_ops *ops = i2c_get_ops(bus);
+	rtems_binary_semaphore done = RTEMS_BINARY_SEMAPHORE_INITIALIZER("i2c");
+	rtems_interrupt_lock_context ctx;
+	struct i2c_xfer xfer = {
+		.msgs	= msg,
+		.nmsgs	= nmsgs,
+		.done	= i2c_xfer_wake,
+		.priv	= &done,
+	};
+	bool active, queued;
+
+	dm_i2c_xfer_async(bus, &xfer);
+	while (rtems_binary_semaphore_wait_timed_ticks(&done,
+			RTEMS_MILLISECONDS_TO_TICKS(I2C_XFER_TIMEOUT_MS))) {
+		rtems_interrupt_lock_acquire(&i2c->qlock, &ctx);
+		active = i2c->active == &xfer;
+		queued = !active && !list_empty(&xfer.node);
+		if (active)
+			i2c->active = NULL;
+		else if (queued)
+			list_del_init(&xfer.node);
+		rtems_interrupt_lock_release(&i2c->qlock, &ctx);
+
+		/* Otherwise it completed just now and @done is posted */
+		if (active || queued) {
+			dev_err(bus, "transfer timed out\n");
+			if (active) {
+				ops->xfer_abort(bus);
+				i2c_xfer_start(bus);
+			}
+			xfer.result = -ETIMEDOUT;
+			break;
+		}
+	}
+	rtems_binary_semaphore_destroy(&done);
+
+	return xfer.result;
+}
+
 int dm_i2c_xfer(struct udevice *bus, struct i2c_msg *msg, int nmsgs)
 {
     struct dm_i2c_bus *i2c = dev_get_uclass_priv(bus);
 	struct dm_i2c_ops *ops = i2c_get_ops(bus);
     int ret;
     
+	if (ops->xfer_async)
+		return i2c_xfer_queued(bus, msg, nmsgs);
 	if (!ops->xfer)
 		return -ENOSYS;
     
@@ -88,28 +277,36 @@ int dm_i2c_xfer(struct udevice *bus, struct i2c_msg *msg, int nmsgs)
     return ret;
 }
 
+/*
+ * The chip needs its address before every byte, but the bytes are still
+ * read in batches of one transaction, with a stop after each byte as if
+ * they had been read one by one.
+ */
 static int i2c_read_bytewise(struct udevice *dev, uint offset,
 			     uint8_t *buffer, int len)
 {
 	struct dm_i2c_chip *chip = dev_get_parent_plat(dev);
 	struct udevice *bus = dev_get_parent(dev);
-	struct i2c_msg msg[2], *ptr;
-	uint8_t offset_buf[I2C_MAX_OFFSET_LEN];
+	struct i2c_msg msg[2 * I2C_BYTEWISE_BATCH], *ptr;
+	uint8_t offset_buf[I2C_BYTEWISE_BATCH][I2C_MAX_OFFSET_LEN];
 	int ret;
-	int i;
-
-	for (i = 0; i < len; i++) {
-		if (i2c_setup_offset(chip, offset + i, offset_buf, msg))
-			return -EINVAL;
-		ptr = msg + 1;
-		ptr->addr = msg->addr;
-		ptr->flags = msg->flags | I2C_M_RD;
-		ptr->len = 1;
-		ptr->buf = &buffer[i];
-		ptr++;
+	int i, n;
+
+	for (i = 0; i < len; i += n) {
+		ptr = msg;
+		for (n = 0; n < I2C_BYTEWISE_BATCH && i + n < len; n++) {
+			if (i2c_setup_offset(chip, offset + i + n,
+					     offset_buf[n], ptr))
+				return -EINVAL;
+			ptr[1].addr = ptr->addr;
+			ptr[1].flags = ptr->flags | I2C_M_RD | I2C_M_STOP;
+			ptr[1].len = 1;
+			ptr[1].buf = &buffer[i + n];
+			ptr += 2;
+		}
 
 		ret = dm_i2c_xfer(bus, msg, ptr - msg);
-		if (ret)
+		if (ret < 0)
 			return ret;
 	}
 
@@ -398,12 +595,20 @@ int dm_i2c_set_bus_speed(struct udevice *bus, unsigned int speed)
 	 * the current speed from this uclass
 	 */
 	rtems_mutex_lock(&i2c->lock);
+	if (ops->xfer_async) {
+		ret = i2c_xfer_hold(bus);
+		if (ret)
+			goto _out;
+	}
 	if (ops->set_bus_speed) {
 		ret = ops->set_bus_speed(bus, speed);
 		if (ret)
-			goto _out;
+			goto _release;
 	}
 	i2c->speed_hz = speed;
+_release:
+	if (ops->xfer_async)
+		i2c_xfer_release(bus);
 _out:
     rtems_mutex_unlock(&i2c->lock);
 	return ret;
@@ -634,6 +839,8 @@ static int i2c_pre_probe(struct udevice *dev)
 	int ret;
 
     rtems_mutex_init(&i2c->lock, dev->name);
+	INIT_LIST_HEAD(&i2c->queue);
+	rtems_interrupt_lock_initialize(&i2c->qlock, dev->name);
 	i2c->max_transaction_bytes = 0;
 	dev_for_each_subnode(node, dev) {
 		ret = ofnode_read_u32(node,
@@ -14,23 +14,21 @@ static int of_gic_irq_translate(const struct of_phandle_args *ofirq,
 		*type = IRQ_TYPE_EDGE_RISING;
 		return 0;
 	}
-	if (ofirq->np) {
-		if (ofirq->args_count < 3)
-			return -EINVAL;
-		switch (ofirq->args[0]) {
-		case 0:			/* SPI */
-			*hwirq = ofirq->args[1] + 32;
-			break;
-		case 1:			/* PPI */
-			*hwirq = ofirq->args[1] + 16;
-			break;
-		default:
-			return -EINVAL;
-		}
-		*type = ofirq->args[2] & 0xF;
-		return 0;
+	/* No node for cells from of-platdata, see of_irq_translate_cells() */
+	if (ofirq->args_count < 3)
+		return -EINVAL;
+	switch (ofirq->args[0]) {
+	case 0:			/* SPI */
+		*hwirq = ofirq->args[1] + 32;
+		break;
+	case 1:			/* PPI */
+		*hwirq = ofirq->args[1] + 16;
+		break;
+	default:
+		return -EINVAL;
 	}
-	return -EINVAL;
+	*type = ofirq->args[2] & 0xF;
+	return 0;
 }
 
 static const struct udevice_id ids[] = {
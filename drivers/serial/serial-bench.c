@@ -0,0 +1,201 @@
+/*
+ * Serial transmit benchmark
+ *
+ * Sends the same buffer through /dev/ttySx (termios) and through the raw
+ * channel of the same port and reports how long the writer was busy and
+ * how long the data took to leave the FIFO. At a given baud rate the totals
+ * are close; the difference shows up in the time spent in the write call
+ * and in how far the port gets from line rate at high baud rates. The port
+ * must not be the console.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <rtems/counter.h>
+#include <rtems/shell.h>
+#include <rtems/sysinit.h>
+
+#include "common.h"
+#include "dm.h"
+#include "dm/serial.h"
+
+#define SERBENCH_HELP \
+    "Serial raw channel vs termios transmit benchmark\n" \
+    "\n" \
+    "serbench [-n][--bytes <count>] [-b][--baud <rate>] <seq>\n"
+
+#define SERBENCH_BYTES 16384
+#define SERBENCH_BAUD  B115200
+#define SERBENCH_RING  4096
+
+struct serbench_result {
+    uint64_t write_ns;
+    uint64_t total_ns;
+};
+
+static uint64_t serbench_ns(rtems_counter_ticks start)
+{
+    return rtems_counter_ticks_to_nanoseconds(
+        rtems_counter_difference(rtems_counter_read(), start));
+}
+
+static int serbench_termios(const char *path, const struct termios *tm,
+    const char *buf, size_t len, struct serbench_result *res)
+{
+    rtems_counter_ticks start;
+    size_t done = 0;
+    ssize_t n;
+    int fd, ret = 0;
+
+    fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return -errno;
+    if (tcsetattr(fd, TCSANOW, tm) < 0) {
+        ret = -errno;
+        goto out;
+    }
+
+    start = rtems_counter_read();
+    while (done < len) {
+        n = write(fd, buf + done, len - done);
+        if (n < 0) {
+            ret = -errno;
+            goto out;
+        }
+        done += n;
+    }
+    res->write_ns = serbench_ns(start);
+    tcdrain(fd);
+    res->total_ns = serbench_ns(start);
+out:
+    close(fd);
+    return ret;
+}
+
+static int serbench_raw(struct udevice *dev, const struct termios *tm,
+    const char *buf, size_t len, struct serbench_result *res)
+{
+    rtems_counter_ticks start;
+    ssize_t n;
+    int ret;
+
+    ret = serial_raw_open(dev, SERBENCH_RING, SERBENCH_RING, tm);
+    if (ret)
+        return ret;
+
+    start = rtems_counter_read();
+    n = serial_raw_write(dev, buf, len, SERIAL_RAW_FOREVER);
+    res->write_ns = serbench_ns(start);
+    ret = serial_raw_drain(dev, SERIAL_RAW_FOREVER);
+    res->total_ns = serbench_ns(start);
+    if (n >= 0 && (size_t)n != len)
+        ret = -EIO;
+    else if (n < 0)
+        ret = n;
+
+    serial_raw_close(dev);
+    return ret;
+}
+
+static void serbench_print(const char *name, size_t len, int ret,
+    const struct serbench_result *res)
+{
+    if (ret) {
+        printf("%-8s failed: %d\n", name, ret);
+        return;
+    }
+    printf("%-8s %8zu %12llu %12llu %10llu\n", name, len,
+        (unsigned long long)(res->write_ns / 1000),
+        (unsigned long long)(res->total_ns / 1000),
+        res->total_ns ?
+        (unsigned long long)(len * 1000000000ULL / res->total_ns) : 0ULL);
+}
+
+static int shell_main_serbench(int argc, char *argv[])
+{
+    struct serbench_result res;
+    struct termios tm;
+    struct udevice *dev;
+    size_t len = SERBENCH_BYTES;
+    speed_t baud = SERBENCH_BAUD;
+    char path[16];
+    char *buf;
+    int seq = -1;
+    int ret;
+
+    for (int i = 1; i < argc; i++) {
+        if ((!strcmp(argv[i], "--bytes") ||
+            !strcmp(argv[i], "-n")) && i + 1 < argc) {
+            len = strtoul(argv[++i], NULL, 0);
+        } else if ((!strcmp(argv[i], "--baud") ||
+            !strcmp(argv[i], "-b")) && i + 1 < argc) {
+            baud = rtems_termios_number_to_baud(strtoul(argv[++i], NULL, 0));
+        } else if (seq < 0 && argv[i][0] != '-') {
+            seq = strtoul(argv[i], NULL, 0);
+        } else {
+            seq = -1;
+            break;
+        }
+    }
+    if (seq < 0 || len == 0 || baud == 0) {
+        puts(SERBENCH_HELP);
+        return -EINVAL;
+    }
+
+    ret = uclass_get_device_by_seq(UCLASS_SERIAL, seq, &dev);
+    if (ret) {
+        printf("serial %d not available: %d\n", seq, ret);
+        return ret;
+    }
+
+    buf = malloc(len);
+    if (!buf)
+        return -ENOMEM;
+    for (size_t i = 0; i < len; i++)
+        buf[i] = 'a' + i % 26;
+
+    memset(&tm, 0, sizeof(tm));
+    cfmakeraw(&tm);
+    tm.c_cflag |= CLOCAL | CREAD;
+    cfsetspeed(&tm, baud);
+
+    snprintf(path, sizeof(path), "/dev/ttyS%d", seq);
+    printf("%-8s %8s %12s %12s %10s\n", "Path", "Bytes", "write us",
+        "total us", "B/s");
+
+    /* The raw open also refuses the console, so try it first */
+    memset(&res, 0, sizeof(res));
+    ret = serbench_raw(dev, &tm, buf, len, &res);
+    serbench_print("raw", len, ret, &res);
+    if (ret != -EBUSY) {
+        memset(&res, 0, sizeof(res));
+        ret = serbench_termios(path, &tm, buf, len, &res);
+        serbench_print("termios", len, ret, &res);
+    }
+
+    free(buf);
+    return 0;
+}
+
+static void shell_serbench_register(void)
+{
+    static rtems_shell_cmd_t shell_serbench_command = {
+        "serbench",                      /* name */
+        SERBENCH_HELP,                   /* usage */
+        "rtems",                         /* topic */
+        shell_main_serbench,             /* command */
+        NULL,                            /* aliass */
+        NULL                             /* next */
+    };
+
+    rtems_shell_add_cmd_struct(&shell_serbench_command);
+}
+
+RTEMS_SYSINIT_ITEM(shell_serbench_register,
+    RTEMS_SYSINIT_LAST,
+    RTEMS_SYSINIT_ORDER_MIDDLE);
@@ -3,21 +3,52 @@
  * Copyright (c) 2014 The Chromium OS Authors.
  */
 #include <errno.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <stdlib.h>
+#include <rtems.h>
 #include <rtems/malloc.h>
 #include <rtems/sysinit.h>
+#include <rtems/thread.h>
 
 #include "common.h"
 #include "dm.h"
 #include "dm/device.h"
 #include "dm/device-internal.h"
 #include "dm/of_access.h"
+#include "dm/read.h"
 #include "dm/serial.h"
 
 
 #define SERIAL_DEFAULT_BDR 115200 
 
+/*
+ * Single producer, single consumer byte ring. @head is only written by the
+ * producer and @tail only by the consumer, so neither side takes a lock.
+ */
+struct serial_ring {
+    char *buf;
+    size_t mask;
+    atomic_size_t head;
+    atomic_size_t tail;
+};
+
+/*
+ * Raw channel state. The receive ring is filled by the ISR and drained by
+ * serial_raw_read(), the transmit ring is filled by serial_raw_write() and
+ * fed to the FIFO straight from the ring by the ISR.
+ */
+struct serial_raw {
+    struct serial_ring rx;
+    struct serial_ring tx;
+    size_t current;
+    bool txbusy;
+    atomic_bool closing;
+    uint32_t overruns;
+    rtems_binary_semaphore rx_wait;
+    rtems_binary_semaphore tx_wait;
+};
+
 struct serial_class {   
     rtems_termios_device_context base;
     rtems_termios_tty *tty;
@@ -28,16 +59,116 @@ struct serial_class {
     size_t remaining;
     size_t current;
     bool txintr;
+    bool opened;
+    struct serial_fifo_cfg fifo;
+    struct serial_raw *_Atomic raw;
+    atomic_int raw_users;
 };
 
 static struct udevice *serial_console;
 
 
+static size_t serial_ring_put(struct serial_ring *r, const char *buf,
+    size_t len)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    size_t space = r->mask + 1 - (head - tail);
+    size_t first;
+
+    if (len > space)
+        len = space;
+    first = r->mask + 1 - (head & r->mask);
+    if (first > len)
+        first = len;
+    memcpy(r->buf + (head & r->mask), buf, first);
+    memcpy(r->buf, buf + first, len - first);
+    atomic_store_explicit(&r->head, head + len, memory_order_release);
+    return len;
+}
+
+static size_t serial_ring_get(struct serial_ring *r, char *buf, size_t len)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    size_t first;
+
+    if (len > head - tail)
+        len = head - tail;
+    first = r->mask + 1 - (tail & r->mask);
+    if (first > len)
+        first = len;
+    memcpy(buf, r->buf + (tail & r->mask), first);
+    memcpy(buf + first, r->buf, len - first);
+    atomic_store_explicit(&r->tail, tail + len, memory_order_release);
+    return len;
+}
+
+/* Contiguous bytes readable in place at the tail of the ring */
+static size_t serial_ring_peek(struct serial_ring *r, const char **bufp)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    size_t len = r->mask + 1 - (tail & r->mask);
+
+    if (len > head - tail)
+        len = head - tail;
+    *bufp = r->buf + (tail & r->mask);
+    return len;
+}
+
+static void serial_ring_skip(struct serial_ring *r, size_t len)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&r->tail, tail + len, memory_order_release);
+}
+
+/* Must be called with the device lock held */
+static void serial_raw_tx_next(struct serial_class *platdata,
+    const struct dm_serial_ops *ops)
+{
+    struct serial_raw *raw = platdata->raw;
+    const char *buf;
+    size_t len;
+
+    len = serial_ring_peek(&raw->tx, &buf);
+    if (len == 0) {
+        raw->current = 0;
+        raw->txbusy = false;
+        ops->tx_irqdis(platdata->dev);
+        return;
+    }
+    raw->current = ops->fill_fifo(platdata->dev, buf, len);
+}
+
+static void serial_raw_dequeue(struct serial_class *platdata,
+    const struct dm_serial_ops *ops)
+{
+    struct serial_raw *raw = platdata->raw;
+    rtems_interrupt_lock_context ctx;
+
+    rtems_termios_device_lock_acquire(&platdata->base, &ctx);
+    if (raw->txbusy && ops->tx_empty(platdata->dev)) {
+        serial_ring_skip(&raw->tx, raw->current);
+        serial_raw_tx_next(platdata, ops);
+        rtems_binary_semaphore_post(&raw->tx_wait);
+    }
+    rtems_termios_device_lock_release(&platdata->base, &ctx);
+}
 
 int serial_class_enqueue(struct udevice *dev, const char *buf, int len)
 {
     struct serial_class *platdata = dev_get_uclass_plat(dev);
-
+    struct serial_raw *raw = platdata->raw;
+    size_t n;
+
+    if (raw != NULL) {
+        n = serial_ring_put(&raw->rx, buf, len);
+        raw->overruns += len - n;
+        rtems_binary_semaphore_post(&raw->rx_wait);
+        return n;
+    }
     return rtems_termios_enqueue_raw_characters(platdata->tty, buf, len);
 }
 
@@ -47,6 +178,10 @@ int serial_class_dequeue(struct udevice *dev)
     const struct dm_serial_ops *ops = serial_get_ops(dev);
     int ret = 0;
 
+    if (platdata->raw != NULL) {
+        serial_raw_dequeue(platdata, ops);
+        return 0;
+    }
     if (platdata->total && ops->tx_empty(dev)) {
         size_t current = platdata->current;
         platdata->buf += current;
@@ -63,6 +198,13 @@ int serial_class_dequeue(struct udevice *dev)
     return ret;
 }
 
+const struct serial_fifo_cfg *serial_class_fifo_cfg(struct udevice *dev)
+{
+    struct serial_class *platdata = dev_get_uclass_plat(dev);
+
+    return &platdata->fifo;
+}
+
 static void serial_class_txintr_enable(struct serial_class *platdata,
     const struct dm_serial_ops *ops)
 {
@@ -97,9 +239,12 @@ static bool serial_class_open(struct rtems_termios_tty *tty,
         struct serial_class, base);
     const struct dm_serial_ops *ops = serial_get_ops(platdata->dev);
 
+    if (platdata->raw != NULL)
+        return false;
     platdata->tty = tty;
     rtems_termios_set_initial_baud(tty, SERIAL_DEFAULT_BDR); // class default baudrate
-    return !ops->open(platdata->dev);
+    platdata->opened = !ops->open(platdata->dev);
+    return platdata->opened;
 }
 
 static void serial_class_close(struct rtems_termios_tty *tty,
@@ -112,6 +257,7 @@ static void serial_class_close(struct rtems_termios_tty *tty,
     const struct dm_serial_ops *ops = serial_get_ops(platdata->dev);
 
     ops->release(platdata->dev);
+    platdata->opened = false;
 }
 
 static void serial_class_putc_poll(rtems_termios_device_context *base, 
@@ -194,6 +340,208 @@ static const rtems_termios_device_handler serial_termios_ops = {
     .mode           = TERMIOS_IRQ_DRIVEN
 };
 
+static bool serial_raw_size_valid(size_t size)
+{
+    return size >= 2 && (size & (size - 1)) == 0;
+}
+
+int serial_raw_open(struct udevice *dev, size_t rx_size, size_t tx_size,
+    const struct termios *tm)
+{
+    struct serial_class *platdata = dev_get_uclass_plat(dev);
+    const struct dm_serial_ops *ops;
+    struct serial_raw *raw;
+    int ret;
+
+    if (platdata == NULL)
+        return -ENODEV;
+    if (!serial_raw_size_valid(rx_size) || !serial_raw_size_valid(tx_size))
+        return -EINVAL;
+    if (platdata->raw != NULL || platdata->opened || dev == serial_console)
+        return -EBUSY;
+
+    raw = rtems_calloc(1, sizeof(*raw) + rx_size + tx_size);
+    if (raw == NULL)
+        return -ENOMEM;
+    raw->rx.buf = (char *)(raw + 1);
+    raw->rx.mask = rx_size - 1;
+    raw->tx.buf = raw->rx.buf + rx_size;
+    raw->tx.mask = tx_size - 1;
+    rtems_binary_semaphore_init(&raw->rx_wait, "serial raw rx");
+    rtems_binary_semaphore_init(&raw->tx_wait, "serial raw tx");
+
+    /* Received bytes must find the ring as soon as the port is up */
+    ops = serial_get_ops(dev);
+    platdata->raw = raw;
+    ret = ops->open(dev);
+    if (ret == 0 && tm != NULL)
+        ret = ops->set_termios(dev, tm);
+    if (ret) {
+        ops->release(dev);
+        platdata->raw = NULL;
+        rtems_binary_semaphore_destroy(&raw->rx_wait);
+        rtems_binary_semaphore_destroy(&raw->tx_wait);
+        free(raw);
+    }
+    return ret;
+}
+
+int serial_raw_close(struct udevice *dev)
+{
+    struct serial_class *platdata = dev_get_uclass_plat(dev);
+    const struct dm_serial_ops *ops = serial_get_ops(dev);
+    rtems_interrupt_lock_context ctx;
+    struct serial_raw *raw;
+
+    if (platdata == NULL || platdata->raw == NULL)
+        return -EINVAL;
+
+    /* No writer starts the transmitter again once this is set */
+    raw = platdata->raw;
+    rtems_termios_device_lock_acquire(&platdata->base, &ctx);
+    atomic_store(&raw->closing, true);
+    rtems_termios_device_lock_release(&platdata->base, &ctx);
+    ops->release(dev);
+    platdata->raw = NULL;
+
+    /* Fail the readers and writers still blocked on the channel */
+    while (atomic_load(&platdata->raw_users) > 0) {
+        rtems_binary_semaphore_post(&raw->rx_wait);
+        rtems_binary_semaphore_post(&raw->tx_wait);
+        rtems_task_wake_after(1);
+    }
+    rtems_binary_semaphore_destroy(&raw->rx_wait);
+    rtems_binary_semaphore_destroy(&raw->tx_wait);
+    free(raw);
+    return 0;
+}
+
+/*
+ * Pin the raw channel for a read or write. serial_raw_close() clears the
+ * pointer before it looks at the user count, so either it sees this user
+ * or the user sees no channel.
+ */
+static struct serial_raw *serial_raw_get(struct serial_class *platdata)
+{
+    struct serial_raw *raw;
+
+    atomic_fetch_add(&platdata->raw_users, 1);
+    raw = platdata->raw;
+    if (raw == NULL)
+        atomic_fetch_sub(&platdata->raw_users, 1);
+    return raw;
+}
+
+static void serial_raw_put(struct serial_class *platdata)
+{
+    atomic_fetch_sub(&platdata->raw_users, 1);
+}
+
+static int serial_raw_wait(rtems_binary_semaphore *sem, rtems_interval timeout)
+{
+    if (timeout == SERIAL_RAW_FOREVER) {
+        rtems_binary_semaphore_wait(sem);
+        return 0;
+    }
+    if (rtems_binary_semaphore_wait_timed_ticks(sem, timeout))
+        return -ETIMEDOUT;
+    return 0;
+}
+
+ssize_t serial_raw_read(struct udevice *dev, void *buf, size_t len,
+    rtems_interval timeout)
+{
+    struct serial_class *platdata = dev_get_uclass_plat(dev);
+    struct serial_raw *raw = serial_raw_get(platdata);
+    ssize_t n;
+
+    if (raw == NULL)
+        return -EINVAL;
+
+    n = serial_ring_get(&raw->rx, buf, len);
+    while (n == 0 && len > 0 && timeout != 0) {
+        if (serial_raw_wait(&raw->rx_wait, timeout)) {
+            n = -ETIMEDOUT;
+            break;
+        }
+        if (atomic_load(&raw->closing)) {
+            n = -EBADF;
+            break;
+        }
+        n = serial_ring_get(&raw->rx, buf, len);
+    }
+    serial_raw_put(platdata);
+    return n;
+}
+
+ssize_t serial_raw_write(struct udevice *dev, const void *buf, size_t len,
+    rtems_interval timeout)
+{
+    struct serial_class *platdata = dev_get_uclass_plat(dev);
+    const struct dm_serial_ops *ops = serial_get_ops(dev);
+    struct serial_raw *raw = serial_raw_get(platdata);
+    rtems_interrupt_lock_context ctx;
+    size_t done = 0;
+    bool closing;
+
+    if (raw == NULL)
+        return -EINVAL;
+
+    for (;;) {
+        done += serial_ring_put(&raw->tx, (const char *)buf + done,
+            len - done);
+
+        rtems_termios_device_lock_acquire(&platdata->base, &ctx);
+        closing = atomic_load(&raw->closing);
+        if (!closing && !raw->txbusy) {
+            raw->txbusy = true;
+            serial_raw_tx_next(platdata, ops);
+            if (raw->txbusy)
+                ops->tx_irqena(dev);
+        }
+        rtems_termios_device_lock_release(&platdata->base, &ctx);
+
+        if (closing || done == len || timeout == 0)
+            break;
+        if (serial_raw_wait(&raw->tx_wait, timeout))
+            break;
+    }
+    serial_raw_put(platdata);
+    return closing && done == 0 ? -EBADF : (ssize_t)done;
+}
+
+int serial_raw_drain(struct udevice *dev, rtems_interval timeout)
+{
+    struct serial_class *platdata = dev_get_uclass_plat(dev);
+    struct serial_raw *raw = serial_raw_get(platdata);
+    const char *buf;
+    int ret = 0;
+
+    if (raw == NULL)
+        return -EINVAL;
+
+    /* The ISR clears txbusy once the FIFO has emptied with the ring empty */
+    while (raw->txbusy || serial_ring_peek(&raw->tx, &buf) > 0) {
+        if (atomic_load(&raw->closing)) {
+            ret = -EBADF;
+            break;
+        }
+        if (serial_raw_wait(&raw->tx_wait, timeout)) {
+            ret = -ETIMEDOUT;
+            break;
+        }
+    }
+    serial_raw_put(platdata);
+    return ret;
+}
+
+uint32_t serial_raw_overruns(struct udevice *dev)
+{
+    struct serial_class *platdata = dev_get_uclass_plat(dev);
+
+    return platdata->raw != NULL ? platdata->raw->overruns : 0;
+}
+
 static void serial_console_putc(char c)
 {
     struct serial_class *platdata = 
@@ -240,7 +588,9 @@ static int serial_pre_probe(struct udevice *dev)
     if (ops->set_mctrl)
         fops = &serial_flowctrl_ops;
     platdata->dev = dev;
-    name[sizeof(name)-1] += dev_seq(dev);
+    platdata->fifo.rx_trigger = dev_read_u32_default(dev, "rx-fifo-trigger", 0);
+    platdata->fifo.rx_timeout = dev_read_u32_default(dev, "rx-timeout", 0);
+    name[sizeof(name)-2] += dev_seq(dev);
     strcpy(platdata->name, name); 
     rtems_termios_device_context_initialize(&platdata->base, "UART");
     sc = rtems_termios_device_install(platdata->name, &serial_termios_ops, 
@@ -14,13 +14,18 @@
 #include "dm/serial.h"
 #include "dm/read.h"
 #include "dm/of_irq.h"
+#include "dt-structs.h"
 
 #define ZYNQ_UART_FIFO_DEPTH 64
 
 struct zynq_uart_regs;
 struct zynq_uart_platdata {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+    struct dtd_xlnx_xuartps dtplat;
+#endif
     volatile struct zynq_uart_regs *regs;
     int irq;
+    uint32_t rx_trigger;
 };
 
 struct zynq_uart_regs {
@@ -210,18 +215,22 @@ static void zynq_uart_isr(void *arg)
     struct zynq_uart_platdata *platdata = dev_get_plat(dev);
     volatile struct zynq_uart_regs *regs = platdata->regs;
     char buffer[ZYNQ_UART_FIFO_DEPTH];
-    uint32_t channel_sts;
+    uint32_t irq_sts;
+    int rxlen = 0;
+
+    irq_sts = regs->irq_sts & (ZYNQ_UART_TIMEOUT | ZYNQ_UART_RTRIG);
+    if (irq_sts != 0) {
+        regs->irq_sts = irq_sts;
 
-    if ((regs->irq_sts & (ZYNQ_UART_TIMEOUT | ZYNQ_UART_RTRIG)) != 0) {
-        int rxlen = 0;
-        regs->irq_sts = ZYNQ_UART_TIMEOUT | ZYNQ_UART_RTRIG;
-        do {
+        /*
+         * RTRIG stays latched after the level it reported has been read,
+         * so the live channel status decides how much is really there
+         */
+        while (rxlen < ZYNQ_UART_FIFO_DEPTH &&
+            (regs->channel_sts & ZYNQ_UART_CHANNEL_STS_REMPTY) == 0)
             buffer[rxlen++] = (char)ZYNQ_UART_TX_RX_FIFO_FIFO_GET(regs->tx_rx_fifo);
-            channel_sts = regs->channel_sts;
-        } while ((channel_sts & ZYNQ_UART_CHANNEL_STS_REMPTY) == 0);
-        serial_class_enqueue(dev, buffer, rxlen);
-    } else {
-        channel_sts = regs->channel_sts;
+        if (rxlen > 0)
+            serial_class_enqueue(dev, buffer, rxlen);
     }
     serial_class_dequeue(dev);
 }
@@ -229,10 +238,23 @@ static void zynq_uart_isr(void *arg)
 static int zynq_uart_open(struct udevice *dev)
 {
     struct zynq_uart_platdata *platdata = dev_get_plat(dev);
+    const struct serial_fifo_cfg *fifo = serial_class_fifo_cfg(dev);
     volatile struct zynq_uart_regs *regs = platdata->regs;
+    uint32_t rx_timeout = 32;
     uint32_t brgr = 0x3e;
     uint32_t bauddiv = 0x6;
 
+    platdata->rx_trigger = ZYNQ_UART_FIFO_DEPTH / 2;
+    if (fifo->rx_trigger > 0 && fifo->rx_trigger < ZYNQ_UART_FIFO_DEPTH)
+        platdata->rx_trigger = fifo->rx_trigger;
+
+    /* The receiver timeout counts in units of 4 bit periods */
+    if (fifo->rx_timeout > 0) {
+        rx_timeout = (fifo->rx_timeout + 3) / 4;
+        if (rx_timeout > 255)
+            rx_timeout = 255;
+    }
+
     zynq_uart_calc_baudrate(ZYNQ_UART_DEFAULT_BAUD, &brgr, &bauddiv, regs->mode);
     regs->control &= ~(ZYNQ_UART_CONTROL_RXEN | ZYNQ_UART_CONTROL_TXEN);
     regs->control = ZYNQ_UART_CONTROL_RXDIS
@@ -248,8 +270,8 @@ static int zynq_uart_open(struct udevice *dev)
                   | ZYNQ_UART_CONTROL_TXDIS
                   | ZYNQ_UART_CONTROL_RXRES
                   | ZYNQ_UART_CONTROL_TXRES;
-    regs->rx_timeout = 32;
-    regs->rx_fifo_trg_lvl = ZYNQ_UART_FIFO_DEPTH / 2;
+    regs->rx_timeout = rx_timeout;
+    regs->rx_fifo_trg_lvl = platdata->rx_trigger;
     regs->irq_dis = 0xffffffff;
     regs->irq_sts = 0xffffffff;
     regs->irq_en = ZYNQ_UART_RTRIG | ZYNQ_UART_TIMEOUT;
@@ -284,6 +306,15 @@ static ssize_t zynq_uart_fifo_write(struct udevice *dev,
     volatile struct zynq_uart_regs *regs = platdata->regs;
     size_t out = 0;
 
+    /* An empty FIFO takes a full load without checking for room */
+    if (regs->channel_sts & ZYNQ_UART_CHANNEL_STS_TEMPTY) {
+        size_t n = size < ZYNQ_UART_FIFO_DEPTH ? size : ZYNQ_UART_FIFO_DEPTH;
+
+        while (out < n)
+            regs->tx_rx_fifo = buf[out++];
+        return out;
+    }
+
     while (out < size) {
         if (regs->channel_sts & ZYNQ_UART_CHANNEL_STS_TFUL)
             break;
@@ -391,6 +422,16 @@ static int zynq_uart_putc_poll(struct udevice *dev, const char ch)
 static int zynq_uart_of_to_platdata(struct udevice *dev)
 {
     struct zynq_uart_platdata *platdata = dev_get_plat(dev);
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+    struct dtd_xlnx_xuartps *dtplat = &platdata->dtplat;
+    unsigned int irq, type;
+
+    platdata->regs = (volatile struct zynq_uart_regs *)dtplat->reg[0];
+    if (of_irq_translate_cells(dtplat->interrupts,
+        ARRAY_SIZE(dtplat->interrupts), &irq, &type))
+        return -EINVAL;
+    platdata->irq = irq;
+#else
     fdt_addr_t addr, irq;
 
     addr = dev_read_addr_index(dev, 0);
@@ -401,6 +442,7 @@ static int zynq_uart_of_to_platdata(struct udevice *dev)
     if (irq == FDT_ADDR_T_NONE)
         return -EINVAL;
     platdata->irq = irq;
+#endif
     return 0;
 }
 
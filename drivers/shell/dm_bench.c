@@ -0,0 +1,460 @@
+/*
+ * Driver model microbenchmarks
+ *
+ * The core cases time phandle, property, uclass and sequence number lookups
+ * and the slab allocator, each next to the linear walk or heap call it replaces.
+ * The sandbox cases run a transaction through the full uclass stack against
+ * the sandbox controllers, whose peripherals live in memory, so the figures
+ * are the software cost of a transaction and can be compared between builds.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rtems/counter.h>
+
+#include "common.h"
+#include "dm.h"
+#include "dm/device-internal.h"
+#include "dm/of_access.h"
+#include "dm/ofnode.h"
+#include "dm/slab.h"
+#include "dm/uclass-internal.h"
+#include "dm/util.h"
+#include "linux/libfdt.h"
+#ifdef CONFIG_SANDBOX_BUS
+#include "dm/i2c.h"
+#include "dm/spi.h"
+#include "dm/platform_data/sandbox_bus.h"
+#include "asm/gpio.h"
+#endif
+
+/* Pins driven together by the GPIO port cases */
+#define BENCH_GPIO_PINS 8
+
+/* Objects held at once by the allocator cases */
+#define BENCH_SLAB_BATCH 16
+
+struct bench_ctx {
+    /* Core cases */
+    uint phandle_max;
+    struct device_node *prop_np;
+    enum uclass_id uc_id;
+    struct uclass *uc;
+    int seq_size;
+    int dev_count;
+    size_t size;
+    void *objs[BENCH_SLAB_BATCH];
+#ifdef CONFIG_SANDBOX_BUS
+    struct udevice *chip;
+    struct spi_slave *slave;
+    struct gpio_desc gpio[BENCH_GPIO_PINS];
+    struct gpio_port port;
+    uint8_t buf[16];
+#endif
+};
+
+typedef int (*bench_fn)(struct bench_ctx *ctx, unsigned int i);
+
+static int bench_phandle(struct bench_ctx *ctx, unsigned int i)
+{
+    ofnode node = ofnode_get_by_phandle(1 + i % ctx->phandle_max);
+
+    return ofnode_valid(node) || i ? 0 : -ENOENT;
+}
+
+/* The lookup as it was before the phandle tables */
+static int bench_phandle_walk(struct bench_ctx *ctx, unsigned int i)
+{
+    uint phandle = 1 + i % ctx->phandle_max;
+    struct device_node *np;
+
+    if (of_live_active()) {
+        for_each_of_allnodes(np) {
+            if (np->phandle == phandle)
+                return 0;
+        }
+        return i ? 0 : -ENOENT;
+    }
+    return fdt_node_offset_by_phandle(dm_fdt_blob(), phandle) >= 0 ||
+        i ? 0 : -ENOENT;
+}
+
+static int bench_prop(struct bench_ctx *ctx, unsigned int i)
+{
+    struct device_node *np = ctx->prop_np;
+    const char *name = np->properties[i % np->prop_count].name;
+
+    return of_find_property(np, name, NULL) ? 0 : -ENOENT;
+}
+
+/* The lookup as it was before the sorted property index */
+static int bench_prop_walk(struct bench_ctx *ctx, unsigned int i)
+{
+    struct device_node *np = ctx->prop_np;
+    const char *name = np->properties[i % np->prop_count].name;
+    struct property *pp;
+
+    for (pp = np->properties; pp < np->properties + np->prop_count; pp++) {
+        if (!strcmp(pp->name, name))
+            return 0;
+    }
+    return -ENOENT;
+}
+
+static int bench_slab(struct bench_ctx *ctx, unsigned int i)
+{
+    int n;
+
+    for (n = 0; n < BENCH_SLAB_BATCH; n++) {
+        ctx->objs[n] = dm_slab_alloc(ctx->size);
+        if (!ctx->objs[n])
+            break;
+    }
+    while (n-- > 0)
+        dm_slab_free(ctx->objs[n]);
+    return ctx->objs[0] ? 0 : -ENOMEM;
+}
+
+static int bench_heap(struct bench_ctx *ctx, unsigned int i)
+{
+    int n;
+
+    for (n = 0; n < BENCH_SLAB_BATCH; n++) {
+        ctx->objs[n] = calloc(1, ctx->size);
+        if (!ctx->objs[n])
+            break;
+    }
+    while (n-- > 0)
+        free(ctx->objs[n]);
+    return ctx->objs[0] ? 0 : -ENOMEM;
+}
+
+static int bench_uclass_get(struct bench_ctx *ctx, unsigned int i)
+{
+    struct uclass *uc;
+
+    return uclass_get(ctx->uc_id, &uc);
+}
+
+static int bench_uclass_walk(struct bench_ctx *ctx, unsigned int i)
+{
+    struct uclass *uc;
+    int ret = -ENOENT;
+
+    dm_core_lock();
+    list_for_each_entry(uc, DM_UCLASS_ROOT_NON_CONST, sibling_node) {
+        if (uc->uc_drv->id == ctx->uc_id) {
+            ret = 0;
+            break;
+        }
+    }
+    dm_core_unlock();
+    return ret;
+}
+
+static int bench_seq(struct bench_ctx *ctx, unsigned int i)
+{
+    struct udevice *dev;
+
+    uclass_find_device_by_seq(ctx->uc_id, i % ctx->seq_size, &dev);
+    return 0;
+}
+
+static int bench_seq_walk(struct bench_ctx *ctx, unsigned int i)
+{
+    int seq = i % ctx->seq_size;
+    struct udevice *dev;
+
+    dm_core_lock();
+    uclass_foreach_dev(dev, ctx->uc) {
+        if (dev_seq(dev) == seq)
+            break;
+    }
+    dm_core_unlock();
+    return 0;
+}
+
+static int bench_index(struct bench_ctx *ctx, unsigned int i)
+{
+    struct udevice *dev;
+
+    return uclass_find_device(ctx->uc_id, i % ctx->dev_count, &dev);
+}
+
+static int bench_index_walk(struct bench_ctx *ctx, unsigned int i)
+{
+    int index = i % ctx->dev_count;
+    struct udevice *dev;
+    int ret = -ENODEV;
+
+    dm_core_lock();
+    uclass_foreach_dev(dev, ctx->uc) {
+        if (index-- == 0) {
+            ret = 0;
+            break;
+        }
+    }
+    dm_core_unlock();
+    return ret;
+}
+
+#ifdef CONFIG_SANDBOX_BUS
+
+static int bench_i2c_read1(struct bench_ctx *ctx, unsigned int i)
+{
+    return dm_i2c_read(ctx->chip, i & 0xff, ctx->buf, 1);
+}
+
+static int bench_i2c_read16(struct bench_ctx *ctx, unsigned int i)
+{
+    return dm_i2c_read(ctx->chip, i & 0xf0, ctx->buf, 16);
+}
+
+static int bench_i2c_write1(struct bench_ctx *ctx, unsigned int i)
+{
+    ctx->buf[0] = i;
+    return dm_i2c_write(ctx->chip, i & 0xff, ctx->buf, 1);
+}
+
+static int bench_spi_read16(struct bench_ctx *ctx, unsigned int i)
+{
+    uint8_t cmd[4] = { 0x03, 0, i >> 8, i };
+    int ret;
+
+    ret = dm_spi_xfer(ctx->slave->dev, sizeof(cmd) * 8, cmd, NULL,
+        SPI_XFER_BEGIN);
+    if (ret)
+        return ret;
+    return dm_spi_xfer(ctx->slave->dev, sizeof(ctx->buf) * 8, NULL,
+        ctx->buf, SPI_XFER_END);
+}
+
+static int bench_spi_rdsr(struct bench_ctx *ctx, unsigned int i)
+{
+    uint8_t cmd[2] = { 0x05, 0 };
+
+    return dm_spi_xfer(ctx->slave->dev, sizeof(cmd) * 8, cmd, ctx->buf,
+        SPI_XFER_ONCE);
+}
+
+static int bench_gpio_set(struct bench_ctx *ctx, unsigned int i)
+{
+    return dm_gpio_set_value(&ctx->gpio[0], i & 1);
+}
+
+static int bench_gpio_get(struct bench_ctx *ctx, unsigned int i)
+{
+    return dm_gpio_get_value(&ctx->gpio[0]);
+}
+
+static int bench_gpio_set8(struct bench_ctx *ctx, unsigned int i)
+{
+    int n, ret;
+
+    for (n = 0; n < BENCH_GPIO_PINS; n++) {
+        ret = dm_gpio_set_value(&ctx->gpio[n], (i >> n) & 1);
+        if (ret)
+            return ret;
+    }
+    return 0;
+}
+
+static int bench_gpio_get8(struct bench_ctx *ctx, unsigned int i)
+{
+    return dm_gpio_get_values_as_int(ctx->gpio, BENCH_GPIO_PINS);
+}
+
+static int bench_port_set(struct bench_ctx *ctx, unsigned int i)
+{
+    return gpio_port_set(&ctx->port, ~0UL, i);
+}
+
+static int bench_port_get(struct bench_ctx *ctx, unsigned int i)
+{
+    ulong value;
+
+    return gpio_port_get(&ctx->port, &value);
+}
+
+#endif /* CONFIG_SANDBOX_BUS */
+
+static void bench_run(struct bench_ctx *ctx, const char *name, bench_fn fn,
+    unsigned int loops)
+{
+    rtems_counter_ticks start, ticks;
+    uint64_t ns;
+    unsigned int i;
+    int ret;
+
+    /* Warm up caches and any lazily created state */
+    ret = fn(ctx, 0);
+    if (ret < 0) {
+        printf("%-26s failed: %d\n", name, ret);
+        return;
+    }
+
+    start = rtems_counter_read();
+    for (i = 0; i < loops; i++)
+        fn(ctx, i);
+    ticks = rtems_counter_difference(rtems_counter_read(), start);
+
+    ns = rtems_counter_ticks_to_nanoseconds(ticks);
+    printf("%-26s %10u %12llu\n", name, loops,
+        (unsigned long long)(ns / loops));
+}
+
+static uint bench_phandle_max(void)
+{
+    const void *blob = dm_fdt_blob();
+    struct device_node *np;
+    uint max = 0;
+    int offset;
+
+    if (of_live_active()) {
+        for_each_of_allnodes(np)
+            max = max_t(uint, max, np->phandle);
+    } else if (blob) {
+        for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+            offset = fdt_next_node(blob, offset, NULL))
+            max = max_t(uint, max, fdt_get_phandle(blob, offset));
+    }
+    return max;
+}
+
+/* Time the lookups on the uclass with the most devices */
+static void bench_core(struct bench_ctx *ctx, unsigned int loops)
+{
+    static const size_t sizes[] = { 32, 256 };
+    struct device_node *np;
+    struct uclass *uc;
+    char name[32];
+    int n;
+
+    ctx->phandle_max = bench_phandle_max();
+    if (ctx->phandle_max) {
+        bench_run(ctx, "ofnode_get_by_phandle", bench_phandle, loops);
+        bench_run(ctx, "phandle tree walk", bench_phandle_walk, loops);
+    } else {
+        printf("no phandles in the device tree\n");
+    }
+
+    if (of_live_active()) {
+        for_each_of_allnodes(np) {
+            if (!ctx->prop_np || np->prop_count > ctx->prop_np->prop_count)
+                ctx->prop_np = np;
+        }
+        printf("node %s: %d properties\n", ctx->prop_np->full_name,
+            ctx->prop_np->prop_count);
+        bench_run(ctx, "of_find_property", bench_prop, loops);
+        bench_run(ctx, "property list walk", bench_prop_walk, loops);
+    }
+
+    for (n = 0; n < ARRAY_SIZE(sizes); n++) {
+        ctx->size = sizes[n];
+        snprintf(name, sizeof(name), "dm_slab_alloc/free %zux16", sizes[n]);
+        bench_run(ctx, name, bench_slab, loops / BENCH_SLAB_BATCH);
+        snprintf(name, sizeof(name), "calloc/free %zux16", sizes[n]);
+        bench_run(ctx, name, bench_heap, loops / BENCH_SLAB_BATCH);
+    }
+
+    dm_core_lock();
+    list_for_each_entry(uc, DM_UCLASS_ROOT_NON_CONST, sibling_node) {
+        if (!ctx->uc || uc->dev_count > ctx->uc->dev_count)
+            ctx->uc = uc;
+    }
+    if (ctx->uc) {
+        ctx->uc_id = ctx->uc->uc_drv->id;
+        ctx->dev_count = ctx->uc->dev_count;
+        ctx->seq_size = ctx->uc->seq_size;
+    }
+    dm_core_unlock();
+    if (!ctx->dev_count) {
+        printf("no devices bound\n");
+        return;
+    }
+
+    printf("uclass %s: %d devices\n", ctx->uc->uc_drv->name,
+        ctx->dev_count);
+    bench_run(ctx, "uclass_get", bench_uclass_get, loops);
+    bench_run(ctx, "uclass list walk", bench_uclass_walk, loops);
+    if (ctx->seq_size) {
+        bench_run(ctx, "uclass_find_device_by_seq", bench_seq, loops);
+        bench_run(ctx, "seq list walk", bench_seq_walk, loops);
+    }
+    bench_run(ctx, "uclass_find_device", bench_index, loops);
+    bench_run(ctx, "index list walk", bench_index_walk, loops);
+}
+
+void dm_bench(unsigned int loops)
+{
+    struct bench_ctx ctx;
+#ifdef CONFIG_SANDBOX_BUS
+    struct udevice *bus;
+    int ret, n;
+#endif
+
+    if (loops < BENCH_SLAB_BATCH)
+        loops = BENCH_SLAB_BATCH;
+    memset(&ctx, 0, sizeof(ctx));
+    printf("%-26s %10s %12s\n", "Case", "Loops", "ns/op");
+
+    bench_core(&ctx, loops);
+
+#ifdef CONFIG_SANDBOX_BUS
+    ret = uclass_get_device_by_name(UCLASS_I2C, "sandbox_i2c", &bus);
+    if (!ret)
+        ret = i2c_get_chip(bus, SANDBOX_I2C_EEPROM_ADDR, 1, &ctx.chip);
+    if (!ret) {
+        bench_run(&ctx, "dm_i2c_read 1 byte", bench_i2c_read1, loops);
+        bench_run(&ctx, "dm_i2c_read 16 bytes", bench_i2c_read16, loops);
+        bench_run(&ctx, "dm_i2c_write 1 byte", bench_i2c_write1, loops);
+    } else {
+        printf("sandbox_i2c not available: %d\n", ret);
+    }
+
+    ret = uclass_get_device_by_name(UCLASS_SPI, "sandbox_spi", &bus);
+    if (!ret)
+        ret = spi_get_bus_and_cs(dev_seq(bus), 0, 1000000, 0,
+            "spi_generic_drv", "sandbox_flash", &bus, &ctx.slave);
+    if (!ret)
+        ret = spi_claim_bus(ctx.slave);
+    if (!ret) {
+        bench_run(&ctx, "dm_spi_xfer RDSR", bench_spi_rdsr, loops);
+        bench_run(&ctx, "dm_spi_xfer READ 16", bench_spi_read16, loops);
+        spi_release_bus(ctx.slave);
+    } else {
+        printf("sandbox_spi not available: %d\n", ret);
+    }
+
+    ret = uclass_get_device_by_name(UCLASS_GPIO, "sandbox_gpio", &bus);
+    if (ret) {
+        printf("sandbox_gpio not available: %d\n", ret);
+        return;
+    }
+    for (n = 0; n < BENCH_GPIO_PINS; n++) {
+        ctx.gpio[n].dev = bus;
+        ctx.gpio[n].offset = n;
+        ret = dm_gpio_request(&ctx.gpio[n], "bench");
+        if (!ret)
+            ret = dm_gpio_set_dir_flags(&ctx.gpio[n], GPIOD_IS_OUT);
+        if (ret) {
+            printf("sandbox_gpio %d not available: %d\n", n, ret);
+            break;
+        }
+    }
+    if (!ret)
+        ret = gpio_port_init(&ctx.port, ctx.gpio, BENCH_GPIO_PINS);
+    if (!ret) {
+        bench_run(&ctx, "dm_gpio_set_value", bench_gpio_set, loops);
+        bench_run(&ctx, "dm_gpio_get_value", bench_gpio_get, loops);
+        bench_run(&ctx, "dm_gpio_set_value x8", bench_gpio_set8, loops);
+        bench_run(&ctx, "dm_gpio_get_values 8", bench_gpio_get8, loops);
+        bench_run(&ctx, "gpio_port_set 8 pins", bench_port_set, loops);
+        bench_run(&ctx, "gpio_port_get 8 pins", bench_port_get, loops);
+    }
+    while (n-- > 0)
+        dm_gpio_free(bus, &ctx.gpio[n]);
+#endif
+}
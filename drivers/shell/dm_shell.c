@@ -1,10 +1,13 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
 #include <rtems/shell.h>
 #include <rtems/sysinit.h>
 
+#include "dm/interrupt.h"
+#include "dm/slab.h"
 #include "dm/util.h"
 
 #define DM_HELP \
@@ -14,11 +17,21 @@
     "   [-u][--uclass]\n" \
     "   [-d][--drivers]\n" \
     "   [-sd][--static-driver]\n" \
-    "   [-dc][--driver-compat]\n"
+    "   [-dc][--driver-compat]\n" \
+    "   [-p][--probe-time]\n" \
+    "   [-df][--deferred]\n" \
+    "   [-m][--memory]\n" \
+    "   [-i][--irq] [-ih][--irq-hist]\n" \
+    "   [-b][--bench] [loops]\n"
 
 
 static int shell_dm(int argc, char *argv[])
 {
+    if ((argc == 2 || argc == 3) &&
+        (!strcmp(argv[1], "--bench") || !strcmp(argv[1], "-b"))) {
+        dm_bench(argc == 3 ? strtoul(argv[2], NULL, 0) : 10000);
+        return 0;
+    }
     if (argc == 2) {
         if (!strcmp(argv[1], "--all") ||
             !strcmp(argv[1], "-a")) {
@@ -35,6 +48,21 @@ static int shell_dm(int argc, char *argv[])
         } else if (!strcmp(argv[1], "--driver-compat") ||
             !strcmp(argv[1], "-dc")) {
             dm_dump_driver_compat();
+        } else if (!strcmp(argv[1], "--probe-time") ||
+            !strcmp(argv[1], "-p")) {
+            dm_dump_probe_stats();
+        } else if (!strcmp(argv[1], "--deferred") ||
+            !strcmp(argv[1], "-df")) {
+            dm_dump_deferred();
+        } else if (!strcmp(argv[1], "--memory") ||
+            !strcmp(argv[1], "-m")) {
+            dm_dump_slab();
+        } else if (!strcmp(argv[1], "--irq") ||
+            !strcmp(argv[1], "-i")) {
+            dm_dump_irq_threads(false);
+        } else if (!strcmp(argv[1], "--irq-hist") ||
+            !strcmp(argv[1], "-ih")) {
+            dm_dump_irq_threads(true);
         } else {
             goto _err;
         }
@@ -5,12 +5,16 @@
  *
  * Author: Boris Brezillon <boris.brezillon@bootlin.com>
  */
+#include <stdlib.h>
+#include <rtems/malloc.h>
+
 #include <common.h>
 #include <dm.h>
 #include <errno.h>
 #include <dm/spi.h>
 #include <dm/spi-mem.h>
 #include <dm/device_compat.h>
+#include <linux/err.h>
 
 
 static int spi_check_buswidth_req(struct spi_slave *slave, 
@@ -248,3 +252,165 @@ int spi_mem_adjust_op_size(struct spi_slave *slave, struct spi_mem_op *op)
 
 	return 0;
 }
+
+static ssize_t spi_mem_no_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				      u64 offs, size_t len, void *buf)
+{
+	struct spi_mem_op op = desc->info.op_tmpl;
+	int ret;
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.buf.in = buf;
+	op.data.nbytes = len;
+	ret = spi_mem_adjust_op_size(desc->slave, &op);
+	if (ret)
+		return ret;
+
+	ret = spi_mem_exec_op(desc->slave, &op);
+	if (ret)
+		return ret;
+
+	return op.data.nbytes;
+}
+
+/**
+ * spi_mem_dirmap_create() - Create a direct mapping descriptor
+ * @slave: SPI device this direct mapping should be created for
+ * @info: direct mapping information
+ *
+ * This function is creating a direct mapping descriptor which can then be used
+ * to access the memory using spi_mem_dirmap_read(). If the controller does
+ * not support direct mapping, the descriptor falls back to
+ * spi_mem_exec_op(), so callers can use the same code in both cases.
+ *
+ * Return: a valid pointer in case of success, and ERR_PTR() otherwise.
+ */
+struct spi_mem_dirmap_desc *
+spi_mem_dirmap_create(struct spi_slave *slave,
+		      const struct spi_mem_dirmap_info *info)
+{
+	struct udevice *bus = slave->dev->parent;
+	struct dm_spi_ops *ops = spi_get_ops(bus);
+	struct spi_mem_dirmap_desc *desc;
+	int ret = -ENOTSUPP;
+
+	/* Make sure the number of address cycles is between 1 and 8 bytes. */
+	if (!info->op_tmpl.addr.nbytes || info->op_tmpl.addr.nbytes > 8)
+		return ERR_PTR(-EINVAL);
+
+	/* Only reads are mapped for now. */
+	if (info->op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return ERR_PTR(-EINVAL);
+
+	desc = rtems_calloc(1, sizeof(*desc));
+	if (!desc)
+		return ERR_PTR(-ENOMEM);
+
+	desc->slave = slave;
+	desc->info = *info;
+	if (ops->mem_ops && ops->mem_ops->dirmap_create) {
+		rtems_mutex_lock(&slave->lock);
+		ret = ops->mem_ops->dirmap_create(desc);
+		rtems_mutex_unlock(&slave->lock);
+	}
+
+	if (ret) {
+		desc->nodirmap = 1;
+		if (!spi_mem_supports_op(slave, &desc->info.op_tmpl))
+			ret = -ENOTSUPP;
+		else
+			ret = 0;
+	}
+
+	if (ret) {
+		free(desc);
+		return ERR_PTR(ret);
+	}
+
+	dev_dbg(slave->dev, "dirmap 0x%llx+0x%llx: %s\n",
+		(unsigned long long)info->offset,
+		(unsigned long long)info->length,
+		desc->nodirmap ? "exec_op" : "mapped");
+
+	return desc;
+}
+
+/**
+ * spi_mem_dirmap_destroy() - Destroy a direct mapping descriptor
+ * @desc: the direct mapping descriptor to destroy
+ *
+ * This function destroys a direct mapping descriptor previously created by
+ * spi_mem_dirmap_create().
+ */
+void spi_mem_dirmap_destroy(struct spi_mem_dirmap_desc *desc)
+{
+	struct udevice *bus;
+	struct dm_spi_ops *ops;
+
+	if (IS_ERR_OR_NULL(desc))
+		return;
+
+	bus = desc->slave->dev->parent;
+	ops = spi_get_ops(bus);
+	if (!desc->nodirmap && ops->mem_ops->dirmap_destroy)
+		ops->mem_ops->dirmap_destroy(desc);
+
+	free(desc);
+}
+
+/**
+ * spi_mem_dirmap_read() - Read data through a direct mapping
+ * @desc: direct mapping descriptor
+ * @offs: offset to start reading from. Note that this is not an absolute
+ *	  offset, but the offset within the direct mapping which already has
+ *	  its own offset
+ * @len: length in bytes
+ * @buf: destination buffer. This buffer must be DMA-able
+ *
+ * This function reads data from a memory device using a direct mapping
+ * previously instantiated with spi_mem_dirmap_create(). Reads past the end
+ * of the mapping are truncated.
+ *
+ * Return: the amount of data read from the memory device or a negative error
+ * code.
+ */
+ssize_t spi_mem_dirmap_read(struct spi_mem_dirmap_desc *desc,
+			    u64 offs, size_t len, void *buf)
+{
+	struct spi_slave *slave = desc->slave;
+	struct udevice *bus = slave->dev->parent;
+	struct dm_spi_bus *spi = dev_get_uclass_priv(bus);
+	struct dm_spi_ops *ops = spi_get_ops(bus);
+	size_t done = 0;
+	ssize_t ret;
+
+	if (offs >= desc->info.length)
+		return len ? -EINVAL : 0;
+	len = min_t(u64, len, desc->info.length - offs);
+
+	while (done < len) {
+		if (desc->nodirmap) {
+			ret = spi_mem_no_dirmap_read(desc, offs + done,
+						     len - done, buf + done);
+		} else {
+			rtems_mutex_lock(&slave->lock);
+			ret = spi_claim_bus(slave);
+			if (!ret) {
+				rtems_mutex_lock(&spi->lock);
+				ret = ops->mem_ops->dirmap_read(desc,
+						offs + done, len - done,
+						buf + done);
+				rtems_mutex_unlock(&spi->lock);
+				spi_release_bus(slave);
+			}
+			rtems_mutex_unlock(&slave->lock);
+		}
+		if (ret < 0)
+			return ret;
+		if (!ret)
+			return -EIO;
+		done += ret;
+	}
+
+	return done;
+}
@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sandbox SPI controller with an emulated SPI-NOR flash
+ *
+ * The flash on chip select 0 understands the basic single-bit commands:
+ * RDID, RDSR, WREN, WRDI, READ, FAST_READ, PP, SE (4 KiB) and CE. Programming
+ * only clears bits and wraps within the 256 byte page, as on real parts.
+ * Commands are decoded byte by byte as they are clocked, so a command may be
+ * split over several xfer() calls between SPI_XFER_BEGIN and SPI_XFER_END;
+ * the data phase of a read is served with memcpy().
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtems/malloc.h>
+
+#include <common.h>
+#include <dm.h>
+#include <dm/spi.h>
+#include <dm/read.h>
+#include <dm/platdata.h>
+#include <dm/platform_data/sandbox_bus.h>
+
+#define SF_CMD_PP		0x02
+#define SF_CMD_READ		0x03
+#define SF_CMD_WRDI		0x04
+#define SF_CMD_RDSR		0x05
+#define SF_CMD_WREN		0x06
+#define SF_CMD_FAST_READ	0x0b
+#define SF_CMD_SE		0x20
+#define SF_CMD_RDID		0x9f
+#define SF_CMD_CE		0xc7
+
+#define SF_SR_WEL		BIT(1)
+#define SF_PAGE_SIZE		256
+#define SF_SECTOR_SIZE		4096
+
+enum sf_state {
+	SF_IDLE,
+	SF_CMD,
+	SF_ADDR,
+	SF_DUMMY,
+	SF_READ,
+	SF_PROGRAM,
+	SF_RDID,
+	SF_RDSR,
+};
+
+/**
+ * struct sandbox_spi_priv - Emulated flash state
+ *
+ * @flash: Flash contents
+ * @state: Phase of the current command
+ * @cmd: Current command
+ * @addr: Address of the next byte
+ * @count: Bytes left in the address or dummy phase, index in RDID
+ * @wel: Write enable latch
+ */
+struct sandbox_spi_priv {
+	u8 *flash;
+	enum sf_state state;
+	u8 cmd;
+	uint addr;
+	uint count;
+	bool wel;
+};
+
+static void sandbox_sf_command(struct sandbox_spi_priv *priv,
+			       struct sandbox_spi_plat *plat, u8 cmd)
+{
+	priv->cmd = cmd;
+	priv->addr = 0;
+	priv->count = 0;
+	priv->state = SF_IDLE;
+
+	switch (cmd) {
+	case SF_CMD_RDID:
+		priv->state = SF_RDID;
+		break;
+	case SF_CMD_RDSR:
+		priv->state = SF_RDSR;
+		break;
+	case SF_CMD_WREN:
+		priv->wel = true;
+		break;
+	case SF_CMD_WRDI:
+		priv->wel = false;
+		break;
+	case SF_CMD_CE:
+		if (priv->wel)
+			memset(priv->flash, 0xff, plat->flash_size);
+		priv->wel = false;
+		break;
+	case SF_CMD_READ:
+	case SF_CMD_FAST_READ:
+	case SF_CMD_PP:
+	case SF_CMD_SE:
+		priv->state = SF_ADDR;
+		priv->count = 3;
+		break;
+	}
+}
+
+/* The address is complete, enter the data phase of the command */
+static void sandbox_sf_addressed(struct sandbox_spi_priv *priv,
+				 struct sandbox_spi_plat *plat)
+{
+	priv->addr %= plat->flash_size;
+
+	switch (priv->cmd) {
+	case SF_CMD_FAST_READ:
+		priv->state = SF_DUMMY;
+		priv->count = 1;
+		break;
+	case SF_CMD_READ:
+		priv->state = SF_READ;
+		break;
+	case SF_CMD_PP:
+		priv->state = priv->wel ? SF_PROGRAM : SF_IDLE;
+		break;
+	case SF_CMD_SE:
+		if (priv->wel)
+			memset(priv->flash + (priv->addr & ~(SF_SECTOR_SIZE - 1)),
+			       0xff, min(plat->flash_size, (uint)SF_SECTOR_SIZE));
+		priv->wel = false;
+		priv->state = SF_IDLE;
+		break;
+	}
+}
+
+static u8 sandbox_sf_byte(struct sandbox_spi_priv *priv,
+			  struct sandbox_spi_plat *plat, u8 out)
+{
+	uint page;
+	u8 in = 0xff;
+
+	switch (priv->state) {
+	case SF_IDLE:
+		break;
+	case SF_CMD:
+		sandbox_sf_command(priv, plat, out);
+		break;
+	case SF_ADDR:
+		priv->addr = priv->addr << 8 | out;
+		if (!--priv->count)
+			sandbox_sf_addressed(priv, plat);
+		break;
+	case SF_DUMMY:
+		if (!--priv->count)
+			priv->state = SF_READ;
+		break;
+	case SF_READ:
+		in = priv->flash[priv->addr];
+		priv->addr = (priv->addr + 1) % plat->flash_size;
+		break;
+	case SF_PROGRAM:
+		priv->flash[priv->addr] &= out;
+		page = priv->addr & ~(SF_PAGE_SIZE - 1);
+		priv->addr = page + ((priv->addr + 1) & (SF_PAGE_SIZE - 1));
+		break;
+	case SF_RDID:
+		in = plat->jedec_id >> (8 * (2 - priv->count % 3));
+		priv->count++;
+		break;
+	case SF_RDSR:
+		in = priv->wel ? SF_SR_WEL : 0;
+		break;
+	}
+
+	return in;
+}
+
+static int sandbox_spi_xfer(struct udevice *dev, unsigned int bitlen,
+			    const void *dout, void *din, unsigned long flags)
+{
+	struct udevice *bus = dev_get_parent(dev);
+	struct sandbox_spi_plat *plat = dev_get_plat(bus);
+	struct sandbox_spi_priv *priv = dev_get_priv(bus);
+	struct dm_spi_slave_plat *slave = dev_get_parent_plat(dev);
+	const u8 *tx = dout;
+	u8 *rx = din;
+	uint len, n;
+	u8 in;
+
+	if (bitlen % 8)
+		return -EINVAL;
+	if (slave->cs != 0)
+		return -ENODEV;
+
+	if (flags & SPI_XFER_BEGIN)
+		priv->state = SF_CMD;
+
+	len = bitlen / 8;
+	while (len) {
+		if (priv->state == SF_READ) {
+			n = min(len, plat->flash_size - priv->addr);
+			if (rx) {
+				memcpy(rx, priv->flash + priv->addr, n);
+				rx += n;
+			}
+			if (tx)
+				tx += n;
+			priv->addr = (priv->addr + n) % plat->flash_size;
+			len -= n;
+			continue;
+		}
+
+		in = sandbox_sf_byte(priv, plat, tx ? *tx++ : 0xff);
+		if (rx)
+			*rx++ = in;
+		len--;
+	}
+
+	if (flags & SPI_XFER_END) {
+		if (priv->state == SF_PROGRAM)
+			priv->wel = false;
+		priv->state = SF_IDLE;
+	}
+
+	return 0;
+}
+
+static int sandbox_spi_set_speed(struct udevice *bus, uint hz)
+{
+	return 0;
+}
+
+static int sandbox_spi_set_mode(struct udevice *bus, uint mode)
+{
+	return 0;
+}
+
+static int sandbox_spi_cs_info(struct udevice *bus, uint cs,
+			       struct spi_cs_info *info)
+{
+	return cs == 0 ? 0 : -EINVAL;
+}
+
+static int sandbox_spi_of_to_plat(struct udevice *bus)
+{
+	struct sandbox_spi_plat *plat = dev_get_plat(bus);
+
+	if (!dev_has_ofnode(bus))
+		return 0;
+
+	plat->flash_size = dev_read_u32_default(bus, "flash-size",
+						SANDBOX_SPI_FLASH_SIZE);
+	plat->jedec_id = dev_read_u32_default(bus, "jedec-id", 0xef4017);
+
+	return 0;
+}
+
+static int sandbox_spi_probe(struct udevice *bus)
+{
+	struct sandbox_spi_plat *plat = dev_get_plat(bus);
+	struct sandbox_spi_priv *priv = dev_get_priv(bus);
+
+	if (!plat->flash_size)
+		return -EINVAL;
+
+	priv->flash = rtems_malloc(plat->flash_size);
+	if (!priv->flash)
+		return -ENOMEM;
+	memset(priv->flash, 0xff, plat->flash_size);
+
+	return 0;
+}
+
+static int sandbox_spi_remove(struct udevice *bus)
+{
+	struct sandbox_spi_priv *priv = dev_get_priv(bus);
+
+	free(priv->flash);
+	priv->flash = NULL;
+
+	return 0;
+}
+
+static const struct dm_spi_ops sandbox_spi_ops = {
+	.xfer		= sandbox_spi_xfer,
+	.set_speed	= sandbox_spi_set_speed,
+	.set_mode	= sandbox_spi_set_mode,
+	.cs_info	= sandbox_spi_cs_info,
+};
+
+static const struct udevice_id sandbox_spi_ids[] = {
+	{ .compatible = "sandbox,spi" },
+	{ }
+};
+
+DM_DRIVER(sandbox_spi) = {
+	.name		= "sandbox_spi",
+	.id		= UCLASS_SPI,
+	.of_match	= sandbox_spi_ids,
+	.of_to_plat	= sandbox_spi_of_to_plat,
+	.probe		= sandbox_spi_probe,
+	.remove		= sandbox_spi_remove,
+	.plat_auto	= sizeof(struct sandbox_spi_plat),
+	.priv_auto	= sizeof(struct sandbox_spi_priv),
+	.ops		= &sandbox_spi_ops,
+};
+
+#if defined(CONFIG_SANDBOX_BUS) && !CONFIG_IS_ENABLED(OF_PLATDATA)
+static struct sandbox_spi_plat sandbox_spi_plat = {
+	.flash_size	= SANDBOX_SPI_FLASH_SIZE,
+	.jedec_id	= 0xef4017,
+};
+
+U_BOOT_DRVINFO(sandbox_spi) = {
+	.name	= "sandbox_spi",
+	.plat	= &sandbox_spi_plat,
+};
+#endif
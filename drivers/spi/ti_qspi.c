@@ -20,6 +20,7 @@
 #include <asm/omap_gpio.h>
 #include <asm/omap_common.h>
 #include <asm/ti-common/ti-edma3.h>
+#include <dt-structs.h>
 #include <linux/bitops.h>
 #include <linux/err.h>
 #include <linux/kernel.h>
@@ -354,6 +355,45 @@ static int ti_qspi_exec_mem_op(struct spi_slave *slave,
 	return ret;
 }
 
+static int ti_qspi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct ti_qspi_priv *priv = dev_get_priv(desc->slave->dev->parent);
+	const struct spi_mem_op *op = &desc->info.op_tmpl;
+
+	if (!priv->memory_map || op->addr.nbytes > 4)
+		return -ENOTSUPP;
+
+	/* The whole mapping must fall inside the MMIO window */
+	if (desc->info.offset + desc->info.length > priv->mmap_size)
+		return -ENOTSUPP;
+
+	return 0;
+}
+
+/*
+ * The setup register is shared with exec_op(), so it is programmed for every
+ * read; the bus is claimed, which switches the window to memory mode.
+ */
+static ssize_t ti_qspi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				   u64 offs, size_t len, void *buf)
+{
+	struct dm_spi_slave_plat *slave_plat;
+	const struct spi_mem_op *op = &desc->info.op_tmpl;
+	struct ti_qspi_priv *priv;
+
+	priv = dev_get_priv(desc->slave->dev->parent);
+	slave_plat = dev_get_parent_plat(desc->slave->dev);
+
+	ti_qspi_setup_mmap_read(priv, slave_plat->cs, op->cmd.opcode,
+				op->data.buswidth, op->addr.nbytes,
+				op->dummy.nbytes);
+
+	ti_qspi_copy_mmap(buf, (void *)priv->memory_map +
+			  desc->info.offset + offs, len);
+
+	return len;
+}
+
 static int ti_qspi_claim_bus(struct udevice *dev)
 {
 	struct dm_spi_slave_plat *slave_plat = dev_get_parent_plat(dev);
@@ -409,7 +449,12 @@ static int ti_qspi_probe(struct udevice *bus)
 {
 	struct ti_qspi_priv *priv = dev_get_priv(bus);
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	/* Bound by driver name, so there is no match data */
+	priv->fclk = QSPI_FCLK;
+#else
 	priv->fclk = dev_get_driver_data(bus);
+#endif
 
 	return 0;
 }
@@ -456,6 +501,19 @@ static void *map_syscon_chipselects(struct udevice *bus)
 static int ti_qspi_of_to_plat(struct udevice *bus)
 {
 	struct ti_qspi_priv *priv = dev_get_priv(bus);
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dtd_ti_am4372_qspi *dtplat = dev_get_plat(bus);
+
+	/* The AM437x has no syscon-chipselects */
+	priv->ctrl_mod_mmap = NULL;
+	priv->base = map_physmem(dtplat->reg[0], sizeof(struct ti_qspi_regs),
+				 MAP_NOCACHE);
+	priv->memory_map = map_physmem(dtplat->reg[2], dtplat->reg[3],
+				       MAP_NOCACHE);
+	priv->mmap_size = dtplat->reg[3];
+	priv->max_hz = dtplat->spi_max_frequency;
+	priv->num_cs = dtplat->num_cs;
+#else
 	const void *blob = gd->fdt_blob;
 	int node = dev_of_offset(bus);
 	fdt_addr_t mmap_addr;
@@ -469,11 +527,12 @@ static int ti_qspi_of_to_plat(struct udevice *bus)
 	priv->mmap_size = mmap_size;
 
 	priv->max_hz = dev_read_u32_default(bus, "spi-max-frequency", 0);
+	priv->num_cs = fdtdec_get_int(blob, node, "num-cs", 4);
+#endif
 	if (!priv->max_hz) {
 		debug("Error: Max frequency missing\n");
 		return -ENODEV;
 	}
-	priv->num_cs = fdtdec_get_int(blob, node, "num-cs", 4);
 
 	debug("%s: regs=<0x%x>, max-frequency=%d\n", __func__,
 	      (int)priv->base, priv->max_hz);
@@ -483,6 +542,8 @@ static int ti_qspi_of_to_plat(struct udevice *bus)
 
 static const struct spi_controller_mem_ops ti_qspi_mem_ops = {
 	.exec_op = ti_qspi_exec_mem_op,
+	.dirmap_create = ti_qspi_dirmap_create,
+	.dirmap_read = ti_qspi_dirmap_read,
 };
 
 static const struct dm_spi_ops ti_qspi_ops = {
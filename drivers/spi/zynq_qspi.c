@@ -6,16 +6,25 @@
  * Xilinx Zynq Quad-SPI(QSPI) controller driver (master mode only)
  */
 
+#include <rtems.h>
+
 #include <clk.h>
 #include <common.h>
 #include <dm.h>
 #include <dm/device_compat.h>
+#include <dm/interrupt.h>
+#include <dm/of_irq.h>
+#include <dm/read.h>
+#include <dm/spi-mem.h>
 #include <log.h>
 #include <malloc.h>
 #include <spi.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
+#include <dt-structs.h>
 #include <linux/bitops.h>
+#include <linux/completion.h>
+#include <linux/jiffies.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -35,6 +44,11 @@ DECLARE_GLOBAL_DATA_PTR;
 #define ZYNQ_QSPI_IXR_ALL_MASK		GENMASK(6, 0)	/* All IXR bits */
 #define ZYNQ_QSPI_ENR_SPI_EN_MASK	BIT(0)	/* SPI Enable */
 #define ZYNQ_QSPI_LQSPICFG_LQMODE_MASK	BIT(31) /* Linear QSPI Mode */
+#define ZYNQ_QSPI_LQSPICFG_DUMMY_SHIFT	8	/* Dummy bytes shift */
+
+/* Linear (memory mapped) read window, unless given as a second reg entry */
+#define ZYNQ_QSPI_LINEAR_BASE		0xFC000000
+#define ZYNQ_QSPI_LINEAR_SIZE		(16 * 1024 * 1024)
 
 /* zynq qspi Transmit Data Register */
 #define ZYNQ_QSPI_TXD_00_00_OFFSET	0x1C	/* Transmit 4-byte inst */
@@ -51,6 +65,8 @@ DECLARE_GLOBAL_DATA_PTR;
 
 #define ZYNQ_QSPI_FIFO_DEPTH		63
 #define ZYNQ_QSPI_WAIT			(CONFIG_SYS_HZ / 100)	/* 10 ms */
+/* Interrupt mode: 10 ms plus 1 ms per 64 bytes, enough down to 1 MHz */
+#define ZYNQ_QSPI_XFER_TIMEOUT_MS(len)	(10 + (len) / 64)
 
 /* zynq qspi register set */
 struct zynq_qspi_regs {
@@ -78,9 +94,15 @@ struct zynq_qspi_regs {
 
 /* zynq qspi platform data */
 struct zynq_qspi_plat {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dtd_xlnx_zynq_qspi_1_0 dtplat;
+#endif
 	struct zynq_qspi_regs *regs;
 	u32 frequency;          /* input frequency */
 	u32 speed_hz;
+	int irq;		/* -1 to poll the status register */
+	void *linear;		/* linear read window */
+	u32 linear_size;
 };
 
 /* zynq qspi priv */
@@ -97,16 +119,55 @@ struct zynq_qspi_priv {
 	int bytes_to_receive;
 	unsigned int is_inst;
 	unsigned cs_change:1;
+	unsigned use_irq:1;
+	u32 rx_words;		/* words in flight in interrupt mode */
+	int xfer_status;
+	struct completion done;
+	rtems_interrupt_lock lock;	/* held by zynq_qspi_isr() */
+	void *linear;
+	u32 linear_size;
 };
 
 static int zynq_qspi_of_to_plat(struct udevice *bus)
 {
 	struct zynq_qspi_plat *plat = dev_get_plat(bus);
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dtd_xlnx_zynq_qspi_1_0 *dtplat = &plat->dtplat;
+	unsigned int irq, type;
+
+	plat->regs = (struct zynq_qspi_regs *)dtplat->reg[0];
+	plat->irq = -1;
+	if (!of_irq_translate_cells(dtplat->interrupts,
+				    ARRAY_SIZE(dtplat->interrupts), &irq,
+				    &type))
+		plat->irq = irq;
+
+	plat->linear = (void *)ZYNQ_QSPI_LINEAR_BASE;
+	plat->linear_size = ZYNQ_QSPI_LINEAR_SIZE;
+	if (ARRAY_SIZE(dtplat->reg) >= 4) {
+		plat->linear = (void *)dtplat->reg[2];
+		plat->linear_size = dtplat->reg[3];
+	}
+#else
 	const void *blob = gd->fdt_blob;
 	int node = dev_of_offset(bus);
+	fdt_addr_t addr;
+	fdt_size_t size;
 
 	plat->regs = (struct zynq_qspi_regs *)fdtdec_get_addr(blob,
 							      node, "reg");
+	plat->irq = (int)dev_read_irq_index(bus, 0, NULL);
+	if (plat->irq == (int)FDT_ADDR_T_NONE)
+		plat->irq = -1;
+
+	addr = dev_read_addr_size_index(bus, 1, &size);
+	if (addr == FDT_ADDR_T_NONE) {
+		addr = ZYNQ_QSPI_LINEAR_BASE;
+		size = ZYNQ_QSPI_LINEAR_SIZE;
+	}
+	plat->linear = (void *)addr;
+	plat->linear_size = size;
+#endif
 
 	return 0;
 }
@@ -170,6 +231,8 @@ static void zynq_qspi_init_hw(struct zynq_qspi_priv *priv)
 	writel(ZYNQ_QSPI_ENR_SPI_EN_MASK, &regs->enr);
 }
 
+static void zynq_qspi_isr(void *arg);
+
 static int zynq_qspi_probe(struct udevice *bus)
 {
 	struct zynq_qspi_plat *plat = dev_get_plat(bus);
@@ -180,8 +243,15 @@ static int zynq_qspi_probe(struct udevice *bus)
 
 	priv->regs = plat->regs;
 	priv->fifo_depth = ZYNQ_QSPI_FIFO_DEPTH;
+	priv->linear = plat->linear;
+	priv->linear_size = plat->linear_size;
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	/* "ref_clk" comes first in clock-names */
+	ret = clk_get_by_driver_info(bus, plat->dtplat.clocks, &clk);
+#else
 	ret = clk_get_by_name(bus, "ref_clk", &clk);
+#endif
 	if (ret < 0) {
 		dev_err(bus, "failed to get clock\n");
 		return ret;
@@ -202,6 +272,16 @@ static int zynq_qspi_probe(struct udevice *bus)
 	/* init the zynq spi hw */
 	zynq_qspi_init_hw(priv);
 
+	if (plat->irq >= 0) {
+		rtems_interrupt_lock_initialize(&priv->lock, bus->name);
+		ret = devm_request_threaded_irq(bus, plat->irq, zynq_qspi_isr,
+						NULL, 0, NULL, priv);
+		if (ret)
+			dev_warn(bus, "no interrupt (%d), polling\n", ret);
+		else
+			priv->use_irq = 1;
+	}
+
 	plat->frequency = clock;
 	plat->speed_hz = plat->frequency / 2;
 
@@ -332,8 +412,11 @@ static void zynq_qspi_chipselect(struct  zynq_qspi_priv *priv, int is_on)
  * zynq_qspi_fill_tx_fifo - Fills the TX FIFO with as many bytes as possible
  * @priv:	Pointer to the zynq_qspi_priv structure
  * @size:	Number of bytes to be copied to fifo
+ *
+ * returns:	Number of FIFO words written, each of which clocks one word
+ *		into the RX FIFO
  */
-static void zynq_qspi_fill_tx_fifo(struct zynq_qspi_priv *priv, u32 size)
+static u32 zynq_qspi_fill_tx_fifo(struct zynq_qspi_priv *priv, u32 size)
 {
 	u32 data = 0;
 	u32 fifocount = 0;
@@ -360,15 +443,100 @@ static void zynq_qspi_fill_tx_fifo(struct zynq_qspi_priv *priv, u32 size)
 			if (!(readl(&regs->isr)
 					& ZYNQ_QSPI_IXR_TXOW_MASK) &&
 					!priv->rx_buf)
-				return;
+				return fifocount;
 			len = priv->bytes_to_transfer;
 			zynq_qspi_write_data(priv, &data, len);
 			offset = (priv->rx_buf) ? offsets[0] : offsets[len];
 			writel(data, &regs->cr + (offset / 4));
+			fifocount++;
+		}
+	}
+
+	return fifocount;
+}
+
+/**
+ * zynq_qspi_drain_rx - Copy received words to the RX buffer
+ * @priv:	Pointer to the zynq_qspi_priv structure
+ * @count:	Number of words to read from the RX FIFO
+ */
+static void zynq_qspi_drain_rx(struct zynq_qspi_priv *priv, u32 count)
+{
+	struct zynq_qspi_regs *regs = priv->regs;
+	u32 data;
+
+	while (count--) {
+		data = readl(&regs->drxr);
+
+		if (priv->bytes_to_receive >= 4) {
+			if (priv->rx_buf) {
+				memcpy(priv->rx_buf, &data, 4);
+				priv->rx_buf += 4;
+			}
+			priv->bytes_to_receive -= 4;
+		} else {
+			zynq_qspi_read_data(priv, data,
+					    priv->bytes_to_receive);
 		}
 	}
 }
 
+/**
+ * zynq_qspi_irq_arm - Let the next interrupt fire once @words have arrived
+ * @priv:	Pointer to the zynq_qspi_priv structure
+ * @words:	Number of words written to the TX FIFO
+ *
+ * The RX "not empty" status asserts at the RX threshold, so setting the
+ * threshold to the number of words in flight gives one interrupt per FIFO
+ * load, when the whole load has been shifted.
+ */
+static void zynq_qspi_irq_arm(struct zynq_qspi_priv *priv, u32 words)
+{
+	struct zynq_qspi_regs *regs = priv->regs;
+
+	priv->rx_words = words;
+	writel(words, &regs->rxftr);
+	writel(ZYNQ_QSPI_IXR_RXNEMPTY_MASK, &regs->ier);
+}
+
+/**
+ * zynq_qspi_isr - Interrupt handler of the QSPI controller
+ * @arg:	Pointer to the zynq_qspi_priv structure
+ *
+ * Runs in interrupt context: drains the words of the completed FIFO load,
+ * refills the TX FIFO and completes the transfer when everything has been
+ * received.
+ */
+static void zynq_qspi_isr(void *arg)
+{
+	struct zynq_qspi_priv *priv = arg;
+	struct zynq_qspi_regs *regs = priv->regs;
+	rtems_interrupt_lock_context ctx;
+	u32 status;
+
+	rtems_interrupt_lock_acquire_isr(&priv->lock, &ctx);
+	status = readl(&regs->isr);
+	writel(status, &regs->isr);
+	writel(ZYNQ_QSPI_IXR_ALL_MASK, &regs->idr);
+
+	if (!(status & ZYNQ_QSPI_IXR_RXNEMPTY_MASK) || !priv->rx_words)
+		goto out;
+
+	zynq_qspi_drain_rx(priv, priv->rx_words);
+	priv->rx_words = 0;
+
+	if (priv->bytes_to_transfer) {
+		zynq_qspi_irq_arm(priv,
+			zynq_qspi_fill_tx_fifo(priv, priv->fifo_depth));
+		goto out;
+	}
+
+	priv->xfer_status = priv->bytes_to_receive ? -EIO : 1;
+	complete(&priv->done);
+out:
+	rtems_interrupt_lock_release_isr(&priv->lock, &ctx);
+}
+
 /**
  * zynq_qspi_irq_poll - Interrupt service routine of the QSPI controller
  * @priv:	Pointer to the zynq_qspi structure
@@ -386,7 +554,6 @@ static void zynq_qspi_fill_tx_fifo(struct zynq_qspi_priv *priv, u32 size)
 static int zynq_qspi_irq_poll(struct zynq_qspi_priv *priv)
 {
 	struct zynq_qspi_regs *regs = priv->regs;
-	u32 rxindex = 0;
 	u32 rxcount;
 	u32 status, timeout;
 
@@ -415,24 +582,8 @@ static int zynq_qspi_irq_poll(struct zynq_qspi_priv *priv)
 		 */
 		rxcount = priv->bytes_to_receive - priv->bytes_to_transfer;
 		rxcount = (rxcount % 4) ? ((rxcount/4)+1) : (rxcount/4);
-		while ((rxindex < rxcount) &&
-				(rxindex < ZYNQ_QSPI_RXFIFO_THRESHOLD)) {
-			/* Read out the data from the RX FIFO */
-			u32 data;
-			data = readl(&regs->drxr);
-
-			if (priv->bytes_to_receive >= 4) {
-				if (priv->rx_buf) {
-					memcpy(priv->rx_buf, &data, 4);
-					priv->rx_buf += 4;
-				}
-				priv->bytes_to_receive -= 4;
-			} else {
-				zynq_qspi_read_data(priv, data,
-						    priv->bytes_to_receive);
-			}
-			rxindex++;
-		}
+		zynq_qspi_drain_rx(priv, min_t(u32, rxcount,
+					       ZYNQ_QSPI_RXFIFO_THRESHOLD));
 
 		if (priv->bytes_to_transfer) {
 			/* There is more data to send */
@@ -457,6 +608,53 @@ static int zynq_qspi_irq_poll(struct zynq_qspi_priv *priv)
 	return 0;
 }
 
+/**
+ * zynq_qspi_irq_transfer - Run the transfer from the interrupt handler
+ * @priv:	Pointer to the zynq_qspi_priv structure
+ *
+ * The calling task sleeps until zynq_qspi_isr() has received every word.
+ *
+ * returns:	Number of bytes transferred, -ve on error
+ */
+static int zynq_qspi_irq_transfer(struct zynq_qspi_priv *priv)
+{
+	struct zynq_qspi_regs *regs = priv->regs;
+	rtems_interrupt_lock_context ctx;
+	unsigned long timeout;
+	u32 words;
+
+	reinit_completion(&priv->done);
+	priv->xfer_status = 0;
+
+	words = zynq_qspi_fill_tx_fifo(priv, priv->fifo_depth);
+	zynq_qspi_irq_arm(priv, words);
+
+	timeout = wait_for_completion_timeout(&priv->done,
+		msecs_to_jiffies(ZYNQ_QSPI_XFER_TIMEOUT_MS(priv->len)));
+	if (timeout == 0) {
+		/*
+		 * Once the handler has let go of the lock it cannot run again,
+		 * but it may have completed the transfer just now: take that
+		 * back so that the next transfer does not see it.
+		 */
+		rtems_interrupt_lock_acquire(&priv->lock, &ctx);
+		writel(ZYNQ_QSPI_IXR_ALL_MASK, &regs->idr);
+		priv->rx_words = 0;
+		rtems_interrupt_lock_release(&priv->lock, &ctx);
+		try_wait_for_completion(&priv->done);
+		printf("zynq_qspi_irq_transfer: Timeout!\n");
+		zynq_qspi_init_hw(priv);
+		return -ETIMEDOUT;
+	}
+
+	/* Back to the threshold the polled path expects */
+	writel(ZYNQ_QSPI_RXFIFO_THRESHOLD, &regs->rxftr);
+	if (priv->xfer_status < 0)
+		return priv->xfer_status;
+
+	return (priv->len) - (priv->bytes_to_transfer);
+}
+
 /**
  * zynq_qspi_start_transfer - Initiates the QSPI transfer
  * @priv:	Pointer to the zynq_qspi_priv structure
@@ -477,6 +675,9 @@ static int zynq_qspi_start_transfer(struct zynq_qspi_priv *priv)
 	priv->bytes_to_transfer = priv->len;
 	priv->bytes_to_receive = priv->len;
 
+	if (priv->use_irq)
+		return zynq_qspi_irq_transfer(priv);
+
 	if (priv->len < 4)
 		zynq_qspi_fill_tx_fifo(priv, priv->len);
 	else
@@ -649,12 +850,87 @@ static int zynq_qspi_set_mode(struct udevice *bus, uint mode)
 	return 0;
 }
 
+static int zynq_qspi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct zynq_qspi_priv *priv = dev_get_priv(desc->slave->dev->parent);
+	struct dm_spi_slave_plat *slave_plat;
+	const struct spi_mem_op *op = &desc->info.op_tmpl;
+
+	slave_plat = dev_get_parent_plat(desc->slave->dev);
+
+	/*
+	 * The linear mode sends one of the read opcodes below with a 3 byte
+	 * address to the flash on CS0, and maps the first 16 MiB.
+	 */
+	switch (op->cmd.opcode) {
+	case 0x03:	/* READ */
+	case 0x0b:	/* FAST_READ */
+	case 0x3b:	/* READ_1_1_2 */
+	case 0x6b:	/* READ_1_1_4 */
+	case 0xbb:	/* READ_1_2_2 */
+	case 0xeb:	/* READ_1_4_4 */
+		break;
+	default:
+		return -ENOTSUPP;
+	}
+	if (slave_plat->cs != 0 || op->addr.nbytes != 3 ||
+	    op->dummy.nbytes > 7)
+		return -ENOTSUPP;
+	if (desc->info.offset + desc->info.length > priv->linear_size)
+		return -ENOTSUPP;
+
+	return 0;
+}
+
+/*
+ * Switch to linear mode for the copy only, so that the I/O mode transfers
+ * of xfer() keep working between reads.
+ */
+static ssize_t zynq_qspi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				     u64 offs, size_t len, void *buf)
+{
+	struct zynq_qspi_priv *priv = dev_get_priv(desc->slave->dev->parent);
+	const struct spi_mem_op *op = &desc->info.op_tmpl;
+	struct zynq_qspi_regs *regs = priv->regs;
+	void *src = priv->linear + desc->info.offset + offs;
+	u32 confr, lqcfg;
+
+	confr = readl(&regs->cr);
+	lqcfg = readl(&regs->lqspicfg);
+
+	writel(~ZYNQ_QSPI_ENR_SPI_EN_MASK, &regs->enr);
+	writel((confr & ~(ZYNQ_QSPI_CR_MCS_MASK | ZYNQ_QSPI_CR_SS_MASK)) |
+	       ((~1 << ZYNQ_QSPI_CR_SS_SHIFT) & ZYNQ_QSPI_CR_SS_MASK),
+	       &regs->cr);
+	writel(ZYNQ_QSPI_LQSPICFG_LQMODE_MASK |
+	       op->dummy.nbytes << ZYNQ_QSPI_LQSPICFG_DUMMY_SHIFT |
+	       op->cmd.opcode, &regs->lqspicfg);
+	writel(ZYNQ_QSPI_ENR_SPI_EN_MASK, &regs->enr);
+
+	/* Flash contents may have changed through I/O mode writes */
+	rtems_cache_invalidate_multiple_data_lines(src, len);
+	memcpy(buf, src, len);
+
+	writel(~ZYNQ_QSPI_ENR_SPI_EN_MASK, &regs->enr);
+	writel(lqcfg & ~ZYNQ_QSPI_LQSPICFG_LQMODE_MASK, &regs->lqspicfg);
+	writel(confr, &regs->cr);
+	writel(ZYNQ_QSPI_ENR_SPI_EN_MASK, &regs->enr);
+
+	return len;
+}
+
+static const struct spi_controller_mem_ops zynq_qspi_mem_ops = {
+	.dirmap_create	= zynq_qspi_dirmap_create,
+	.dirmap_read	= zynq_qspi_dirmap_read,
+};
+
 static const struct dm_spi_ops zynq_qspi_ops = {
 	.claim_bus      = zynq_qspi_claim_bus,
 	.release_bus    = zynq_qspi_release_bus,
 	.xfer           = zynq_qspi_xfer,
 	.set_speed      = zynq_qspi_set_speed,
 	.set_mode       = zynq_qspi_set_mode,
+	.mem_ops        = &zynq_qspi_mem_ops,
 };
 
 static const struct udevice_id zynq_qspi_ids[] = {
@@ -234,6 +234,34 @@ struct fdtdec_phandle_args;
 int gpio_xlate_offs_flags(struct udevice *dev, struct gpio_desc *desc,
 			  struct ofnode_phandle_args *args);
 
+/**
+ * struct gpio_mmio - Registers through which a GPIO can be driven directly
+ *
+ * Returned by dm_gpio_get_mmio() for users which toggle a GPIO at a high
+ * rate, such as a bit-banged bus, and cannot afford a uclass and driver
+ * call per edge. Only direction and input level are described: such users
+ * emulate an open-drain line by leaving the output latch low and switching
+ * between output (low) and input (released).
+ *
+ * @dir:	Direction register
+ * @dir_mask:	Bits of @dir which belong to the GPIO
+ * @dir_out:	Value of those bits which makes the GPIO an output
+ * @dir_in:	Value of those bits which makes the GPIO an input
+ * @in:		Input data register
+ * @in_mask:	Bit of @in giving the level at the pin
+ * @lock:	Lock to hold across a read-modify-write of @dir, filled in by
+ *		the uclass
+ */
+struct gpio_mmio {
+	void __iomem *dir;
+	u32 dir_mask;
+	u32 dir_out;
+	u32 dir_in;
+	void __iomem *in;
+	u32 in_mask;
+	rtems_interrupt_lock *lock;
+};
+
 /**
  * struct struct dm_gpio_ops - Driver model GPIO operations
  *
@@ -376,6 +404,68 @@ struct dm_gpio_ops {
 	int (*get_flags)(struct udevice *dev, unsigned int offset,
 			 ulong *flagsp);
 
+	/**
+	 * get_port() - Read the levels of several GPIOs at once
+	 *
+	 * Bit n of @mask and of the value refers to the GPIO at @offset + n.
+	 * The driver should read each register of the bank once, rather than
+	 * once per GPIO. Bits not set in @mask may hold any value. The value
+	 * is the level at the pin (1=high, 0=low); the uclass handles
+	 * GPIOD_ACTIVE_LOW.
+	 *
+	 * This method is optional. Without it the uclass calls get_value()
+	 * for each GPIO in @mask.
+	 *
+	 * @dev:	GPIO device
+	 * @offset:	Offset of the GPIO in bit 0 of @mask
+	 * @mask:	GPIOs to read
+	 * @valuep:	Place to put the levels
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*get_port)(struct udevice *dev, unsigned int offset, ulong mask,
+			ulong *valuep);
+
+	/**
+	 * set_port() - Drive several output GPIOs at once
+	 *
+	 * Each GPIO in @mask is set to the level of the matching bit of
+	 * @value, in a single register write where the hardware allows it.
+	 * GPIOs not in @mask must be left untouched, including any that are
+	 * changed concurrently from interrupt context, so drivers should use
+	 * set/clear or masked data registers in preference to a
+	 * read-modify-write of the data register.
+	 *
+	 * This method is optional. Without it the uclass calls set_value()
+	 * for each GPIO in @mask.
+	 *
+	 * @dev:	GPIO device
+	 * @offset:	Offset of the GPIO in bit 0 of @mask
+	 * @mask:	GPIOs to drive
+	 * @value:	Levels to drive (1=high, 0=low)
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*set_port)(struct udevice *dev, unsigned int offset, ulong mask,
+			ulong value);
+
+	/**
+	 * get_mmio() - Describe the registers controlling a GPIO
+	 *
+	 * The driver fills in everything but @mmio->lock. Writing @dir_out
+	 * to the @dir_mask bits of @dir must make the GPIO an output
+	 * driving the level in its data register, writing @dir_in must make
+	 * it an input.
+	 *
+	 * This method is optional.
+	 *
+	 * @dev:	GPIO device
+	 * @offset:	GPIO offset within that device
+	 * @mmio:	Place to put the register description
+	 * @return 0 if OK, -EINVAL if the GPIO cannot be used that way,
+	 *	other -ve on error
+	 */
+	int (*get_mmio)(struct udevice *dev, unsigned int offset,
+			struct gpio_mmio *mmio);
+
 #if CONFIG_IS_ENABLED(ACPIGEN)
 	/**
 	 * get_acpi() - Get the ACPI info for a GPIO
@@ -781,6 +871,105 @@ int dm_gpio_get_value(const struct gpio_desc *desc);
 int dm_gpio_set_value_nocheck(const struct gpio_desc *desc, int value);
 int dm_gpio_set_value(const struct gpio_desc *desc, int value);
 
+/**
+ * struct gpio_port - A group of GPIOs on one device accessed together
+ *
+ * Set up by gpio_port_init() from a list of GPIOs which have already been
+ * requested, so that gpio_port_get() and gpio_port_set() go straight to the
+ * driver with no lookup or per-GPIO checks. Bit n of a port value refers to
+ * the GPIO at offset @base + n within @dev; when the list is contiguous and
+ * in ascending order this is also the n'th GPIO of the list.
+ *
+ * @dev:	GPIO device holding all the GPIOs
+ * @base:	Offset within @dev of the GPIO in bit 0
+ * @mask:	GPIOs which belong to the port
+ * @invert:	GPIOs which are active low
+ */
+struct gpio_port {
+	struct udevice *dev;
+	uint base;
+	ulong mask;
+	ulong invert;
+};
+
+/**
+ * dm_gpio_get_port() - Read the levels of several GPIOs on a device
+ *
+ * @dev:	GPIO device
+ * @offset:	Offset of the GPIO in bit 0 of @mask
+ * @mask:	GPIOs to read, bit n being the GPIO at @offset + n
+ * @valuep:	Returns the levels at the pins (1=high), masked by @mask
+ * @return 0 if OK, -ve on error
+ */
+int dm_gpio_get_port(struct udevice *dev, uint offset, ulong mask,
+		     ulong *valuep);
+
+/**
+ * dm_gpio_set_port() - Drive several output GPIOs on a device
+ *
+ * @dev:	GPIO device
+ * @offset:	Offset of the GPIO in bit 0 of @mask
+ * @mask:	GPIOs to drive, bit n being the GPIO at @offset + n
+ * @value:	Levels to drive (1=high); GPIOs not in @mask are left alone
+ * @return 0 if OK, -ve on error
+ */
+int dm_gpio_set_port(struct udevice *dev, uint offset, ulong mask,
+		     ulong value);
+
+/**
+ * dm_gpio_get_mmio() - Get the registers controlling a GPIO
+ *
+ * See struct gpio_mmio. The levels in the registers are those at the pin,
+ * GPIOD_ACTIVE_LOW is not taken into account.
+ *
+ * @desc:	GPIO description, previously requested
+ * @mmio:	Returns the register description
+ * @return 0 if OK, -ENOSYS if the driver does not support it, other -ve on
+ *	error
+ */
+int dm_gpio_get_mmio(const struct gpio_desc *desc, struct gpio_mmio *mmio);
+
+/**
+ * gpio_port_init() - Group a list of GPIOs into a port
+ *
+ * The GPIOs must have been requested, must all be on the same device and
+ * must span no more than BITS_PER_LONG offsets. Open-drain and open-source
+ * GPIOs cannot be part of a port, since driving them means changing their
+ * direction one by one.
+ *
+ * @port:	Port to set up
+ * @desc_list:	List of GPIOs
+ * @count:	Number of GPIOs
+ * @return 0 if OK, -EXDEV if the GPIOs are on different devices, -ERANGE if
+ *	they span too many offsets, -EBUSY if one is not requested, other -ve
+ *	on error
+ */
+int gpio_port_init(struct gpio_port *port, const struct gpio_desc *desc_list,
+		   int count);
+
+/**
+ * gpio_port_get() - Read the values of the GPIOs in a port
+ *
+ * @port:	Port to read
+ * @valuep:	Returns the values (1=active), see struct gpio_port for the
+ *		bit layout
+ * @return 0 if OK, -ve on error
+ */
+int gpio_port_get(const struct gpio_port *port, ulong *valuep);
+
+/**
+ * gpio_port_set() - Set the values of some of the GPIOs in a port
+ *
+ * All GPIOs in @mask change together where the driver supports it, which
+ * makes this suitable for strobing a parallel bus.
+ *
+ * @port:	Port to update
+ * @mask:	GPIOs to update, bits outside the port are ignored
+ * @value:	Values to set (1=active)
+ * @return 0 if OK, -ve on error
+ */
+int gpio_port_set(const struct gpio_port *port, ulong mask, ulong value);
+
 /**
  * dm_gpio_clrset_flags() - Update flags
  *
@@ -0,0 +1,63 @@
+#ifndef BASE_BOOTTIME_H_
+#define BASE_BOOTTIME_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <rtems/counter.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*
+ * Boot event kinds
+ */
+#define BOOTTIME_SYSINIT  0
+#define BOOTTIME_MODULE   1
+#define BOOTTIME_BIND     2
+#define BOOTTIME_PROBE    3
+#define BOOTTIME_PHASE    4
+#define BOOTTIME_KINDS    5
+
+typedef rtems_counter_ticks boottime_t;
+
+#ifdef CONFIG_BOOTTIME
+/*
+ * Record the span from @begin (a boottime_begin() value) to now in the boot
+ * event ring. @name is copied, truncated to 31 characters.
+ */
+void boottime_end(const char *name, int kind, boottime_t begin);
+
+/*
+ * Print the recorded events as an indented call tree (flame-style), or as a
+ * flat list sorted by duration if @by_duration is true. Events shorter than
+ * @min_us microseconds are left out.
+ */
+void boottime_dump(bool by_duration, unsigned long min_us);
+
+/*
+ * Write the recorded events in the text format read by
+ * tools/scripts/boottime_trace.py
+ */
+void boottime_export(FILE *fp);
+
+static inline boottime_t boottime_begin(void) {
+    return rtems_counter_read();
+}
+#else
+static inline boottime_t boottime_begin(void) {
+    return 0;
+}
+
+static inline void boottime_end(const char *name, int kind,
+    boottime_t begin) {
+    (void) name;
+    (void) kind;
+    (void) begin;
+}
+#endif /* CONFIG_BOOTTIME */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* BASE_BOOTTIME_H_ */
@@ -215,6 +215,70 @@ int device_remove(struct udevice *dev, uint flags);
 int device_unbind(struct udevice *dev);
 void device_free(struct udevice *dev);
 
+/**
+ * device_defer() - Queue a device whose probe returned -EPROBE_DEFER
+ *
+ * The device stays on the deferred list until a later probe of it succeeds,
+ * fails with another error or the device is unbound.
+ *
+ * @dev: Device to queue
+ */
+void device_defer(struct udevice *dev);
+
+/**
+ * device_defer_cancel() - Drop a device from the deferred list
+ *
+ * @dev: Device to drop, nothing happens if it is not queued
+ */
+void device_defer_cancel(struct udevice *dev);
+
+/**
+ * device_defer_trigger() - Retry the probe of all deferred devices
+ *
+ * Called by device_defer_leave() once a successful probe has unwound. Devices
+ * which defer again stay queued; the list is walked again as long as some
+ * retry succeeds.
+ */
+void device_defer_trigger(void);
+
+/**
+ * device_defer_enter() - Note that a device_probe() call has started
+ *
+ * Calls nest, e.g. when a probe() method probes its supplier.
+ */
+void device_defer_enter(void);
+
+/**
+ * device_defer_leave() - Note that a device_probe() call has returned
+ *
+ * Once no call is in progress in any task, the deferred list is retried if
+ * any of the probes which returned meanwhile succeeded.
+ *
+ * @probed: true if the probe which returned succeeded
+ */
+void device_defer_leave(bool probed);
+
+/**
+ * device_defer_count() - Get the number of devices still deferred
+ *
+ * @return number of queued devices
+ */
+int device_defer_count(void);
+
+/**
+ * dm_core_lock() - Lock the driver model's shared state
+ *
+ * Taken around changes to the uclass list, the per-uclass device arrays,
+ * child lists and devres lists, so that parallel probe workers can bind
+ * devices and allocate resources at the same time. May be nested.
+ */
+void dm_core_lock(void);
+
+/**
+ * dm_core_unlock() - Release the lock taken by dm_core_lock()
+ */
+void dm_core_unlock(void);
+
 
 /**
  * device_chld_unbind() - Unbind all device's children from the device if bound
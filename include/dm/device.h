@@ -80,6 +80,14 @@ struct driver_info;
  */
 #define DM_FLAG_VITAL			(1 << 14)
 
+/*
+ * Device is not probed at boot but on first use, e.g. uclass_get_device() or
+ * device_get_child(). Set on the device when its driver, its uclass (see
+ * DM_UC_FLAG_PROBE_LAZY) or its "u-boot,dm-lazy" node asks for it. Probing an
+ * eager child still probes its lazy parent.
+ */
+#define DM_FLAG_PROBE_LAZY		(1 << 15)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
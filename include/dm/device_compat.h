@@ -120,4 +120,23 @@
 #define dev_vdbg(dev, fmt, ...) \
 	__dev_printk(LOGL_DEBUG_CONTENT, dev, fmt, ##__VA_ARGS__)
 
+struct udevice;
+
+/**
+ * dev_err_probe() - Report a probe error, remembering why a probe deferred
+ * @dev: Device being probed
+ * @err: Error about to be returned from probe()
+ * @fmt: Format string describing the cause
+ * @...: Arguments for @fmt
+ *
+ * Meant for ``return dev_err_probe(dev, ret, "...")`` in probe() methods. An
+ * -EPROBE_DEFER is only logged at debug level and its message is kept as the
+ * reason shown by the deferred device list; other errors are logged with
+ * dev_err().
+ *
+ * Return: @err
+ */
+int dev_err_probe(struct udevice *dev, int err, const char *fmt, ...)
+	__attribute__ ((format (__printf__, 3, 4)));
+
 #endif
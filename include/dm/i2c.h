@@ -17,7 +17,9 @@
 #define DM_I2C_H_
 
 #include <rtems/thread.h>
+#include <rtems.h>
 #include "linker_lists.h"
+#include "linux/list.h"
 
 /*
  * For now there are essentially two parts to this file - driver model
@@ -122,11 +124,21 @@ struct dm_i2c_chip {
  *
  * @speed_hz: Bus speed in hertz (typically 100000)
  * @max_transaction_bytes: Maximal size of single I2C transfer
+ * @queue: Transactions waiting for the bus (struct i2c_xfer)
+ * @active: Transaction started with xfer_async(), NULL if the bus is idle
+ * @cookie: Incremented each time a transaction is started
+ * @hold: No new transaction is started while set (speed change)
+ * @qlock: Protects @queue, @active, @cookie and @hold
  */
 struct dm_i2c_bus {
     rtems_mutex lock;
 	int speed_hz;
 	int max_transaction_bytes;
+	struct list_head queue;
+	struct i2c_xfer *active;
+	uint cookie;
+	bool hold;
+	rtems_interrupt_lock qlock;
 };
 
 /*
@@ -258,6 +270,68 @@ int dm_i2c_reg_write(struct udevice *dev, uint offset, unsigned int val);
  */
 int dm_i2c_xfer(struct udevice *bus, struct i2c_msg *msg, int nmsgs);
 
+struct i2c_xfer;
+
+/**
+ * struct i2c_xfer - An I2C transaction queued with dm_i2c_xfer_async()
+ *
+ * @msgs: Messages of the transaction, which must stay valid until @done
+ * @nmsgs: Number of messages
+ * @done: Called once the transaction has finished, with @result set. This
+ *	may run in the context of the bus interrupt and must not block, but
+ *	it may queue another transaction.
+ * @priv: Free for use by the caller
+ * @result: Value returned by the driver for the transfer, -ve on error
+ * @node: Entry in the bus queue, used by the uclass
+ */
+struct i2c_xfer {
+	struct i2c_msg *msgs;
+	int nmsgs;
+	void (*done)(struct i2c_xfer *xfer);
+	void *priv;
+	int result;
+	struct list_head node;
+};
+
+/**
+ * dm_i2c_xfer_async() - Queue a transaction without waiting for it
+ *
+ * Transactions on a bus run in the order they were queued. With a driver
+ * which implements xfer_async() the next one is started from the
+ * completion of the previous, without a task switch in between. With
+ * other drivers the transaction runs before this function returns.
+ *
+ * @bus:	Bus to use for transfer
+ * @xfer:	Transaction to queue
+ * @return 0 if queued, -ve on error (@done is not called then)
+ */
+int dm_i2c_xfer_async(struct udevice *bus, struct i2c_xfer *xfer);
+
+/**
+ * i2c_xfer_cookie() - Get the tag of the transaction being started
+ *
+ * Called by drivers from xfer_async() and passed back to
+ * i2c_xfer_complete(), so that the completion of a transfer which was
+ * aborted after a timeout is not taken for the one started after it.
+ *
+ * @bus:	Bus which is starting a transfer
+ * @return tag of the transfer
+ */
+uint i2c_xfer_cookie(struct udevice *bus);
+
+/**
+ * i2c_xfer_complete() - Finish the transaction started by xfer_async()
+ *
+ * Called by drivers, from their interrupt handling, when the transfer
+ * started by xfer_async() is done. The next queued transaction is
+ * started before the completion callback runs. A stale @cookie is ignored.
+ *
+ * @bus:	Bus whose transfer is done
+ * @cookie:	Value of i2c_xfer_cookie() when the transfer was started
+ * @result:	What xfer() would have returned for this transfer
+ */
+void i2c_xfer_complete(struct udevice *bus, uint cookie, int result);
+
 /**
  * dm_i2c_set_bus_speed() - set the speed of a bus
  *
@@ -382,6 +456,33 @@ struct dm_i2c_ops {
 	 */
 	int (*xfer)(struct udevice *bus, struct i2c_msg *msg, int nmsgs);
 
+	/**
+	 * xfer_async() - start a list of I2C messages (optional)
+	 *
+	 * Like xfer() but returns once the transfer is started. The driver
+	 * then calls i2c_xfer_complete() when it is done, which may call
+	 * this method again for the next transaction. All transfers go
+	 * through here when it is provided.
+	 *
+	 * @bus:	Bus to use
+	 * @msg:	List of messages to transfer
+	 * @nmsgs:	Number of messages in the list
+	 * @return 0 if the transfer was started, -ve on error (the transfer
+	 *	is then not completed)
+	 */
+	int (*xfer_async)(struct udevice *bus, struct i2c_msg *msg, int nmsgs);
+
+	/**
+	 * xfer_abort() - give up the transfer started by xfer_async()
+	 *
+	 * Called when a transfer did not complete in time. The driver must
+	 * reset the controller and not call i2c_xfer_complete() for it.
+	 * Required with xfer_async().
+	 *
+	 * @bus:	Bus to reset
+	 */
+	void (*xfer_abort)(struct udevice *bus);
+
 	/**
 	 * probe_chip() - probe for the presense of a chip address
 	 *
@@ -1,6 +1,7 @@
 #ifndef DM_INTERRUPT_H_
 #define DM_INTERRUPT_H_
 
+#include <stdbool.h>
 #include <bsp/irq-generic.h>
 
 #ifdef __cplusplus
@@ -13,6 +14,8 @@ struct udevice;
  * Interrupt flags
  */
 #define IRQF_SHARED		0x00000080
+/* Run thread_fn on the high priority interrupt thread of its CPU */
+#define IRQF_THREAD_HIGH	0x00000100
 
 #define IRQF_CPU_MASK   0xFF000000
 #define IRQF_CPU(n)     (((n) << 24) & IRQF_CPU_MASK) 
@@ -25,6 +28,12 @@ int devm_request_threaded_irq(struct udevice *dev, unsigned int irq,
                   void *arg);
 void devm_free_irq(struct udevice *dev, unsigned int irq, void *arg);
 
+/*
+ * Print the wakeup, coalescing, latency and runtime statistics of each
+ * threaded interrupt, with the full histograms if @histogram is true
+ */
+void dm_dump_irq_threads(bool histogram);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,19 @@
 #include <dm/ofnode.h>
 #include <dm/uclass-id.h>
 
+/**
+ * lists_init() - Build the driver lookup index
+ *
+ * This indexes the driver names, the compatible strings of every driver's
+ * of_match table and the uclass drivers from the linker lists, so that
+ * lists_driver_lookup_name(), lists_uclass_lookup() and lists_bind_fdt() do
+ * not have to walk every driver on each call. Until this has been called
+ * (or if it fails) the lookups fall back to a linear search.
+ *
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int lists_init(void);
+
 /**
  * lists_driver_lookup_name() - Return u_boot_driver corresponding to name
  *
@@ -20,13 +20,11 @@ typedef u32 phandle;
  * @name: Property name
  * @length: Length of property in bytes
  * @value: Pointer to property value
- * @next: Pointer to next property, or NULL if none
  */
 struct property {
 	char *name;
 	int length;
 	void *value;
-	struct property *next;
 };
 
 /**
@@ -36,10 +34,13 @@ struct property {
  * @type: Node type (value of device_type property) or "<NULL>" if none
  * @phandle: Phandle value of this none, or 0 if none
  * @full_name: Full path to node, e.g. "/bus@1/spi@1100"
- * @properties: Pointer to head of list of properties, or NULL if none
+ * @properties: Array of the node's properties in tree order, or NULL if none
  * @parent: Pointer to parent node, or NULL if this is the root node
  * @child: Pointer to head of child node list, or NULL if no children
  * @sibling: Pointer to the next sibling node, or NULL if this is the last
+ * @prop_order: Indexes into @properties, sorted by interned name pointer, or
+ *	NULL if some names are not interned (see of_name_intern())
+ * @prop_count: Number of entries in @properties
  */
 struct device_node {
 	const char *name;
@@ -51,6 +52,8 @@ struct device_node {
 	struct device_node *parent;
 	struct device_node *child;
 	struct device_node *sibling;
+	const u16 *prop_order;
+	int prop_count;
 };
 
 #define OF_MAX_PHANDLE_ARGS 16
@@ -249,6 +249,48 @@ struct device_node *of_find_node_by_prop_value(struct device_node *from,
 					       const char *propname,
 					       const void *propval,
 					       int proplen);
+/**
+ * of_build_phandle_table() - Build the phandle lookup table for a live tree
+ *
+ * This indexes every node below @root by its phandle so that
+ * of_find_node_by_phandle() does not have to walk the whole tree. It is
+ * called once after the tree is unflattened. If no table is built, lookups
+ * fall back to walking the tree.
+ *
+ * @root:	root node of the live tree
+ * @return 0 if OK (or if the tree has no phandles), -E2BIG if the phandles
+ *	are too sparse to index, -ENOMEM if out of memory
+ */
+int of_build_phandle_table(struct device_node *root);
+
+/**
+ * of_name_table_init() - Set up the table of interned property names
+ *
+ * Property names of the live tree are interned so that of_find_property()
+ * can compare pointers instead of strings. The table is owned by the caller
+ * and normally lives in the live tree's own memory.
+ *
+ * @table:	Zeroed storage for @size name pointers
+ * @size:	Number of slots, a power of two larger than the number of names
+ */
+void of_name_table_init(const char **table, uint size);
+
+/**
+ * of_name_intern() - Get the interned copy of a property name
+ *
+ * @name:	Property name, kept by reference if it is new to the table
+ * @return interned name, or NULL if the table is full or not set up
+ */
+const char *of_name_intern(const char *name);
+
+/**
+ * of_name_find() - Look up an interned property name
+ *
+ * @name:	Property name to look up
+ * @return interned name, or NULL if no node of the live tree uses it
+ */
+const char *of_name_find(const char *name);
+
 /**
  * of_find_node_by_phandle() - Find a node given a phandle
  *
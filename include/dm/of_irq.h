@@ -1,6 +1,8 @@
 #ifndef DM_OF_IRQ_H_
 #define DM_OF_IRQ_H_
 
+#include <stdint.h>
+
 #include <linker_lists.h>
 
 #ifdef __cplusplus
@@ -26,6 +28,22 @@ struct of_irq_ops {
 #define OF_IRQ_END()  \
 	__ll_end(const struct of_irq_ops, ro)
 
+/**
+ * of_irq_translate_cells() - Translate an "interrupts" specifier
+ *
+ * of-platdata keeps the cells of the "interrupts" property but not the
+ * interrupt parent, so the first controller registered with OF_IRQ()
+ * translates them.
+ *
+ * @cells: Specifier cells, in CPU order
+ * @count: Number of cells
+ * @irq: Returns the interrupt number
+ * @type: Returns the trigger type
+ * @return 0 if OK, -ve on error
+ */
+int of_irq_translate_cells(const uint32_t *cells, int count,
+			   unsigned int *irq, unsigned int *type);
+
 
 
 #ifdef __cplusplus
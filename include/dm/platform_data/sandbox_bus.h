@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Platform data for the sandbox I2C, SPI and GPIO controllers
+ *
+ * These controllers emulate their peripherals in memory, so that the cost
+ * of the driver model stack can be measured without any hardware ('dm -b').
+ * With CONFIG_SANDBOX_BUS one instance of each is bound from platform data,
+ * using the defaults below. More can be added with device tree nodes using
+ * the "sandbox,i2c", "sandbox,spi" and "sandbox,gpio" compatible strings.
+ */
+
+#ifndef __SANDBOX_BUS_H
+#define __SANDBOX_BUS_H
+
+#define SANDBOX_I2C_EEPROM_ADDR		0x50
+#define SANDBOX_I2C_EEPROM_SIZE		256
+#define SANDBOX_SPI_FLASH_SIZE		(64 * 1024)
+#define SANDBOX_GPIO_COUNT		32
+
+/**
+ * struct sandbox_i2c_plat - Sandbox I2C controller
+ *
+ * @eeprom_addr: Chip address of the emulated 24Cxx EEPROM
+ * @eeprom_size: Size of the EEPROM in bytes
+ * @offset_len: Number of address bytes sent before the data (1 or 2)
+ */
+struct sandbox_i2c_plat {
+	uint eeprom_addr;
+	uint eeprom_size;
+	uint offset_len;
+};
+
+/**
+ * struct sandbox_spi_plat - Sandbox SPI controller
+ *
+ * @flash_size: Size in bytes of the emulated SPI-NOR on chip select 0
+ * @jedec_id: JEDEC manufacturer and device ID returned by RDID (9Fh)
+ */
+struct sandbox_spi_plat {
+	uint flash_size;
+	u32 jedec_id;
+};
+
+/**
+ * struct sandbox_gpio_plat - Sandbox GPIO bank
+ *
+ * @bank_name: Name of the bank, used as prefix for GPIO names
+ * @gpio_count: Number of GPIOs, at most 32
+ */
+struct sandbox_gpio_plat {
+	const char *bank_name;
+	uint gpio_count;
+};
+
+#endif /* __SANDBOX_BUS_H */
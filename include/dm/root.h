@@ -128,4 +128,20 @@ int dm_uninit(void);
 int dm_remove_devices_flags(uint flags);
 
 
+/**
+ * dm_probe_devices() - Probe all bound devices in dependency order
+ *
+ * This probes every device below @root once its parent and the suppliers it
+ * references by phandle (clocks, resets, pinctrl, GPIOs, interrupt parent)
+ * have been probed. With CONFIG_DM_PROBE_PARALLEL on an SMP system,
+ * independent devices are probed concurrently by a pool of worker tasks.
+ * Probe failures are recorded but do not stop the other devices.
+ *
+ * The time taken by each probe can be shown with dm_dump_probe_stats().
+ *
+ * @root: Device whose descendants should be probed
+ * @return 0
+ */
+int dm_probe_devices(struct udevice *root);
+
 #endif
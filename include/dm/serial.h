@@ -8,6 +8,20 @@
 extern "C"{
 #endif
 
+/**
+ * struct serial_fifo_cfg - FIFO thresholds read from the device tree
+ *
+ * A value of 0 leaves the driver default in place.
+ *
+ * @rx_trigger: "rx-fifo-trigger", RX level raising the receive interrupt
+ * @rx_timeout: "rx-timeout", idle time in bit periods after which the
+ *              bytes left below @rx_trigger are flushed
+ */
+struct serial_fifo_cfg {
+	uint32_t rx_trigger;
+	uint32_t rx_timeout;
+};
+
 /**
  * struct struct dm_serial_ops - Driver model serial operations
  *
@@ -37,6 +51,53 @@ struct dm_serial_ops {
 int serial_class_enqueue(struct udevice *dev, const char *buf, int len);
 int serial_class_dequeue(struct udevice *dev);
 
+/* FIFO thresholds of @dev, valid from the driver's open() on */
+const struct serial_fifo_cfg *serial_class_fifo_cfg(struct udevice *dev);
+
+/*
+ * Raw channel
+ *
+ * A port opened with serial_raw_open() bypasses termios: the ISR puts the
+ * received bytes straight into a lock-free ring and transmits straight out
+ * of another one, with no line discipline or per-byte copy through the tty
+ * layer. The port cannot be opened through /dev/ttySx at the same time and
+ * the console port cannot be used. Ring sizes must be powers of two.
+ */
+#define SERIAL_RAW_FOREVER ((rtems_interval)-1)
+
+int serial_raw_open(struct udevice *dev, size_t rx_size, size_t tx_size,
+    const struct termios *tm);
+
+/*
+ * Tasks blocked in serial_raw_read() or serial_raw_write() are woken and
+ * return -EBADF (a writer returns what it queued, if anything).
+ */
+int serial_raw_close(struct udevice *dev);
+
+/*
+ * Read up to @len bytes. With a @timeout (in ticks, or SERIAL_RAW_FOREVER)
+ * wait for at least one byte, returning -ETIMEDOUT if none came; with 0
+ * return what is there, possibly 0.
+ */
+ssize_t serial_raw_read(struct udevice *dev, void *buf, size_t len,
+    rtems_interval timeout);
+
+/*
+ * Queue up to @len bytes for sending, waiting up to @timeout ticks each
+ * time the ring is full. Returns the number of bytes queued.
+ */
+ssize_t serial_raw_write(struct udevice *dev, const void *buf, size_t len,
+    rtems_interval timeout);
+
+/*
+ * Wait up to @timeout ticks between transmit interrupts until everything
+ * queued has left the FIFO. Returns -ETIMEDOUT if it has not.
+ */
+int serial_raw_drain(struct udevice *dev, rtems_interval timeout);
+
+/* Bytes dropped because the receive ring was full */
+uint32_t serial_raw_overruns(struct udevice *dev);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Size-class allocator for driver model bookkeeping
+ *
+ * The priv, plat and devres objects of a device are small, numerous and
+ * share its lifetime. They are carved out of fixed-size pages, one set of
+ * pages per size class, so that binding and unbinding devices does not
+ * scatter small blocks over the system heap.
+ */
+
+#ifndef _DM_SLAB_H
+#define _DM_SLAB_H
+
+#include <stdlib.h>
+#include <rtems/malloc.h>
+
+/**
+ * struct dm_slab_stats - Driver model allocation statistics
+ *
+ * Sizes are rounded up to the size class which served the allocation.
+ *
+ * @objects: Number of objects currently allocated
+ * @bytes: Bytes currently allocated
+ * @bytes_peak: Largest value @bytes has reached
+ * @pages: Number of slab pages currently held
+ * @pages_peak: Largest value @pages has reached
+ * @large: Bytes currently allocated above the largest size class
+ * @large_peak: Largest value @large has reached
+ */
+struct dm_slab_stats {
+	unsigned long objects;
+	unsigned long bytes;
+	unsigned long bytes_peak;
+	unsigned long pages;
+	unsigned long pages_peak;
+	unsigned long large;
+	unsigned long large_peak;
+};
+
+#ifdef CONFIG_DM_SLAB
+
+/**
+ * dm_slab_alloc() - Allocate zeroed memory for driver model data
+ *
+ * @size: Number of bytes to allocate
+ * @return pointer to the memory, or NULL if out of memory
+ */
+void *dm_slab_alloc(size_t size);
+
+/**
+ * dm_slab_free() - Free memory allocated by dm_slab_alloc()
+ *
+ * Pages left empty are returned to the heap.
+ *
+ * @ptr: Memory to free, may be NULL
+ */
+void dm_slab_free(void *ptr);
+
+/**
+ * dm_slab_get_stats() - Get the allocation statistics
+ *
+ * @stats: Filled in with the current statistics
+ */
+void dm_slab_get_stats(struct dm_slab_stats *stats);
+
+/* Dump out the usage of each size class */
+void dm_dump_slab(void);
+
+#else /* !CONFIG_DM_SLAB */
+
+static inline void *dm_slab_alloc(size_t size)
+{
+	return rtems_calloc(1, size);
+}
+
+static inline void dm_slab_free(void *ptr)
+{
+	free(ptr);
+}
+
+static inline void dm_slab_get_stats(struct dm_slab_stats *stats)
+{
+	*stats = (struct dm_slab_stats){0};
+}
+
+static inline void dm_dump_slab(void)
+{
+}
+
+#endif /* CONFIG_DM_SLAB */
+#endif /* _DM_SLAB_H */
@@ -294,6 +294,14 @@ int uclass_pre_remove_device(struct udevice *dev);
  */
 struct uclass *uclass_find(enum uclass_id key);
 
+/**
+ * uclass_index_reset() - Forget all uclasses found by uclass_find()
+ *
+ * This must be called when the list of uclasses is emptied without
+ * destroying them, as dm_init() does.
+ */
+void uclass_index_reset(void);
+
 /**
  * uclass_destroy() - Destroy a uclass
  *
@@ -30,12 +30,22 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @devs: Devices in @dev_head order, for lookups by index
+ * @dev_count: Number of devices in @devs
+ * @devs_size: Number of entries allocated in @devs
+ * @seq_devs: Devices indexed by sequence number, NULL for unused numbers
+ * @seq_size: Number of entries allocated in @seq_devs
  */
 struct uclass {
 	void *priv_;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+	struct udevice **devs;
+	int dev_count;
+	int devs_size;
+	struct udevice **seq_devs;
+	int seq_size;
 };
 
 struct driver;
@@ -47,6 +57,9 @@ struct udevice;
 /* Members of this uclass without aliases don't get a sequence number */
 #define DM_UC_FLAG_NO_AUTO_SEQ			(1 << 1)
 
+/* Members of this uclass are probed on first use (see DM_FLAG_PROBE_LAZY) */
+#define DM_UC_FLAG_PROBE_LAZY			(1 << 2)
+
 /* Same as DM_FLAG_ALLOC_PRIV_DMA */
 #define DM_UC_FLAG_ALLOC_PRIV_DMA		(1 << 5)
 
@@ -50,6 +50,19 @@ void dm_dump_driver_compat(void);
 /* Dump out a list of drivers with static platform data */
 void dm_dump_static_driver_info(void);
 
+/* Dump out the probe time of each device, slowest first */
+void dm_dump_probe_stats(void);
+
+/* Dump out the devices waiting for a deferred probe, and why */
+void dm_dump_deferred(void);
+
+/*
+ * Time @loops phandle, uclass and sequence number lookups and slab
+ * allocations, then transactions on each sandbox bus device
+ * (CONFIG_SANDBOX_BUS), and print the cost of each
+ */
+void dm_bench(unsigned int loops);
+
 #endif
 
 #if CONFIG_IS_ENABLED(OF_PLATDATA_INST) && CONFIG_IS_ENABLED(READ_ONLY)
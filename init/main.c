@@ -17,6 +17,7 @@
 #endif
 
 #include "base/modinit.h"
+#include "base/boottime.h"
 
 #define ROOTFS_DIR "root"
 #define MEDIA_MOUNTED_EVENT RTEMS_EVENT_10
@@ -87,11 +88,16 @@ rtems_task Init(rtems_task_argument arg) {
     rtems_id thread = rtems_task_self();
 #endif
     rtems_status_code sc;
+    boottime_t start;
+    start = boottime_begin();
     _module_driver_init();
+    boottime_end("module_driver", BOOTTIME_PHASE, start);
 #if defined(CONFIGURE_MEDIA_SERVICE)
+    start = boottime_begin();
     if (media_service_init()) 
         rtems_panic("Media initialize failed\n");
     rtems_media_listener_add(media_listener, &thread);
+    boottime_end("media", BOOTTIME_PHASE, start);
 #endif
 #if defined (__rtems_libbsd__)
    /* 
@@ -102,8 +108,11 @@ rtems_task Init(rtems_task_argument arg) {
 	rtems_bsd_setlogpriority(CONFIG_LOG_LEVEL);
     rtems_task_set_priority(RTEMS_SELF, 110, &old_prio);
     (void)old_prio;
+    start = boottime_begin();
     sc = rtems_bsd_initialize();
+    boottime_end("libbsd", BOOTTIME_PHASE, start);
     if (sc == RTEMS_SUCCESSFUL) {
+        start = boottime_begin();
 #if defined(CONFIGURE_MEDIA_SERVICE)
         rtems_event_set evt;
         rtems_event_receive(MEDIA_MOUNTED_EVENT, 
@@ -111,23 +120,31 @@ rtems_task Init(rtems_task_argument arg) {
             RTEMS_MILLISECONDS_TO_TICKS(3000),
             &evt);
         (void) evt;  
+        boottime_end("media-mount", BOOTTIME_PHASE, start);
 #else
         rtems_task_wake_after(RTEMS_MILLISECONDS_TO_TICKS(1000));
+        boottime_end("libbsd-settle", BOOTTIME_PHASE, start);
 #endif
         /* Execute /etc/rc.conf script */
+        start = boottime_begin();
         rtems_bsd_run_etc_rc_conf(RTEMS_MILLISECONDS_TO_TICKS(10000), true);
+        boottime_end("rc.conf", BOOTTIME_PHASE, start);
     }
 
 #elif defined(CONFIG_NET)
     extern int _net_init(void);
     /* Initialize rtems local network services*/
+    start = boottime_begin();
     int ret = _net_init();
+    boottime_end("network", BOOTTIME_PHASE, start);
     if (ret)
         printf("%s: Initialize network failed\n", __func__);
 #else
     (void) sc;
 #endif
+    start = boottime_begin();
     _module_init();
+    boottime_end("module_init", BOOTTIME_PHASE, start);
     rtems_task_exit();
     /* Never reached here !!*/
 }
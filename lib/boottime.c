@@ -0,0 +1,296 @@
+/*
+ * Boot time profiler
+ *
+ * Spans of the boot (sysinit stages, module initializers, driver model bind
+ * and probe, the init task phases) are recorded with the CPU counter into a
+ * static ring. The counter is extended to a running 64-bit count on every
+ * read. Once the clock driver runs, the uptime elapsed since the previous
+ * read tells how many times the counter wrapped in between, so records made
+ * long after boot are still placed correctly. A single span must stay below
+ * one counter wrap.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtems.h>
+#include <rtems/sysinit.h>
+
+#include "base/boottime.h"
+
+#ifndef CONFIG_BOOTTIME_ENTRIES
+#define CONFIG_BOOTTIME_ENTRIES 256
+#endif
+
+#define BOOTTIME_MAX_DEPTH 16
+#define BOOTTIME_BAR_WIDTH 20
+#define BOOTTIME_NAME_LEN  32
+
+struct boottime_event {
+    char name[BOOTTIME_NAME_LEN];
+    uint64_t begin;
+    uint32_t duration;
+    uint8_t kind;
+    uint8_t cpu;
+};
+
+static const char *const boottime_kinds[BOOTTIME_KINDS] = {
+    [BOOTTIME_SYSINIT] = "sysinit",
+    [BOOTTIME_MODULE]  = "module",
+    [BOOTTIME_BIND]    = "bind",
+    [BOOTTIME_PROBE]   = "probe",
+    [BOOTTIME_PHASE]   = "phase"
+};
+
+static struct boottime_event boottime_ring[CONFIG_BOOTTIME_ENTRIES];
+static unsigned int boottime_head;
+static unsigned int boottime_count;
+static unsigned int boottime_dropped;
+static uint64_t boottime_base;
+static uint64_t boottime_last_ns;
+static rtems_counter_ticks boottime_last;
+static boottime_t boottime_stage_begin;
+static const char *boottime_stage;
+RTEMS_INTERRUPT_LOCK_DEFINE(static, boottime_lock, "boottime")
+
+static uint64_t boottime_ns_to_ticks(uint64_t ns) {
+    uint64_t freq = rtems_counter_frequency();
+
+    return ns / 1000000000 * freq + ns % 1000000000 * freq / 1000000000;
+}
+
+/*
+ * Advance the running count to @now. The counter difference is only known
+ * modulo one wrap; the uptime adds the whole wraps it hides. Before the
+ * clock driver runs the uptime does not move and reads are frequent.
+ *
+ * Must be called with boottime_lock held.
+ */
+static uint64_t boottime_now(rtems_counter_ticks now) {
+    uint64_t ns = rtems_clock_get_uptime_nanoseconds();
+    uint64_t delta = rtems_counter_difference(now, boottime_last);
+    uint64_t wrap = (uint64_t)(rtems_counter_ticks)~0 + 1;
+    uint64_t expect = 0;
+
+    if (ns > boottime_last_ns)
+        expect = boottime_ns_to_ticks(ns - boottime_last_ns);
+    if (wrap != 0 && expect > delta + wrap / 2)
+        delta += (expect - delta + wrap / 2) / wrap * wrap;
+    boottime_base += delta;
+    boottime_last = now;
+    boottime_last_ns = ns;
+    return boottime_base;
+}
+
+void boottime_end(const char *name, int kind, boottime_t begin) {
+    rtems_interrupt_lock_context ctx;
+    struct boottime_event *ev;
+    rtems_counter_ticks now;
+    uint32_t duration;
+
+    now = rtems_counter_read();
+    duration = rtems_counter_difference(now, begin);
+
+    rtems_interrupt_lock_acquire(&boottime_lock, &ctx);
+    ev = &boottime_ring[boottime_head];
+    strlcpy(ev->name, name, sizeof(ev->name));
+    ev->begin = boottime_now(now) - duration;
+    ev->duration = duration;
+    ev->kind = kind;
+    ev->cpu = rtems_scheduler_get_processor();
+    boottime_head = (boottime_head + 1) % CONFIG_BOOTTIME_ENTRIES;
+    if (boottime_count < CONFIG_BOOTTIME_ENTRIES)
+        boottime_count++;
+    else
+        boottime_dropped++;
+    rtems_interrupt_lock_release(&boottime_lock, &ctx);
+}
+
+/*
+ * Sysinit handlers cannot be wrapped individually, so each marker closes
+ * the span of the stages run since the previous marker.
+ */
+static void boottime_sysinit_mark(const char *next_stage) {
+    boottime_t now = rtems_counter_read();
+
+    if (boottime_stage != NULL)
+        boottime_end(boottime_stage, BOOTTIME_SYSINIT, boottime_stage_begin);
+    boottime_stage = next_stage;
+    boottime_stage_begin = now;
+}
+
+#define BOOTTIME_SYSINIT_MARK(_stage, _order, _next) \
+    static void boottime_mark_##_stage(void) { \
+        boottime_sysinit_mark(_next); \
+    } \
+    RTEMS_SYSINIT_ITEM(boottime_mark_##_stage, \
+        RTEMS_SYSINIT_##_stage, \
+        RTEMS_SYSINIT_ORDER_##_order)
+
+/* The CPU counter is not usable before its own sysinit stage */
+BOOTTIME_SYSINIT_MARK(CPU_COUNTER, LAST, "sysinit:kernel");
+BOOTTIME_SYSINIT_MARK(BSP_PRE_DRIVERS, FIRST, "sysinit:bsp_pre_drivers");
+BOOTTIME_SYSINIT_MARK(DEVICE_DRIVERS, FIRST, "sysinit:device_drivers");
+BOOTTIME_SYSINIT_MARK(STD_FILE_DESCRIPTORS, FIRST, "sysinit:late");
+BOOTTIME_SYSINIT_MARK(LAST, LAST, NULL);
+
+static uint64_t boottime_to_ns(uint64_t ticks) {
+    uint64_t freq = rtems_counter_frequency();
+
+    return ticks / freq * 1000000000 + ticks % freq * 1000000000 / freq;
+}
+
+static unsigned long boottime_to_us(uint64_t ticks) {
+    return (unsigned long)(boottime_to_ns(ticks) / 1000);
+}
+
+/* Copy the ring out, oldest record first */
+static struct boottime_event *boottime_snapshot(unsigned int *countp) {
+    rtems_interrupt_lock_context ctx;
+    struct boottime_event *evs;
+    unsigned int count, first, i;
+
+    evs = malloc(sizeof(*evs) * CONFIG_BOOTTIME_ENTRIES);
+    if (evs == NULL)
+        return NULL;
+
+    rtems_interrupt_lock_acquire(&boottime_lock, &ctx);
+    count = boottime_count;
+    first = (boottime_head + CONFIG_BOOTTIME_ENTRIES - count) %
+        CONFIG_BOOTTIME_ENTRIES;
+    for (i = 0; i < count; i++)
+        evs[i] = boottime_ring[(first + i) % CONFIG_BOOTTIME_ENTRIES];
+    rtems_interrupt_lock_release(&boottime_lock, &ctx);
+
+    *countp = count;
+    return evs;
+}
+
+/* Earlier start first; an enclosing span before the spans it contains */
+static int boottime_cmp_begin(const void *a, const void *b) {
+    const struct boottime_event *ea = a, *eb = b;
+
+    if (ea->begin != eb->begin)
+        return ea->begin < eb->begin ? -1 : 1;
+    return ea->duration > eb->duration ? -1 : ea->duration < eb->duration;
+}
+
+static int boottime_cmp_duration(const void *a, const void *b) {
+    const struct boottime_event *ea = a, *eb = b;
+
+    return ea->duration > eb->duration ? -1 : ea->duration < eb->duration;
+}
+
+static void boottime_bar(uint64_t part, uint64_t total) {
+    char bar[BOOTTIME_BAR_WIDTH + 1];
+    int n = 0;
+
+    if (total)
+        n = (int)(part * BOOTTIME_BAR_WIDTH / total);
+    memset(bar, '#', n);
+    bar[n] = '\0';
+    printf("%-*s", BOOTTIME_BAR_WIDTH, bar);
+}
+
+static void boottime_print(const struct boottime_event *ev, uint64_t first,
+    uint64_t total, int depth) {
+    printf("%11lu %9lu  ", boottime_to_us(ev->begin - first),
+        boottime_to_us(ev->duration));
+    boottime_bar(ev->duration, total);
+    printf("  %-7s  %*s%s\n", boottime_kinds[ev->kind], 2 * depth, "",
+        ev->name);
+}
+
+void boottime_dump(bool by_duration, unsigned long min_us) {
+    struct {
+        uint64_t end;
+        uint8_t kind;
+    } stack[BOOTTIME_MAX_DEPTH];
+    uint64_t kinds[BOOTTIME_KINDS] = {0};
+    struct boottime_event *evs;
+    uint64_t first, last;
+    unsigned int count, i;
+    int depth = 0, d;
+
+    evs = boottime_snapshot(&count);
+    if (evs == NULL) {
+        printf("boottime: out of memory\n");
+        return;
+    }
+    if (count == 0) {
+        printf("boottime: no events recorded\n");
+        free(evs);
+        return;
+    }
+
+    qsort(evs, count, sizeof(*evs), boottime_cmp_begin);
+    first = evs[0].begin;
+    last = 0;
+    for (i = 0; i < count; i++) {
+        if (evs[i].begin + evs[i].duration > last)
+            last = evs[i].begin + evs[i].duration;
+    }
+
+    printf("  Start(us)  Time(us)  %-*s  Kind     Name\n",
+        BOOTTIME_BAR_WIDTH, "Share");
+    printf("---------------------------------------------------------------------\n");
+    for (i = 0; i < count; i++) {
+        struct boottime_event *ev = &evs[i];
+
+        while (depth > 0 && stack[depth - 1].end <= ev->begin)
+            depth--;
+
+        /* A span inside one of its own kind (a parent probe) counts once */
+        for (d = 0; d < depth; d++) {
+            if (stack[d].kind == ev->kind)
+                break;
+        }
+        if (d == depth)
+            kinds[ev->kind] += ev->duration;
+
+        if (!by_duration && boottime_to_us(ev->duration) >= min_us)
+            boottime_print(ev, first, last - first, depth);
+
+        if (depth < BOOTTIME_MAX_DEPTH) {
+            stack[depth].end = ev->begin + ev->duration;
+            stack[depth].kind = ev->kind;
+            depth++;
+        }
+    }
+
+    if (by_duration) {
+        qsort(evs, count, sizeof(*evs), boottime_cmp_duration);
+        for (i = 0; i < count; i++) {
+            if (boottime_to_us(evs[i].duration) >= min_us)
+                boottime_print(&evs[i], first, last - first, 0);
+        }
+    }
+
+    printf("\nTotal %lu us over %u events", boottime_to_us(last - first),
+        count);
+    if (boottime_dropped)
+        printf(" (%u older events dropped)", boottime_dropped);
+    printf("\n");
+    for (i = 0; i < BOOTTIME_KINDS; i++)
+        printf("  %-7s %9lu us\n", boottime_kinds[i], boottime_to_us(kinds[i]));
+    free(evs);
+}
+
+void boottime_export(FILE *fp) {
+    struct boottime_event *evs;
+    unsigned int count, i;
+
+    evs = boottime_snapshot(&count);
+    if (evs == NULL)
+        return;
+
+    fprintf(fp, "# boottime 1\n");
+    for (i = 0; i < count; i++) {
+        fprintf(fp, "%s %u %llu %llu %s\n", boottime_kinds[evs[i].kind],
+            evs[i].cpu,
+            (unsigned long long)boottime_to_ns(evs[i].begin),
+            (unsigned long long)boottime_to_ns(evs[i].duration),
+            evs[i].name);
+    }
+    fprintf(fp, "# end\n");
+    free(evs);
+}
@@ -1316,6 +1316,10 @@ static void fdtdec_setup(void)
 		ret = fdtdec_board_setup(_dm_fdt_blob);
 		if (ret)
 			rtems_panic("FDT board setup failed\n");
+
+		/* Devices are bound from build-time tables, skip the live tree */
+		if (CONFIG_IS_ENABLED(OF_PLATDATA))
+			return;
 		ret = of_live_build(dm_fdt_blob(),
 				(struct device_node **)&_of_root);
 		if (ret)
@@ -209,9 +209,6 @@ GX_WINDOW_ROOT *root;
         {
             canvas = root -> gx_window_root_canvas;
 
-            /* reset the canvas dirty counter */
-            canvas -> gx_canvas_dirty_count = 0;
-
             if (root -> gx_widget_status & GX_STATUS_VISIBLE)
             {
                 if (canvas -> gx_canvas_draw_count > 0)
@@ -224,7 +221,9 @@ GX_WINDOW_ROOT *root;
                     }
                 }
             }
-            /* reset the canvas draw counter */
+            /* reset the canvas dirty and draw counters, after the toggle
+               so that the driver can flush the individual dirty areas */
+            canvas -> gx_canvas_dirty_count = 0;
             canvas -> gx_canvas_draw_count = 0;
             root = (GX_WINDOW_ROOT *)root -> gx_widget_next;
         }
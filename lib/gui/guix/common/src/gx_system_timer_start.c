@@ -89,6 +89,12 @@ UINT tx_timer_active;
     /* lock entering critical section */
     GX_ENTER_CRITICAL
 
+#ifndef GX_THREADX_BINDING
+    /* start the low-level timer before loading the timer, so that a
+       tickless port can bring the other active timers up to date first */
+    GX_TIMER_START;
+#endif
+
     /* check for already having this timer */
     found = _gx_system_active_timer_list;
 
@@ -138,8 +144,6 @@ UINT tx_timer_active;
     {
         tx_timer_activate(&_gx_system_timer);
     }
-#else
-    GX_TIMER_START;
 #endif
 
     /* release our lock */
@@ -0,0 +1,667 @@
+/*
+ * Frame presentation for the GUIX RTEMS port
+ *
+ * The display buffer toggle is replaced by guix_flush_toggle(), which
+ * turns the canvas dirty list into a few panel-aligned windows and queues
+ * the frame for a presenter thread. Overlapping windows are merged; once
+ * GX_FLUSH_WINDOWS are in use, each further area is merged into the
+ * window it grows the least.
+ *
+ * The presenter waits for the next vsync/TE edge if the driver delivers
+ * them through guix_vsync_notify(), then either hands the whole buffer to
+ * drv->present() (scanout panels) or sends the windows one by one through
+ * drv->flush_window() (panels with their own GRAM).
+ *
+ * GUIX renders into the canvas memory, which rotates through up to
+ * GUIX_FLUSH_BUFFERS buffers. Each buffer remembers the windows drawn
+ * since it was last current, and only those are copied into it before
+ * GUIX draws there again. A frame still waiting for vsync when the next
+ * one is rendered is not shown: its windows are merged into the newer
+ * frame and its buffer is reused.
+ */
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rtems.h>
+#include <rtems/counter.h>
+#include <rtems/thread.h>
+
+#include "gx_api.h"
+
+#include "base/observer.h"
+
+/* Give up on a window, a present or a vsync the driver never completes */
+#define GUIX_FLUSH_TIMEOUT_MS 1000
+
+/* Vsync observers called per edge, the presenters of all displays */
+#define GUIX_VSYNC_OBSERVERS  4
+
+/* The canvas memory and up to two spare buffers */
+#define GUIX_FLUSH_BUFFERS    3
+#define GUIX_FLUSH_NONE       (-1)
+
+#define FLUSH_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define FLUSH_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+struct guix_frame {
+    UINT count;
+    struct guix_window windows[GX_FLUSH_WINDOWS];
+};
+
+struct guix_flush {
+    struct guix_flush *next;
+    struct guix_driver *drv;
+    GX_DISPLAY *display;
+    VOID (*drawing_initiate)(GX_DISPLAY *display, GX_CANVAS *canvas);
+    struct observer_base vsync_observer;
+    GX_UBYTE *buffers[GUIX_FLUSH_BUFFERS];
+    /* Windows each buffer is missing, GUIX thread only */
+    struct guix_frame stale[GUIX_FLUSH_BUFFERS];
+    int nbuffers;
+    int render;
+    /* Protected by lock */
+    int pending;
+    int presenting;
+    int shown;
+    struct guix_frame frame;
+    rtems_counter_ticks queued;
+    UINT pitch;
+    UINT bpp;
+    rtems_id thread;
+    rtems_mutex lock;
+    rtems_binary_semaphore start;
+    rtems_binary_semaphore done;
+    rtems_binary_semaphore vsync;
+    rtems_binary_semaphore release;
+    bool drawing;
+    rtems_counter_ticks drawing_start;
+    /* Protected by lock, except vsyncs which counts in the interrupt */
+    rtems_counter_ticks stats_start;
+    struct guix_flush_stats stats;
+    atomic_uint vsyncs;
+};
+
+static struct guix_flush *guix_flush_list;
+
+static struct observer_base *guix_vsync_list;
+static int guix_vsync_count;
+/* Notifications running outside guix_vsync_lock */
+static atomic_uint guix_vsync_busy;
+RTEMS_INTERRUPT_LOCK_DEFINE(static, guix_vsync_lock, "guix_vsync")
+
+static inline uint32_t guix_window_area(const struct guix_window *win)
+{
+    return (uint32_t)(win->right - win->left + 1) *
+        (uint32_t)(win->bottom - win->top + 1);
+}
+
+static inline bool guix_window_overlap(const struct guix_window *a,
+    const struct guix_window *b)
+{
+    return a->left <= b->right && b->left <= a->right &&
+        a->top <= b->bottom && b->top <= a->bottom;
+}
+
+static inline void guix_window_combine(struct guix_window *a,
+    const struct guix_window *b)
+{
+    a->left = FLUSH_MIN(a->left, b->left);
+    a->top = FLUSH_MIN(a->top, b->top);
+    a->right = FLUSH_MAX(a->right, b->right);
+    a->bottom = FLUSH_MAX(a->bottom, b->bottom);
+}
+
+static UINT guix_flush_add(struct guix_window *win, UINT count,
+    struct guix_window *rect)
+{
+    struct guix_window merged;
+    uint32_t growth, least = UINT32_MAX;
+    UINT i, best = 0;
+
+    for (i = 0; i < count; i++) {
+        if (guix_window_overlap(&win[i], rect))
+            break;
+    }
+
+    if (i == count) {
+        if (count < GX_FLUSH_WINDOWS) {
+            win[count] = *rect;
+            return count + 1;
+        }
+        for (i = 0; i < count; i++) {
+            merged = win[i];
+            guix_window_combine(&merged, rect);
+            growth = guix_window_area(&merged) - guix_window_area(&win[i]);
+            if (growth < least) {
+                least = growth;
+                best = i;
+            }
+        }
+        i = best;
+    }
+
+    /* The union may now overlap other windows, so add it again */
+    guix_window_combine(rect, &win[i]);
+    win[i] = win[--count];
+    return guix_flush_add(win, count, rect);
+}
+
+static void guix_frame_merge(struct guix_frame *to,
+    const struct guix_frame *from)
+{
+    struct guix_window win;
+    UINT i;
+
+    for (i = 0; i < from->count; i++) {
+        win = from->windows[i];
+        to->count = guix_flush_add(to->windows, to->count, &win);
+    }
+}
+
+static bool guix_flush_clip(struct guix_flush *fl, GX_CANVAS *canvas,
+    const GX_RECTANGLE *area, struct guix_window *win)
+{
+    INT align = fl->drv->flush_align ? (INT)fl->drv->flush_align : 1;
+    INT left = FLUSH_MAX(area->gx_rectangle_left, 0);
+    INT top = FLUSH_MAX(area->gx_rectangle_top, 0);
+    INT right = FLUSH_MIN(area->gx_rectangle_right, canvas->gx_canvas_x_resolution - 1);
+    INT bottom = FLUSH_MIN(area->gx_rectangle_bottom, canvas->gx_canvas_y_resolution - 1);
+
+    if (left > right || top > bottom)
+        return false;
+
+    win->left = (GX_VALUE)(left & ~(align - 1));
+    win->top = (GX_VALUE)(top & ~(align - 1));
+    win->right = (GX_VALUE)FLUSH_MIN(right | (align - 1),
+        canvas->gx_canvas_x_resolution - 1);
+    win->bottom = (GX_VALUE)FLUSH_MIN(bottom | (align - 1),
+        canvas->gx_canvas_y_resolution - 1);
+    return true;
+}
+
+static void guix_flush_collect(struct guix_flush *fl, GX_CANVAS *canvas,
+    GX_RECTANGLE *dirty, struct guix_frame *frame)
+{
+    struct guix_window win;
+    GX_DIRTY_AREA *area = canvas->gx_canvas_dirty_list;
+    UINT i;
+
+    frame->count = 0;
+    for (i = 0; i < canvas->gx_canvas_dirty_count; i++, area++) {
+        if (area->gx_dirty_area_widget &&
+            guix_flush_clip(fl, canvas, &area->gx_dirty_area_rectangle, &win))
+            frame->count = guix_flush_add(frame->windows, frame->count, &win);
+    }
+
+    /* Composite canvases only carry the combined area */
+    if (frame->count == 0 && guix_flush_clip(fl, canvas, dirty, &win))
+        frame->count = guix_flush_add(frame->windows, frame->count, &win);
+}
+
+static void guix_flush_copy(struct guix_flush *fl,
+    const struct guix_frame *frame, const GX_UBYTE *from, GX_UBYTE *to)
+{
+    const struct guix_window *win;
+    size_t offset, len;
+    INT row;
+    UINT i;
+
+    for (i = 0; i < frame->count; i++) {
+        win = &frame->windows[i];
+        len = (size_t)(win->right - win->left + 1) * fl->bpp;
+        offset = (size_t)win->top * fl->pitch + (size_t)win->left * fl->bpp;
+        for (row = win->top; row <= win->bottom; row++) {
+            memcpy(to + offset, from + offset, len);
+            offset += fl->pitch;
+        }
+    }
+}
+
+static inline uint64_t guix_flush_ns(rtems_counter_ticks begin)
+{
+    return rtems_counter_ticks_to_nanoseconds(
+        rtems_counter_difference(rtems_counter_read(), begin));
+}
+
+static bool guix_flush_wait(struct guix_flush *fl,
+    rtems_binary_semaphore *sem, uint32_t timeout)
+{
+    if (rtems_binary_semaphore_wait_timed_ticks(sem, timeout)) {
+        rtems_mutex_lock(&fl->lock);
+        fl->stats.timeouts++;
+        rtems_mutex_unlock(&fl->lock);
+        return false;
+    }
+    return true;
+}
+
+static rtems_task guix_flush_thread(rtems_task_argument arg)
+{
+    struct guix_flush *fl = (struct guix_flush *)arg;
+    struct guix_driver *drv = fl->drv;
+    const struct guix_window *win;
+    struct guix_frame frame;
+    rtems_counter_ticks queued;
+    const GX_UBYTE *pixels;
+    uint32_t timeout;
+    uint64_t ns;
+    int index;
+    UINT i;
+
+    timeout = GUIX_FLUSH_TIMEOUT_MS * 1000 /
+        rtems_configuration_get_microseconds_per_tick();
+
+    while (true) {
+        rtems_binary_semaphore_wait(&fl->start);
+
+        /* Start on the next edge, not one that passed while idle */
+        if (drv->vsync) {
+            rtems_binary_semaphore_try_wait(&fl->vsync);
+            guix_flush_wait(fl, &fl->vsync, timeout);
+        }
+
+        rtems_mutex_lock(&fl->lock);
+        index = fl->pending;
+        frame = fl->frame;
+        queued = fl->queued;
+        fl->pending = GUIX_FLUSH_NONE;
+        fl->presenting = index;
+        rtems_mutex_unlock(&fl->lock);
+
+        /* Already taken together with an earlier start */
+        if (index == GUIX_FLUSH_NONE)
+            continue;
+
+        pixels = fl->buffers[index];
+        /*
+         * A guix_flush_done() for a transfer that timed out may come in
+         * late; drop it before each transfer so it is not taken for the
+         * completion of the next one.
+         */
+        if (drv->present) {
+            rtems_binary_semaphore_try_wait(&fl->done);
+            if (!drv->present(drv, pixels))
+                guix_flush_wait(fl, &fl->done, timeout);
+        } else {
+            for (i = 0; i < frame.count; i++) {
+                win = &frame.windows[i];
+                rtems_binary_semaphore_try_wait(&fl->done);
+                if (drv->flush_window(drv, win, pixels +
+                    (size_t)win->top * fl->pitch + (size_t)win->left * fl->bpp,
+                    fl->pitch))
+                    continue;
+                guix_flush_wait(fl, &fl->done, timeout);
+            }
+        }
+
+        ns = guix_flush_ns(queued);
+
+        /*
+         * A scanned out buffer stays in use until the next one is live,
+         * one sent to the panel GRAM is free once the transfer is done.
+         */
+        rtems_mutex_lock(&fl->lock);
+        fl->stats.presented++;
+        fl->stats.latency_ns += ns;
+        if (ns > fl->stats.latency_max_ns)
+            fl->stats.latency_max_ns = ns;
+        fl->presenting = GUIX_FLUSH_NONE;
+        if (drv->present)
+            fl->shown = index;
+        rtems_mutex_unlock(&fl->lock);
+
+        rtems_binary_semaphore_post(&fl->release);
+    }
+}
+
+static struct guix_flush *guix_flush_find(GX_DISPLAY *display)
+{
+    struct guix_flush *fl = guix_flush_list;
+
+    while (fl && fl->display != display)
+        fl = fl->next;
+    return fl;
+}
+
+static VOID guix_flush_drawing_initiate(GX_DISPLAY *display, GX_CANVAS *canvas)
+{
+    struct guix_flush *fl = guix_flush_find(display);
+
+    if (!fl)
+        return;
+
+    if (!fl->drawing) {
+        fl->drawing = true;
+        fl->drawing_start = rtems_counter_read();
+    }
+    if (fl->drawing_initiate)
+        fl->drawing_initiate(display, canvas);
+}
+
+static int guix_flush_next(struct guix_flush *fl)
+{
+    int i;
+
+    rtems_mutex_lock(&fl->lock);
+    for (i = 0; i < fl->nbuffers; i++) {
+        if (i != fl->pending && i != fl->presenting && i != fl->shown)
+            break;
+    }
+    rtems_mutex_unlock(&fl->lock);
+
+    return i < fl->nbuffers ? i : GUIX_FLUSH_NONE;
+}
+
+static VOID guix_flush_toggle(GX_CANVAS *canvas, GX_RECTANGLE *dirty)
+{
+    struct guix_flush *fl = guix_flush_find(canvas->gx_canvas_display);
+    struct guix_frame frame;
+    uint64_t ns;
+    int rendered, next, i;
+
+    if (!fl)
+        return;
+
+    /* The canvas is created after the driver setup */
+    if (!fl->buffers[fl->render])
+        fl->buffers[fl->render] = (GX_UBYTE *)canvas->gx_canvas_memory;
+    fl->pitch = canvas->gx_canvas_x_resolution * fl->bpp;
+
+    ns = fl->drawing ? guix_flush_ns(fl->drawing_start) : 0;
+    fl->drawing = false;
+    guix_flush_collect(fl, canvas, dirty, &frame);
+    if (frame.count == 0)
+        return;
+
+    /* Every other buffer now lacks what was just drawn */
+    rendered = fl->render;
+    for (i = 0; i < fl->nbuffers; i++) {
+        if (i != rendered)
+            guix_frame_merge(&fl->stale[i], &frame);
+    }
+
+    rtems_mutex_lock(&fl->lock);
+    fl->stats.frames++;
+    fl->stats.render_ns += ns;
+    if (ns > fl->stats.render_max_ns)
+        fl->stats.render_max_ns = ns;
+    if (fl->pending != GUIX_FLUSH_NONE) {
+        /* Rendering is ahead of the panel, show this frame instead */
+        guix_frame_merge(&frame, &fl->frame);
+        fl->stats.merged++;
+    }
+    fl->pending = rendered;
+    fl->frame = frame;
+    fl->queued = rtems_counter_read();
+    rtems_mutex_unlock(&fl->lock);
+    rtems_binary_semaphore_post(&fl->start);
+
+    /* With a single buffer this waits for the transfer */
+    while ((next = guix_flush_next(fl)) == GUIX_FLUSH_NONE) {
+        rtems_mutex_lock(&fl->lock);
+        fl->stats.waits++;
+        rtems_mutex_unlock(&fl->lock);
+        rtems_binary_semaphore_wait(&fl->release);
+    }
+
+    if (next != rendered) {
+        guix_flush_copy(fl, &fl->stale[next], fl->buffers[rendered],
+            fl->buffers[next]);
+        canvas->gx_canvas_memory = (GX_COLOR *)fl->buffers[next];
+        fl->render = next;
+    }
+    fl->stale[next].count = 0;
+}
+
+static int guix_flush_vsync(struct observer_base *nb, unsigned long id,
+    void *data)
+{
+    struct guix_flush *fl = RTEMS_CONTAINER_OF(nb, struct guix_flush,
+        vsync_observer);
+
+    if (data == fl->drv) {
+        atomic_fetch_add_explicit(&fl->vsyncs, 1, memory_order_relaxed);
+        rtems_binary_semaphore_post(&fl->vsync);
+    }
+    return NOTIFY_DONE;
+}
+
+int guix_vsync_register(struct observer_base *observer)
+{
+    rtems_interrupt_lock_context lock_context;
+    struct observer_base *nb;
+    int ret = -ENOSPC;
+
+    rtems_interrupt_lock_acquire(&guix_vsync_lock, &lock_context);
+    for (nb = guix_vsync_list; nb && nb != observer; nb = nb->next)
+        ;
+    if (nb) {
+        ret = 0;
+    } else if (guix_vsync_count < GUIX_VSYNC_OBSERVERS) {
+        ret = observer_cond_register(&guix_vsync_list, observer);
+        guix_vsync_count++;
+    }
+    rtems_interrupt_lock_release(&guix_vsync_lock, &lock_context);
+    return ret;
+}
+
+/* Task context only: waits until no interrupt can still call @observer */
+int guix_vsync_unregister(struct observer_base *observer)
+{
+    rtems_interrupt_lock_context lock_context;
+    int ret;
+
+    rtems_interrupt_lock_acquire(&guix_vsync_lock, &lock_context);
+    ret = observer_unregister(&guix_vsync_list, observer);
+    if (!ret)
+        guix_vsync_count--;
+    rtems_interrupt_lock_release(&guix_vsync_lock, &lock_context);
+
+    while (atomic_load(&guix_vsync_busy))
+        rtems_task_wake_after(1);
+    return ret;
+}
+
+/*
+ * The observers are copied under the lock and called after it is
+ * released, so they may post semaphores or take their own locks.
+ */
+void guix_vsync_notify(struct guix_driver *drv)
+{
+    struct observer_base *observers[GUIX_VSYNC_OBSERVERS];
+    rtems_interrupt_lock_context lock_context;
+    struct observer_base *nb;
+    int i, n = 0;
+
+    rtems_interrupt_lock_acquire(&guix_vsync_lock, &lock_context);
+    for (nb = guix_vsync_list; nb && n < GUIX_VSYNC_OBSERVERS; nb = nb->next)
+        observers[n++] = nb;
+    atomic_fetch_add(&guix_vsync_busy, 1);
+    rtems_interrupt_lock_release(&guix_vsync_lock, &lock_context);
+
+    for (i = 0; i < n; i++) {
+        if ((observers[i]->update(observers[i], drv->id, drv) &
+            NOTIFY_STOP_MASK) == NOTIFY_STOP_MASK)
+            break;
+    }
+    atomic_fetch_sub(&guix_vsync_busy, 1);
+}
+
+static UINT guix_flush_bpp(GX_UBYTE format)
+{
+    switch (format) {
+    case GX_COLOR_FORMAT_8BIT_GRAY:
+    case GX_COLOR_FORMAT_8BIT_GRAY_INVERTED:
+    case GX_COLOR_FORMAT_8BIT_PALETTE:
+    case GX_COLOR_FORMAT_8BIT_PACKED_PIXEL:
+        return 1;
+    case GX_COLOR_FORMAT_5551BGRX:
+    case GX_COLOR_FORMAT_1555XRGB:
+    case GX_COLOR_FORMAT_565RGB:
+    case GX_COLOR_FORMAT_4444ARGB:
+    case GX_COLOR_FORMAT_4444BGRA:
+    case GX_COLOR_FORMAT_565BGR:
+        return 2;
+    case GX_COLOR_FORMAT_24XRGB:
+    case GX_COLOR_FORMAT_24BGRX:
+    case GX_COLOR_FORMAT_32ARGB:
+    case GX_COLOR_FORMAT_32RGBA:
+    case GX_COLOR_FORMAT_32ABGR:
+    case GX_COLOR_FORMAT_32BGRA:
+        return 4;
+    default:
+        /* Packed sub-byte and 24 bit formats are not supported */
+        return 0;
+    }
+}
+
+int guix_flush_attach(struct guix_driver *drv, GX_DISPLAY *display,
+    VOID **buffers, UINT count)
+{
+    struct guix_flush *fl;
+    rtems_status_code sc;
+    UINT bpp, i;
+    int ret;
+
+    if (!drv || !display || (!drv->flush_window && !drv->present))
+        return -EINVAL;
+    if (drv->flush_align & (drv->flush_align - 1))
+        return -EINVAL;
+    if (count >= GUIX_FLUSH_BUFFERS || (count && !buffers))
+        return -EINVAL;
+    /* Scanout needs somewhere to draw while a buffer is shown */
+    if (drv->present && count == 0)
+        return -EINVAL;
+    if (drv->flush)
+        return -EBUSY;
+
+    bpp = guix_flush_bpp(display->gx_display_color_format);
+    if (!bpp)
+        return -ENOTSUP;
+
+    fl = calloc(1, sizeof(*fl));
+    if (!fl)
+        return -ENOMEM;
+
+    fl->drv = drv;
+    fl->display = display;
+    fl->bpp = bpp;
+    fl->nbuffers = count + 1;
+    for (i = 0; i < count; i++)
+        fl->buffers[i + 1] = buffers[i];
+    fl->pending = GUIX_FLUSH_NONE;
+    fl->presenting = GUIX_FLUSH_NONE;
+    fl->shown = GUIX_FLUSH_NONE;
+    fl->stats_start = rtems_counter_read();
+    fl->vsync_observer.update = guix_flush_vsync;
+    rtems_mutex_init(&fl->lock, "guix_flush");
+    rtems_binary_semaphore_init(&fl->start, "guix_flush");
+    rtems_binary_semaphore_init(&fl->done, "guix_flush_done");
+    rtems_binary_semaphore_init(&fl->vsync, "guix_vsync");
+    rtems_binary_semaphore_init(&fl->release, "guix_flush_release");
+
+    if (drv->vsync) {
+        ret = guix_vsync_register(&fl->vsync_observer);
+        if (ret) {
+            free(fl);
+            return ret;
+        }
+    }
+
+    sc = rtems_task_create(rtems_build_name('g', 'x', 'f', 'l'),
+        GX_FLUSH_THREAD_PRIORITY, GX_FLUSH_THREAD_STACK_SIZE,
+        RTEMS_PREEMPT | RTEMS_NO_TIMESLICE,
+        RTEMS_NO_FLOATING_POINT | RTEMS_LOCAL, &fl->thread);
+    if (sc != RTEMS_SUCCESSFUL) {
+        printf("%s create guix flush thread failed(%s)\n", __func__,
+            rtems_status_text(sc));
+        ret = -rtems_status_code_to_errno(sc);
+        goto err;
+    }
+
+    sc = rtems_task_start(fl->thread, guix_flush_thread,
+        (rtems_task_argument)fl);
+    if (sc != RTEMS_SUCCESSFUL) {
+        printf("%s start guix flush thread failed(%s)\n", __func__,
+            rtems_status_text(sc));
+        rtems_task_delete(fl->thread);
+        ret = -rtems_status_code_to_errno(sc);
+        goto err;
+    }
+
+    drv->flush = fl;
+    fl->drawing_initiate = display->gx_display_driver_drawing_initiate;
+    display->gx_display_driver_drawing_initiate = guix_flush_drawing_initiate;
+    display->gx_display_driver_buffer_toggle = guix_flush_toggle;
+    fl->next = guix_flush_list;
+    guix_flush_list = fl;
+    return 0;
+
+err:
+    if (drv->vsync)
+        guix_vsync_unregister(&fl->vsync_observer);
+    free(fl);
+    return ret;
+}
+
+/* May be called from interrupt context */
+void guix_flush_done(struct guix_driver *drv)
+{
+    if (drv->flush)
+        rtems_binary_semaphore_post(&drv->flush->done);
+}
+
+int guix_flush_stats_get(UINT id, struct guix_flush_stats *stats, bool reset)
+{
+    struct guix_flush *fl = guix_flush_list;
+
+    while (fl && fl->drv->id != id)
+        fl = fl->next;
+    if (!fl)
+        return -ENODEV;
+
+    rtems_mutex_lock(&fl->lock);
+    *stats = fl->stats;
+    stats->elapsed_ns = guix_flush_ns(fl->stats_start);
+    if (reset) {
+        memset(&fl->stats, 0, sizeof(fl->stats));
+        fl->stats_start = rtems_counter_read();
+        stats->vsyncs = atomic_exchange(&fl->vsyncs, 0);
+    } else {
+        stats->vsyncs = atomic_load(&fl->vsyncs);
+    }
+    rtems_mutex_unlock(&fl->lock);
+    return 0;
+}
+
+void guix_flush_stats_dump(bool reset)
+{
+    struct guix_flush_stats st;
+    struct guix_flush *fl;
+    uint64_t fps_x10;
+
+    printf("%-4s %8s %8s %6s %6s %6s %7s %9s %9s %9s %9s\n",
+        "Id", "Frames", "Shown", "Merged", "Waits", "Tmo", "FPS",
+        "Rend(us)", "Max(us)", "Lat(us)", "Max(us)");
+    for (fl = guix_flush_list; fl; fl = fl->next) {
+        if (guix_flush_stats_get(fl->drv->id, &st, reset))
+            continue;
+        fps_x10 = st.elapsed_ns ?
+            (uint64_t)st.presented * 10000000000ULL / st.elapsed_ns : 0;
+        printf("%-4u %8lu %8lu %6lu %6lu %6lu %5llu.%llu %9llu %9llu %9llu %9llu\n",
+            fl->drv->id, (unsigned long)st.frames,
+            (unsigned long)st.presented, (unsigned long)st.merged,
+            (unsigned long)st.waits, (unsigned long)st.timeouts,
+            (unsigned long long)(fps_x10 / 10),
+            (unsigned long long)(fps_x10 % 10),
+            (unsigned long long)(st.frames ?
+                st.render_ns / st.frames / 1000 : 0),
+            (unsigned long long)(st.render_max_ns / 1000),
+            (unsigned long long)(st.presented ?
+                st.latency_ns / st.presented / 1000 : 0),
+            (unsigned long long)(st.latency_max_ns / 1000));
+    }
+}
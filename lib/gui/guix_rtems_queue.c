@@ -1,6 +1,8 @@
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <assert.h>
+#include <string.h>
+#include <errno.h>
 
 #include <rtems.h>
 #include <rtems/thread.h>
@@ -13,29 +15,69 @@
 
 #include "base/observer.h"
 
-/* GUIX system events */
-#define GUIX_TIMER_WAKEUP_EVENT RTEMS_EVENT_0
-#define GUIX_TIMER_DONE_EVENT   RTEMS_EVENT_1
+/* Longest single wait of the timer server, in GUIX ticks */
+#define GUIX_TIMER_MAX_TICKS    (60000 / GX_SYSTEM_TIMER_MS)
+
+/* Pen and key events go ahead of everything else */
+#define GUIX_LANE_INPUT         0
+#define GUIX_LANE_NORMAL        1
+#define GUIX_LANES              2
+
+/* (type, target) index of the queued events, at most half full */
+#define GUIX_FOLD_BITS          7
+#define GUIX_FOLD_SLOTS         (1 << GUIX_FOLD_BITS)
+#define GUIX_FOLD_NONE          -1
+
+_Static_assert(GUIX_FOLD_SLOTS >= 2 * GX_MAX_QUEUE_EVENTS,
+    "GUIX_FOLD_SLOTS too small for GX_MAX_QUEUE_EVENTS");
+_Static_assert((GX_ISR_QUEUE_EVENTS & (GX_ISR_QUEUE_EVENTS - 1)) == 0,
+    "GX_ISR_QUEUE_EVENTS must be a power of two");
 
 struct guix_event {
     Chain_Node node;
     GX_EVENT event;
+    int slot;
+};
+
+/*
+ * Interrupt ring cell. A cell is free for the producer that reserved
+ * position n when seq == n and holds its event once seq == n + 1, so
+ * nested interrupts can post without a lock (bounded MPSC queue).
+ */
+struct guix_isr_cell {
+    atomic_uint seq;
+    GX_EVENT event;
 };
 
 struct guix_struct {
-    Chain_Control pending;
+    Chain_Control lanes[GUIX_LANES];
     Chain_Control free;
+    struct guix_event *fold[GUIX_FOLD_SLOTS];
+    unsigned int queued;
+    struct guix_queue_stats stats;
     rtems_mutex qmutex;
-    rtems_condition_variable qcond;
+    rtems_binary_semaphore qwake;
+    struct guix_isr_cell isr[GX_ISR_QUEUE_EVENTS];
+    atomic_uint isr_head;
+    atomic_uint isr_dropped;
+    /* The ring consumer, protected by isr_lock */
+    unsigned int isr_tail;
+    rtems_mutex isr_lock;
     rtems_mutex mutex;
     rtems_id timer;
     rtems_id thread;
+    rtems_binary_semaphore timer_wake;
+    rtems_interval timer_period;
+    rtems_interval timer_base;
+    rtems_interval timer_charge;
 #if (CONFIG_GUIX_MEMPOOL_SIZE > 0)
     rtems_id mpool_id;
     void *mpool;
 #endif
     bool timer_running;
     bool timer_active;
+    bool timer_busy;
+    bool timer_popped;
     VOID (*entry)(ULONG);
     struct guix_event events[GX_MAX_QUEUE_EVENTS];
 };
@@ -112,52 +154,359 @@ static int _guix_suspend_notify(unsigned int state)
     return ret;
 }
 
-static void guix_wait_event(rtems_event_set in)
+/* 
+ * GUIX event queue
+ *
+ * Queued events live on one of two FIFO lanes, input first. Every queued
+ * event is also entered in a (type, target) hash index, which keeps the
+ * newest event of each key, so folding does not scan the queue. Interrupts
+ * post through a lock-free ring that is drained through GUIX, so pen events
+ * get the same speed and flick tracking as those sent from a thread.
+ * Everything but the ring is protected by qmutex.
+ */
+static inline int guix_event_lane(const GX_EVENT *e)
 {
-    rtems_status_code sc;
-    rtems_event_set evt;
-    
-    sc = rtems_event_receive(in, RTEMS_WAIT | RTEMS_EVENT_ALL, 
-        RTEMS_NO_TIMEOUT, &evt);
-    assert(sc == RTEMS_SUCCESSFUL);
+    switch (e->gx_event_type) {
+    case GX_EVENT_PEN_DOWN:
+    case GX_EVENT_PEN_UP:
+    case GX_EVENT_PEN_DRAG:
+    case GX_EVENT_KEY_DOWN:
+    case GX_EVENT_KEY_UP:
+        return GUIX_LANE_INPUT;
+    default:
+        return GUIX_LANE_NORMAL;
+    }
 }
 
-static inline void guix_wake_up(rtems_id thread, rtems_event_set evt)
+static inline bool guix_event_same(const GX_EVENT *a, const GX_EVENT *b)
 {
-    rtems_event_send(thread, evt);
+    return a->gx_event_type == b->gx_event_type &&
+        a->gx_event_target == b->gx_event_target;
 }
 
-static rtems_task guix_timer_server(rtems_task_argument arg)
+static inline unsigned int guix_fold_hash(const GX_EVENT *e)
+{
+    uint32_t key = (uint32_t)(uintptr_t)e->gx_event_target ^ 
+        ((uint32_t)e->gx_event_type << 24);
+
+    /* Fibonacci hashing, the top bits are the best mixed */
+    return (key * 2654435769u) >> (32 - GUIX_FOLD_BITS);
+}
+
+static struct guix_event *guix_fold_find(struct guix_struct *gx,
+    const GX_EVENT *e)
+{
+    unsigned int i = guix_fold_hash(e);
+
+    for ( ; gx->fold[i] != NULL; i = (i + 1) & (GUIX_FOLD_SLOTS - 1)) {
+        if (guix_event_same(&gx->fold[i]->event, e))
+            return gx->fold[i];
+    }
+    return NULL;
+}
+
+static void guix_fold_insert(struct guix_struct *gx, struct guix_event *ge)
+{
+    unsigned int i = guix_fold_hash(&ge->event);
+
+    for ( ; gx->fold[i] != NULL; i = (i + 1) & (GUIX_FOLD_SLOTS - 1)) {
+        /* An older event of the same key drops out of the index */
+        if (guix_event_same(&gx->fold[i]->event, &ge->event)) {
+            gx->fold[i]->slot = GUIX_FOLD_NONE;
+            break;
+        }
+    }
+    gx->fold[i] = ge;
+    ge->slot = i;
+}
+
+static void guix_fold_remove(struct guix_struct *gx, struct guix_event *ge)
+{
+    unsigned int i = ge->slot;
+    unsigned int j, home;
+
+    if (ge->slot == GUIX_FOLD_NONE)
+        return;
+
+    /* Shift the rest of the probe run back so lookups need no tombstones */
+    gx->fold[i] = NULL;
+    ge->slot = GUIX_FOLD_NONE;
+    for (j = (i + 1) & (GUIX_FOLD_SLOTS - 1); gx->fold[j] != NULL;
+        j = (j + 1) & (GUIX_FOLD_SLOTS - 1)) {
+        home = guix_fold_hash(&gx->fold[j]->event);
+        if (((j - home) & (GUIX_FOLD_SLOTS - 1)) <
+            ((j - i) & (GUIX_FOLD_SLOTS - 1)))
+            continue;
+        gx->fold[i] = gx->fold[j];
+        gx->fold[i]->slot = i;
+        gx->fold[j] = NULL;
+        i = j;
+    }
+}
+
+/* Queue an event, called with qmutex held */
+static bool guix_event_append(struct guix_struct *gx, GX_EVENT *event_ptr)
+{
+    struct guix_event *ge;
+
+    if (_Chain_Is_empty(&gx->free)) {
+        gx->stats.dropped++;
+        return false;
+    }
+
+    ge = (struct guix_event *)_Chain_Get_first_unprotected(&gx->free);
+    ge->event = *event_ptr;
+    _Chain_Append_unprotected(&gx->lanes[guix_event_lane(event_ptr)], 
+        &ge->node);
+    guix_fold_insert(gx, ge);
+
+    gx->stats.posted++;
+    if (guix_event_lane(event_ptr) == GUIX_LANE_INPUT)
+        gx->stats.input++;
+    if (++gx->queued > gx->stats.high_water)
+        gx->stats.high_water = gx->queued;
+    if (gx->queued == 1)
+        rtems_binary_semaphore_post(&gx->qwake);
+    return true;
+}
+
+/* Fold an event into a queued one or queue it, called with qmutex held */
+static bool guix_event_fold(struct guix_struct *gx, GX_EVENT *event_ptr)
+{
+    Chain_Control *lane = &gx->lanes[guix_event_lane(event_ptr)];
+    struct guix_event *ge;
+    GX_EVENT *e;
+
+    ge = guix_fold_find(gx, event_ptr);
+
+    /* Input folds only into the newest input event, to keep pen order */
+    if (ge == NULL || (lane == &gx->lanes[GUIX_LANE_INPUT] && 
+        &ge->node != _Chain_Last(lane))) {
+        /* As _gx_system_event_send() would */
+        if (event_ptr->gx_event_type == GX_EVENT_PEN_DRAG)
+            _gx_system_pen_speed_update(
+                &event_ptr->gx_event_payload.gx_event_pointdata);
+        return guix_event_append(gx, event_ptr);
+    }
+
+    e = &ge->event;
+
+    /* for timer event, update tick count */
+    if (e->gx_event_type == GX_EVENT_TIMER) {
+        e->gx_event_payload.gx_event_ulongdata += 
+            event_ptr->gx_event_payload.gx_event_ulongdata;
+    } else {
+        e->gx_event_payload.gx_event_ulongdata =
+            event_ptr->gx_event_payload.gx_event_ulongdata;
+    }
+
+    if (e->gx_event_type == GX_EVENT_PEN_DRAG)
+         _gx_system_pen_speed_update(&e->gx_event_payload.gx_event_pointdata);
+    gx->stats.folded++;
+    return true;
+}
+
+static void guix_event_remove(struct guix_struct *gx, struct guix_event *ge)
+{
+    guix_fold_remove(gx, ge);
+    _Chain_Extract_unprotected(&ge->node);
+    _Chain_Append_unprotected(&gx->free, &ge->node);
+    gx->queued--;
+}
+
+/*
+ * Send the events posted from interrupts through GUIX, which tracks the pen
+ * speed and flicks and then queues them. Called without qmutex.
+ */
+static void guix_isr_drain(struct guix_struct *gx)
+{
+    struct guix_isr_cell *cell;
+    unsigned int count = 0;
+    GX_EVENT event;
+
+    rtems_mutex_lock(&gx->isr_lock);
+    while (true) {
+        cell = &gx->isr[gx->isr_tail & (GX_ISR_QUEUE_EVENTS - 1)];
+        if (atomic_load_explicit(&cell->seq, memory_order_acquire) != 
+            gx->isr_tail + 1)
+            break;
+
+        event = cell->event;
+        atomic_store_explicit(&cell->seq, gx->isr_tail + GX_ISR_QUEUE_EVENTS,
+            memory_order_release);
+        gx->isr_tail++;
+
+        count++;
+        if (event.gx_event_type == GX_EVENT_PEN_DRAG)
+            _gx_system_event_fold(&event);
+        else
+            _gx_system_event_send(&event);
+    }
+    rtems_mutex_unlock(&gx->isr_lock);
+
+    if (count > 0) {
+        rtems_mutex_lock(&gx->qmutex);
+        gx->stats.isr += count;
+        rtems_mutex_unlock(&gx->qmutex);
+    }
+}
+
+/* 
+ * GUIX timer server
+ *
+ * Rather than ticking every GX_SYSTEM_TIMER_MS, the server task waits on
+ * timer_wake with a timeout until the nearest GUIX timer is due and then
+ * posts one GX_EVENT_TIMER for all GUIX ticks that elapsed since
+ * timer_base. No further timer event is posted until GUIX has applied that
+ * one (timer_busy), so the active timer list always reflects every tick up
+ * to timer_base once the server looks at it.
+ *
+ * The event itself carries no ticks, they are kept in timer_charge and
+ * taken off the timers active at the time the event is popped, or earlier
+ * if a timer is (re)loaded while the event is queued. Loading a timer also
+ * charges the whole ticks since timer_base to the others, so it is not
+ * charged for time before it was started. The timer state is protected by
+ * qmutex, the active timer list by the GUIX lock.
+ */
+static rtems_interval guix_timer_next(void)
+{
+    GX_TIMER *timer;
+    UINT next = GUIX_TIMER_MAX_TICKS;
+
+    _gx_system_lock();
+
+    /* Animations advance one frame per timer event, whatever its ticks */
+    if (_gx_system_animation_list) {
+        _gx_system_unlock();
+        return 1;
+    }
+
+    timer = _gx_system_active_timer_list;
+    if (timer == NULL) {
+        _gx_system_unlock();
+        return 0;
+    }
+
+    for ( ; timer != NULL; timer = timer->gx_timer_next) {
+        if (timer->gx_timer_initial_ticks < next)
+            next = timer->gx_timer_initial_ticks;
+    }
+    _gx_system_unlock();
+    return next ? next : 1;
+}
+
+/* Account the whole GUIX ticks elapsed since timer_base to the active timers */
+static void guix_timer_advance(struct guix_struct *gx)
 {
-    struct guix_struct *gx = &guix_class;
     rtems_interval ticks;
-    
-    ticks = rtems_configuration_get_microseconds_per_tick();
-    ticks = (1000UL * GX_SYSTEM_TIMER_MS) / ticks;
+    GX_TIMER *timer;
+
+    ticks = (rtems_clock_get_ticks_since_boot() - gx->timer_base) / 
+        gx->timer_period;
     if (ticks == 0)
-        ticks = 1;
+        return;
 
-    if (!gx->timer_running)
-        rtems_task_suspend(RTEMS_SELF);
-    gx->timer_active = true;
+    gx->timer_base += ticks * gx->timer_period;
+    for (timer = _gx_system_active_timer_list; timer != NULL; 
+        timer = timer->gx_timer_next) {
+        /* Overdue timers expire with the next event, charged ones with theirs */
+        if (timer->gx_timer_initial_ticks > ticks)
+            timer->gx_timer_initial_ticks -= ticks;
+        else if (timer->gx_timer_initial_ticks != 0)
+            timer->gx_timer_initial_ticks = 1;
+    }
+}
+
+/*
+ * Apply the ticks of the queued timer event to the active timers. Expired
+ * timers are left at 0 for the event, which carries no ticks, to fire them.
+ * Called with the GUIX lock and qmutex held.
+ */
+static void guix_timer_charge(struct guix_struct *gx)
+{
+    rtems_interval ticks = gx->timer_charge;
+    GX_TIMER *timer;
+
+    if (ticks == 0)
+        return;
+
+    gx->timer_charge = 0;
+    for (timer = _gx_system_active_timer_list; timer != NULL; 
+        timer = timer->gx_timer_next) {
+        if (timer->gx_timer_initial_ticks > ticks)
+            timer->gx_timer_initial_ticks -= ticks;
+        else
+            timer->gx_timer_initial_ticks = 0;
+    }
+}
+
+static inline bool guix_timer_event(const GX_EVENT *event)
+{
+    return event->gx_event_type == GX_EVENT_TIMER &&
+        event->gx_event_target == GX_NULL;
+}
+
+static bool guix_timer_ready(struct guix_struct *gx)
+{
+    return gx->timer_running && gx->timer_active && !gx->timer_busy;
+}
+
+static rtems_task guix_timer_server(rtems_task_argument arg)
+{
+    struct guix_struct *gx = (struct guix_struct *)arg;
+    rtems_interval next, elapsed, timeout, ticks;
+    GX_EVENT event;
+
+    event.gx_event_type = GX_EVENT_TIMER;
+    event.gx_event_sender = 0;
+    event.gx_event_target = GX_NULL;
+    event.gx_event_payload.gx_event_ulongdata = 0;
     
     while (true) {
-        rtems_task_wake_after(ticks);
-
-        while (!gx->timer_active) {
-            guix_wake_up(gx->thread, GUIX_TIMER_DONE_EVENT);
-            guix_wait_event(GUIX_TIMER_WAKEUP_EVENT);
+        next = guix_timer_next();
+        timeout = RTEMS_NO_TIMEOUT;
+
+        rtems_mutex_lock(&gx->qmutex);
+        if (next && guix_timer_ready(gx)) {
+            elapsed = rtems_clock_get_ticks_since_boot() - gx->timer_base;
+            timeout = next * gx->timer_period;
+            if (elapsed >= timeout) {
+                ticks = elapsed / gx->timer_period;
+                if (guix_event_append(gx, &event)) {
+                    gx->timer_base += ticks * gx->timer_period;
+                    gx->timer_charge += ticks;
+                    gx->timer_busy = true;
+                    timeout = RTEMS_NO_TIMEOUT;
+                } else {
+                    /* Queue full, try again one GUIX tick later */
+                    timeout = gx->timer_period;
+                }
+            } else {
+                timeout -= elapsed;
+            }
         }
-        
-        _gx_system_timer_expiration(0);
+        rtems_mutex_unlock(&gx->qmutex);
+
+        if (timeout == RTEMS_NO_TIMEOUT)
+            rtems_binary_semaphore_wait(&gx->timer_wake);
+        else
+            rtems_binary_semaphore_wait_timed_ticks(&gx->timer_wake, timeout);
     }
 }
 
+static void guix_timer_activate(struct guix_struct *gx, bool active)
+{
+    rtems_mutex_lock(&gx->qmutex);
+    gx->timer_active = active;
+    gx->timer_base = rtems_clock_get_ticks_since_boot();
+    rtems_mutex_unlock(&gx->qmutex);
+    rtems_binary_semaphore_post(&gx->timer_wake);
+}
+
 static void guix_thread_adaptor(rtems_task_argument arg)
 {
     struct guix_struct *gx = (struct guix_struct *)arg;
     GX_EVENT event;
-    bool wake_up ;
     UINT ret;
 
     while (true) {
@@ -165,14 +514,8 @@ static void guix_thread_adaptor(rtems_task_argument arg)
         /* Process GUI event */
         gx->entry(0);
 
-        /* GUIX thread exited and stop timer */
-        if (!rtems_task_is_suspended(gx->timer)) {
-            wake_up = true;
-            gx->timer_active = false;
-            guix_wait_event(GUIX_TIMER_DONE_EVENT);
-        } else {
-            wake_up = false;
-        }
+        /* GUIX thread exited, the timers stand still until it is back */
+        guix_timer_activate(gx, false);
 
         /* Notify system that gui will enter in suspend state */
         _guix_suspend_notify(GUIX_ENTER_SLEEP);
@@ -195,10 +538,7 @@ static void guix_thread_adaptor(rtems_task_argument arg)
         _guix_suspend_notify(GUIX_EXIT_SLEEP);
         
         /* Wake up GUIX timer */
-        if (wake_up) {
-            gx->timer_active = true;
-            guix_wake_up(gx->timer, GUIX_TIMER_WAKEUP_EVENT);
-        }
+        guix_timer_activate(gx, true);
     }
 }
 
@@ -210,14 +550,26 @@ VOID gx_generic_rtos_initialize(VOID)
 {
     struct guix_struct *gx = &guix_class;
 
-    _Chain_Initialize_empty(&gx->pending);
+    for (int i = 0; i < GUIX_LANES; i++)
+        _Chain_Initialize_empty(&gx->lanes[i]);
     _Chain_Initialize_empty(&gx->free);
     _Chain_Initialize(&gx->free, gx->events, GX_MAX_QUEUE_EVENTS, 
         sizeof(struct guix_event));
+    for (int i = 0; i < GX_ISR_QUEUE_EVENTS; i++)
+        atomic_init(&gx->isr[i].seq, i);
+    atomic_init(&gx->isr_head, 0);
+    atomic_init(&gx->isr_dropped, 0);
 	rtems_mutex_init(&gx->mutex, "guix_system");
     rtems_mutex_init(&gx->qmutex, "guix_qevent");
-    rtems_condition_variable_init(&gx->qcond, "guix_qevent");
+    rtems_mutex_init(&gx->isr_lock, "guix_isr");
+    rtems_binary_semaphore_init(&gx->qwake, "guix_qevent");
     rtems_mutex_init(&guix_notifier_lock, "guix_notifier");
+    rtems_binary_semaphore_init(&gx->timer_wake, "guix_timer");
+    gx->timer_active = true;
+    gx->timer_period = (1000UL * GX_SYSTEM_TIMER_MS) / 
+        rtems_configuration_get_microseconds_per_tick();
+    if (gx->timer_period == 0)
+        gx->timer_period = 1;
     
 #if (CONFIG_GUIX_MEMPOOL_SIZE > 0)
     gx->mpool = malloc(CONFIG_GUIX_MEMPOOL_SIZE);
@@ -287,70 +639,33 @@ UINT gx_generic_thread_start(VOID(*guix_thread_entry)(ULONG))
 UINT gx_generic_event_post(GX_EVENT *event_ptr)
 {
     struct guix_struct *gx = &guix_class;
-    struct guix_event *ge;
+    bool queued;
 
     rtems_mutex_lock(&gx->qmutex);
-    if (_Chain_Is_empty(&gx->free)) {
-        rtems_mutex_unlock(&gx->qmutex);
-        return GX_FAILURE;
-    }
-    
-    ge = (struct guix_event *)_Chain_Get_first_unprotected(&gx->free);
-    ge->event = *event_ptr;
-    _Chain_Append_unprotected(&gx->pending, &ge->node);
-    if (_Chain_Has_only_one_node(&gx->pending))
-        rtems_condition_variable_signal(&gx->qcond);
+    queued = guix_event_append(gx, event_ptr);
     rtems_mutex_unlock(&gx->qmutex);
     
-    return GX_SUCCESS;
+    return queued ? GX_SUCCESS : GX_FAILURE;
 }
 
 /* event_fold: update existing matching event, otherwise post new event */
 UINT gx_generic_event_fold(GX_EVENT *event_ptr)
 {
     struct guix_struct *gx = &guix_class;
-    struct guix_event *ge;
-    GX_EVENT *e;
+    bool queued;
    
     rtems_mutex_lock(&gx->qmutex);
-    Chain_Control *head = &gx->pending;
-    Chain_Node *iter = _Chain_First(head);
-    
-    while (iter != _Chain_Tail(head)) {
-        ge = (struct guix_event *)iter;
-        e = &ge->event;
-    
-        if (e->gx_event_type == event_ptr->gx_event_type &&
-            e->gx_event_target == event_ptr->gx_event_target) {
-
-            /* for timer event, update tick count */
-            if (e->gx_event_type == GX_EVENT_TIMER) {
-                e->gx_event_payload.gx_event_ulongdata++;
-            } else {
-                e->gx_event_payload.gx_event_ulongdata =
-                    event_ptr->gx_event_payload.gx_event_ulongdata;
-            }
-
-            if (e->gx_event_type == GX_EVENT_PEN_DRAG)
-                 _gx_system_pen_speed_update(&e->gx_event_payload.gx_event_pointdata);
-            rtems_mutex_unlock(&gx->qmutex);
-            return GX_SUCCESS;
-        }
+    queued = guix_event_fold(gx, event_ptr);
+    rtems_mutex_unlock(&gx->qmutex);
 
-        iter = _Chain_Next(iter);
-    }
+    return queued ? GX_SUCCESS : GX_FAILURE;
+}
 
-    if (_Chain_Is_empty(&gx->free)) {
-        rtems_mutex_unlock(&gx->qmutex);
-        return GX_FAILURE;
-    }
-    ge = (struct guix_event *)_Chain_Get_first_unprotected(&gx->free);
-    ge->event = *event_ptr;
-    _Chain_Append_unprotected(&gx->pending, &ge->node);
-    if (_Chain_Has_only_one_node(&gx->pending))
-        rtems_condition_variable_signal(&gx->qcond);
-    rtems_mutex_unlock(&gx->qmutex);
-    return GX_SUCCESS;
+static struct guix_event *guix_event_first(struct guix_struct *gx)
+{
+    if (!_Chain_Is_empty(&gx->lanes[GUIX_LANE_INPUT]))
+        return (struct guix_event *)_Chain_First(&gx->lanes[GUIX_LANE_INPUT]);
+    return (struct guix_event *)_Chain_First(&gx->lanes[GUIX_LANE_NORMAL]);
 }
 
 /* event_pop: pop oldest event from fifo queue, block if wait and no events exist */
@@ -358,18 +673,64 @@ UINT gx_generic_event_pop(GX_EVENT *put_event, GX_BOOL wait)
 {
     struct guix_struct *gx = &guix_class;
     struct guix_event *ge;
+    bool locked = false;
     
-    if (!wait && _Chain_Is_empty(&gx->pending))
-       return GX_FAILURE;
-
+    guix_isr_drain(gx);
     rtems_mutex_lock(&gx->qmutex);
-    while (_Chain_Is_empty(&gx->pending))
-        rtems_condition_variable_wait(&gx->qcond, &gx->qmutex);
 
-    ge = (struct guix_event *)_Chain_Get_first_unprotected(&gx->pending);
+    /* 
+     * GUIX pops the next event only after handling the previous one, so the
+     * timer event popped last time has been applied to the active timers
+     * and the timer server can look for the next deadline.
+     */
+    if (gx->timer_popped) {
+        gx->timer_popped = false;
+        gx->timer_busy = false;
+        rtems_binary_semaphore_post(&gx->timer_wake);
+    }
+
+    while (true) {
+        if (gx->queued > 0) {
+            ge = guix_event_first(gx);
+            if (locked || gx->timer_charge == 0 || 
+                !guix_timer_event(&ge->event))
+                break;
+
+            /* Charging the timers needs the GUIX lock, taken before qmutex */
+            rtems_mutex_unlock(&gx->qmutex);
+            _gx_system_lock();
+            locked = true;
+            rtems_mutex_lock(&gx->qmutex);
+            continue;
+        }
+
+        if (locked) {
+            _gx_system_unlock();
+            locked = false;
+        }
+
+        if (!wait) {
+            rtems_mutex_unlock(&gx->qmutex);
+            return GX_FAILURE;
+        }
+
+        /* qwake is posted by the first event queued and by interrupts */
+        rtems_mutex_unlock(&gx->qmutex);
+        rtems_binary_semaphore_wait(&gx->qwake);
+        guix_isr_drain(gx);
+        rtems_mutex_lock(&gx->qmutex);
+    }
+
     *put_event = ge->event;
-    _Chain_Append_unprotected(&gx->free, &ge->node);
+    guix_event_remove(gx, ge);
+    if (guix_timer_event(put_event)) {
+        if (locked)
+            guix_timer_charge(gx);
+        gx->timer_popped = true;
+    }
     rtems_mutex_unlock(&gx->qmutex);
+    if (locked)
+        _gx_system_unlock();
     return GX_SUCCESS;
 }
 
@@ -377,50 +738,127 @@ UINT gx_generic_event_pop(GX_EVENT *put_event, GX_BOOL wait)
 VOID gx_generic_event_purge(GX_WIDGET *target)
 {
     struct guix_struct *gx = &guix_class;
+    struct guix_event *ge;
+    Chain_Node *iter, *next;
     GX_BOOL purge;
+    bool children;
     
+    /* Only a widget with children needs the parent chain walked */
+    children = target->gx_widget_first_child != GX_NULL;
+
+    guix_isr_drain(gx);
     rtems_mutex_lock(&gx->qmutex);
-    Chain_Control *head = &gx->pending;
-    Chain_Node *iter = _Chain_First(head);
-
-    while (iter != _Chain_Tail(head)) {
-        struct guix_event *ge = (struct guix_event *)iter;
-        purge = GX_FALSE;
-        if (ge->event.gx_event_target) {
-            if (ge->event.gx_event_target == target) {
-                purge = GX_TRUE;
-            } else {
+    for (int i = 0; i < GUIX_LANES; i++) {
+        Chain_Control *head = &gx->lanes[i];
+
+        for (iter = _Chain_First(head); iter != _Chain_Tail(head); 
+            iter = next) {
+            next = _Chain_Next(iter);
+            ge = (struct guix_event *)iter;
+            if (ge->event.gx_event_target == GX_NULL)
+                continue;
+
+            purge = ge->event.gx_event_target == target;
+            if (!purge && children)
                 gx_widget_child_detect(target, ge->event.gx_event_target,
                     &purge);
+            if (purge) {
+                guix_event_remove(gx, ge);
+                gx->stats.purged++;
             }
-            if (purge == GX_TRUE) {
-                _Chain_Extract_unprotected(iter);
-                _Chain_Append_unprotected(&gx->free, iter);
-            }
         }
-        iter = _Chain_Next(iter);
     }
     rtems_mutex_unlock(&gx->qmutex);
 }
 
-/* start the RTOS timer */
+/*
+ * Post an event from interrupt context. The GUIX thread sends it on through
+ * _gx_system_event_send(), pen drags through _gx_system_event_fold().
+ */
+int guix_event_post_isr(const GX_EVENT *event_ptr)
+{
+    struct guix_struct *gx = &guix_class;
+    struct guix_isr_cell *cell;
+    unsigned int pos, seq;
+
+    if (gx->entry == NULL)
+        return -ENODEV;
+
+    pos = atomic_load_explicit(&gx->isr_head, memory_order_relaxed);
+    while (true) {
+        cell = &gx->isr[pos & (GX_ISR_QUEUE_EVENTS - 1)];
+        seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        if (seq == pos) {
+            if (atomic_compare_exchange_weak_explicit(&gx->isr_head, &pos,
+                pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if ((int)(seq - pos) < 0) {
+            atomic_fetch_add_explicit(&gx->isr_dropped, 1, 
+                memory_order_relaxed);
+            return -ENOSPC;
+        } else {
+            pos = atomic_load_explicit(&gx->isr_head, memory_order_relaxed);
+        }
+    }
+
+    cell->event = *event_ptr;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    rtems_binary_semaphore_post(&gx->qwake);
+    return 0;
+}
+
+void guix_queue_stats_get(struct guix_queue_stats *stats, bool reset)
+{
+    struct guix_struct *gx = &guix_class;
+
+    rtems_mutex_lock(&gx->qmutex);
+    *stats = gx->stats;
+    stats->queued = gx->queued;
+    if (reset) {
+        memset(&gx->stats, 0, sizeof(gx->stats));
+        stats->isr_dropped = atomic_exchange_explicit(&gx->isr_dropped, 0,
+            memory_order_relaxed);
+    } else {
+        stats->isr_dropped = atomic_load_explicit(&gx->isr_dropped,
+            memory_order_relaxed);
+    }
+    rtems_mutex_unlock(&gx->qmutex);
+}
+
+/* 
+ * start the RTOS timer, also called before a GUIX timer is (re)loaded so
+ * that the elapsed ticks and those of a queued timer event are not charged
+ * to the new timer
+ */
 VOID gx_generic_timer_start(VOID)
 {
     struct guix_struct *gx = &guix_class;
+
+    _gx_system_lock();
+    rtems_mutex_lock(&gx->qmutex);
+    guix_timer_charge(gx);
     if (!gx->timer_running) {
         gx->timer_running = true;
-        rtems_task_resume(gx->timer);
+        gx->timer_base = rtems_clock_get_ticks_since_boot();
+    } else if (gx->timer_active) {
+        guix_timer_advance(gx);
     }
+    rtems_mutex_unlock(&gx->qmutex);
+    _gx_system_unlock();
+
+    /* The new timer may be due before the armed deadline */
+    rtems_binary_semaphore_post(&gx->timer_wake);
 }
 
 /* stop the RTOS timer */
 VOID gx_generic_timer_stop(VOID)
 {
     struct guix_struct *gx = &guix_class;
-    if (gx->timer_running) {
-        gx->timer_running = false;
-        rtems_task_suspend(gx->timer);
-    }
+
+    rtems_mutex_lock(&gx->qmutex);
+    gx->timer_running = false;
+    rtems_mutex_unlock(&gx->qmutex);
+    rtems_binary_semaphore_post(&gx->timer_wake);
 }
 
 /* lock the system protection mutex */
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rtems/shell.h>
+#include <rtems/sysinit.h>
+
+#include "gx_api.h"
+
+#define GXSTAT_HELP \
+    "GUIX frame and event queue statistics\n" \
+    "\n" \
+    "gxstat [-r][--reset]\n"
+
+
+static void gxstat_queue_dump(bool reset)
+{
+    struct guix_queue_stats st;
+
+    guix_queue_stats_get(&st, reset);
+    printf("\n%8s %8s %8s %8s %8s %8s %8s %6s %6s\n", "Posted", "Input",
+        "Folded", "ISR", "Purged", "Dropped", "ISRDrop", "Peak", "Now");
+    printf("%8lu %8lu %8lu %8lu %8lu %8lu %8lu %6lu %6lu\n",
+        (unsigned long)st.posted, (unsigned long)st.input,
+        (unsigned long)st.folded, (unsigned long)st.isr,
+        (unsigned long)st.purged, (unsigned long)st.dropped,
+        (unsigned long)st.isr_dropped, (unsigned long)st.high_water,
+        (unsigned long)st.queued);
+}
+
+static int shell_main_gxstat(int argc, char *argv[])
+{
+    bool reset = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--reset") ||
+            !strcmp(argv[i], "-r")) {
+            reset = true;
+        } else {
+            puts(GXSTAT_HELP);
+            return -EINVAL;
+        }
+    }
+
+    guix_flush_stats_dump(reset);
+    gxstat_queue_dump(reset);
+    return 0;
+}
+
+static void shell_gxstat_register(void)
+{
+    static rtems_shell_cmd_t shell_gxstat_command = {
+        "gxstat",                        /* name */
+        GXSTAT_HELP,                     /* usage */
+        "rtems",                         /* topic */
+        shell_main_gxstat,               /* command */
+        NULL,                            /* aliass */
+        NULL                             /* next */
+    };
+
+    rtems_shell_add_cmd_struct(&shell_gxstat_command);
+}
+
+RTEMS_SYSINIT_ITEM(shell_gxstat_register,
+    RTEMS_SYSINIT_LAST,
+    RTEMS_SYSINIT_ORDER_MIDDLE);
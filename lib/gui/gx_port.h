@@ -2,6 +2,7 @@
 #define LIB_GX_PORT_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "guix_rtems_notify.h"
 
 typedef INT    GX_BOOL;
@@ -18,6 +19,10 @@ typedef SHORT  GX_VALUE;
 #define GX_TIMER_THREAD_STACK_SIZE          (4 * 1024)
 #endif
 
+#ifndef GX_FLUSH_THREAD_STACK_SIZE
+#define GX_FLUSH_THREAD_STACK_SIZE          (2 * 1024)
+#endif
+
 #ifndef GX_TICKS_SECOND
 #define GX_TICKS_SECOND                     20
 #endif
@@ -30,6 +35,9 @@ typedef SHORT  GX_VALUE;
 #define GX_MAX_VIEWS                        32
 #define GX_MAX_DISPLAY_HEIGHT               800
 #define GX_SYSTEM_THREAD_PRIORITY           9
+#define GX_FLUSH_THREAD_PRIORITY            (GX_SYSTEM_THREAD_PRIORITY - 1)
+#define GX_FLUSH_WINDOWS                    4
+#define GX_ISR_QUEUE_EVENTS                 16   /* power of two */
 
 /* Override define */
 #define GX_CALLER_CHECKING_EXTERNS
@@ -43,16 +51,46 @@ extern "C"{
 #endif
 
 struct GX_DISPLAY_STRUCT;
+struct GX_EVENT_STRUCT;
+struct guix_flush;
 
 #ifdef CONFIG_GUI_SPLIT_BINRES
 struct GX_THEME_STRUCT;
 struct GX_STRING_STRUCT;
 #endif
 
+/* Inclusive panel window, in canvas pixels */
+struct guix_window {
+    GX_VALUE left;
+    GX_VALUE top;
+    GX_VALUE right;
+    GX_VALUE bottom;
+};
+
 struct guix_driver {
     UINT (*setup)(struct GX_DISPLAY_STRUCT *display);
+    /*
+     * Optional, used by guix_flush_attach(): start sending @win to the
+     * panel. @pixels points at the top-left pixel of the window and rows
+     * are @pitch bytes apart. Return 0 and call guix_flush_done() once the
+     * transfer has finished, or a negative error code to skip the window.
+     */
+    int (*flush_window)(struct guix_driver *drv,
+        const struct guix_window *win, const VOID *pixels, UINT pitch);
+    /*
+     * Optional, for panels scanned out of memory: make @frame the visible
+     * buffer. Return 0 and call guix_flush_done() once it is live, or a
+     * negative error code to skip the frame. Takes precedence over
+     * flush_window().
+     */
+    int (*present)(struct guix_driver *drv, const VOID *frame);
     struct guix_driver *next;
     UINT id;
+    /* Panel window alignment in pixels, power of two, 0 for none */
+    UINT flush_align;
+    /* The driver calls guix_vsync_notify() on every vsync/TE edge */
+    bool vsync;
+    struct guix_flush *flush;
 #ifdef CONFIG_GUI_SPLIT_BINRES
     VOID (*mmap)(VOID);
     VOID (*unmap)(VOID);
@@ -67,6 +105,66 @@ UINT guix_binres_load(struct guix_driver *drv, INT theme_id,
 UINT guix_main(UINT disp_id, struct guix_driver *drv);
 
 int guix_driver_register(struct guix_driver *drv);
+
+struct guix_queue_stats {
+    uint32_t posted;        /* Events queued */
+    uint32_t input;         /* Of those, on the input lane */
+    uint32_t folded;        /* Events merged into a queued one */
+    uint32_t isr;           /* Events posted from interrupts */
+    uint32_t purged;
+    uint32_t dropped;       /* Lost to a full queue */
+    uint32_t isr_dropped;   /* Lost to a full interrupt ring */
+    uint32_t high_water;    /* Most events queued at once */
+    uint32_t queued;        /* Queued now */
+};
+
+/*
+ * Event queue: pen and key events are popped before all others. Touch and
+ * key drivers may post from their interrupt with guix_event_post_isr(),
+ * which returns -ENOSPC once GX_ISR_QUEUE_EVENTS events are waiting.
+ */
+int guix_event_post_isr(const struct GX_EVENT_STRUCT *event);
+void guix_queue_stats_get(struct guix_queue_stats *stats, bool reset);
+
+struct guix_flush_stats {
+    uint32_t frames;        /* Frames rendered */
+    uint32_t presented;     /* Frames sent to or shown on the panel */
+    uint32_t merged;        /* Frames folded into a newer one unshown */
+    uint32_t waits;         /* Renders that waited for a free buffer */
+    uint32_t vsyncs;
+    uint32_t timeouts;
+    uint64_t render_ns;     /* First draw to buffer toggle, summed */
+    uint64_t render_max_ns;
+    uint64_t latency_ns;    /* Buffer toggle to on the panel, summed */
+    uint64_t latency_max_ns;
+    uint64_t elapsed_ns;    /* Since the last reset */
+};
+
+/*
+ * Presentation: call from the driver setup. Replaces the display's
+ * buffer toggle with one that merges the canvas dirty list into at most
+ * GX_FLUSH_WINDOWS windows and queues the frame for a presenter thread,
+ * which waits for vsync if drv->vsync is set and then calls
+ * drv->present() or drv->flush_window(). @buffers are @count spare
+ * buffers of the canvas size (0 to 2, at least 1 for present()); GUIX
+ * renders into them in turn, with no spare buffer the toggle waits for
+ * the transfer.
+ */
+int guix_flush_attach(struct guix_driver *drv,
+    struct GX_DISPLAY_STRUCT *display, VOID **buffers, UINT count);
+void guix_flush_done(struct guix_driver *drv);
+int guix_flush_stats_get(UINT id, struct guix_flush_stats *stats, bool reset);
+void guix_flush_stats_dump(bool reset);
+
+/*
+ * Vsync/TE observers, called from the interrupt with the driver as data
+ * and its id as action. Keep them short and interrupt safe; they run
+ * outside the list lock and may post semaphores. At most four observers
+ * are registered (-ENOSPC), unregister only from a task.
+ */
+int guix_vsync_register(struct observer_base *observer);
+int guix_vsync_unregister(struct observer_base *observer);
+void guix_vsync_notify(struct guix_driver *drv);
         
 #ifdef __cplusplus
 }
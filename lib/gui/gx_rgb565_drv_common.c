@@ -3,6 +3,10 @@
 #include "gx_display.h"
 #include "gx_utility.h"
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 
 #define __write_pixel(_addr, _color) \
     *(USHORT *)(_addr) = __builtin_bswap16((USHORT)_color)
@@ -740,7 +744,8 @@ INT          col;
             for (col = overlap.gx_rectangle_left; col <= overlap.gx_rectangle_right; col++)
             {
                 /* read the foreground color */
-                fcolor = *read++;
+                fcolor = __read_pixel(read);
+                read++;
 
                 /* split foreground into red, green, and blue components */
                 fred = REDVAL(fcolor);
@@ -748,7 +753,7 @@ INT          col;
                 fblue = BLUEVAL(fcolor);
 
                 /* read background color */
-                bcolor = *write;
+                bcolor = __read_pixel(write);
 
                 /* split background color into red, green, and blue components */
                 bred = REDVAL(bcolor);
@@ -770,6 +775,476 @@ INT          col;
     }
 }
 
+#if defined(__ARM_NEON)
+/*
+ * NEON versions of the fill, copy, blend and pattern routines for Cortex-A.
+ * They work on eight pixels per q register and finish each row with the
+ * scalar code. Canvas memory holds byte-swapped pixels, so every load and
+ * store of it goes through vrev16q_u8; pixelmap data is in native order.
+ */
+#define NEON_PIXELS 8
+
+static inline uint16x8_t __neon_read_pixels(const USHORT *addr)
+{
+    return vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8((const uint8_t *)addr)));
+}
+
+static inline VOID __neon_write_pixels(USHORT *addr, uint16x8_t pixels)
+{
+    vst1q_u8((uint8_t *)addr, vrev16q_u8(vreinterpretq_u8_u16(pixels)));
+}
+
+static inline uint16x8_t _gx_drv_565rgb_neon_blend(uint16x8_t fcolor,
+    uint16x8_t bcolor, uint16x8_t alpha, uint16x8_t balpha)
+{
+uint16x8_t red;
+uint16x8_t green;
+uint16x8_t blue;
+
+    /* same arithmetic as the scalar code, channel values fit in 16 bits */
+    red = vmulq_u16(vshrq_n_u16(bcolor, 11), balpha);
+    red = vmlaq_u16(red, vshrq_n_u16(fcolor, 11), alpha);
+    green = vmulq_u16(vandq_u16(vshrq_n_u16(bcolor, 5), vdupq_n_u16(0x3f)), balpha);
+    green = vmlaq_u16(green, vandq_u16(vshrq_n_u16(fcolor, 5), vdupq_n_u16(0x3f)), alpha);
+    blue = vmulq_u16(vandq_u16(bcolor, vdupq_n_u16(0x1f)), balpha);
+    blue = vmlaq_u16(blue, vandq_u16(fcolor, vdupq_n_u16(0x1f)), alpha);
+
+    /* re-assemble: insert green above blue, then red above both */
+    blue = vsliq_n_u16(vshrq_n_u16(blue, 8), vshrq_n_u16(green, 8), 5);
+    return vsliq_n_u16(blue, vshrq_n_u16(red, 8), 11);
+}
+
+static USHORT _gx_drv_565rgb_blend_color(USHORT fcolor, USHORT bcolor,
+    GX_UBYTE alpha, GX_UBYTE balpha)
+{
+GX_UBYTE red, green, blue;
+
+    red = (GX_UBYTE)(((REDVAL(bcolor) * balpha) + (REDVAL(fcolor) * alpha)) >> 8);
+    green = (GX_UBYTE)(((GREENVAL(bcolor) * balpha) + (GREENVAL(fcolor) * alpha)) >> 8);
+    blue = (GX_UBYTE)(((BLUEVAL(bcolor) * balpha) + (BLUEVAL(fcolor) * alpha)) >> 8);
+
+    return (USHORT)ASSEMBLECOLOR(red, green, blue);
+}
+
+static inline VOID _gx_drv_16bpp_neon_row_fill(USHORT *put, INT len,
+    uint16x8_t color)
+{
+    for (; len >= NEON_PIXELS * 2; len -= NEON_PIXELS * 2)
+    {
+        vst1q_u16(put, color);
+        vst1q_u16(put + NEON_PIXELS, color);
+        put += NEON_PIXELS * 2;
+    }
+    if (len >= NEON_PIXELS)
+    {
+        vst1q_u16(put, color);
+        put += NEON_PIXELS;
+        len -= NEON_PIXELS;
+    }
+    while (len-- > 0)
+    {
+        *put++ = vgetq_lane_u16(color, 0);
+    }
+}
+
+static VOID _gx_drv_16bpp_neon_horizontal_line_draw(GX_DRAW_CONTEXT *context,
+    INT xstart, INT xend, INT ypos, INT width, GX_COLOR color)
+{
+INT        row;
+USHORT    *rowstart;
+uint16x8_t fill;
+INT        len = xend - xstart + 1;
+
+#if defined GX_BRUSH_ALPHA_SUPPORT
+GX_UBYTE alpha;
+
+    alpha = context -> gx_draw_context_brush.gx_brush_alpha;
+    if (alpha == 0)
+    {
+        /* Nothing to drawn. Just return. */
+        return;
+    }
+
+    if (alpha != 0xff)
+    {
+        _gx_display_driver_horizontal_line_alpha_draw(context, xstart, xend, ypos, width, color, alpha);
+        return;
+    }
+#endif
+
+    fill = vdupq_n_u16(__builtin_bswap16((USHORT)color));
+
+    rowstart = (USHORT *)context -> gx_draw_context_memory;
+    rowstart += context -> gx_draw_context_pitch * ypos + xstart;
+    for (row = 0; row < width; row++)
+    {
+        _gx_drv_16bpp_neon_row_fill(rowstart, len, fill);
+        rowstart += context -> gx_draw_context_pitch;
+    }
+}
+
+static VOID _gx_drv_16bpp_neon_vertical_line_draw(GX_DRAW_CONTEXT *context,
+    INT ystart, INT yend, INT xpos, INT width, GX_COLOR color)
+{
+INT        row;
+USHORT    *rowstart;
+uint16x8_t fill;
+INT        len = yend - ystart + 1;
+
+#if defined GX_BRUSH_ALPHA_SUPPORT
+GX_UBYTE alpha;
+
+    alpha = context -> gx_draw_context_brush.gx_brush_alpha;
+    if (alpha == 0)
+    {
+        /* Nothing to drawn. Just return. */
+        return;
+    }
+    if (alpha != 0xff)
+    {
+        _gx_display_driver_vertical_line_alpha_draw(context, ystart, yend, xpos, width, color, alpha);
+        return;
+    }
+#endif
+
+    fill = vdupq_n_u16(__builtin_bswap16((USHORT)color));
+
+    rowstart = (USHORT *)context -> gx_draw_context_memory;
+    rowstart += context -> gx_draw_context_pitch * ystart + xpos;
+    for (row = 0; row < len; row++)
+    {
+        _gx_drv_16bpp_neon_row_fill(rowstart, width, fill);
+        rowstart += context -> gx_draw_context_pitch;
+    }
+}
+
+/* Select on_color or off_color for eight pixels from the top byte of bits */
+static inline uint16x8_t _gx_drv_16bpp_neon_pattern(ULONG bits,
+    uint16x8_t on_color, uint16x8_t off_color)
+{
+static const uint16_t lane_bits[NEON_PIXELS] = {
+    0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01
+};
+uint16x8_t select;
+
+    select = vtstq_u16(vdupq_n_u16((uint16_t)((bits >> 24) & 0xff)),
+        vld1q_u16(lane_bits));
+    return vbslq_u16(select, on_color, off_color);
+}
+
+static VOID _gx_drv_16bpp_neon_horizontal_pattern_line_draw(GX_DRAW_CONTEXT *context,
+    INT xstart, INT xend, INT ypos)
+{
+USHORT    *put;
+ULONG      pattern;
+ULONG      mask;
+USHORT     on_color;
+USHORT     off_color;
+uint16x8_t block0, block1, block2, block3;
+
+INT        len = xend - xstart + 1;
+
+    put = (USHORT *)context -> gx_draw_context_memory;
+    put += context -> gx_draw_context_pitch * ypos + xstart;
+
+    pattern = context -> gx_draw_context_brush.gx_brush_line_pattern;
+    mask = context -> gx_draw_context_brush.gx_brush_pattern_mask;
+    on_color = (USHORT)context -> gx_draw_context_brush.gx_brush_line_color;
+    off_color = (USHORT)context -> gx_draw_context_brush.gx_brush_fill_color;
+
+    /* walk single pixels until the mask wraps to the top bit, from there
+       on every run of 32 pixels is the same */
+    for (; len > 0 && mask != 0x80000000; len--)
+    {
+        __write_pixel(put, ((pattern & mask) ? on_color : off_color));
+        put++;
+        mask >>= 1;
+        if (!mask)
+        {
+            mask = 0x80000000;
+        }
+    }
+
+    if (len >= 32)
+    {
+        uint16x8_t on = vdupq_n_u16(__builtin_bswap16(on_color));
+        uint16x8_t off = vdupq_n_u16(__builtin_bswap16(off_color));
+
+        block0 = _gx_drv_16bpp_neon_pattern(pattern, on, off);
+        block1 = _gx_drv_16bpp_neon_pattern(pattern << 8, on, off);
+        block2 = _gx_drv_16bpp_neon_pattern(pattern << 16, on, off);
+        block3 = _gx_drv_16bpp_neon_pattern(pattern << 24, on, off);
+        for (; len >= 32; len -= 32)
+        {
+            vst1q_u16(put, block0);
+            vst1q_u16(put + 8, block1);
+            vst1q_u16(put + 16, block2);
+            vst1q_u16(put + 24, block3);
+            put += 32;
+        }
+    }
+
+    for (; len > 0; len--)
+    {
+        __write_pixel(put, ((pattern & mask) ? on_color : off_color));
+        put++;
+        mask >>= 1;
+        if (!mask)
+        {
+            mask = 0x80000000;
+        }
+    }
+
+    /* save current masks value back to brush */
+    context -> gx_draw_context_brush.gx_brush_pattern_mask = mask;
+}
+
+static VOID _gx_drv_565rgb_neon_canvas_blend(GX_CANVAS *canvas, GX_CANVAS *composite)
+{
+GX_RECTANGLE dirty;
+GX_RECTANGLE overlap;
+USHORT      *read;
+USHORT      *write;
+GX_UBYTE     alpha, balpha;
+uint16x8_t   valpha, vbalpha;
+INT          width;
+INT          row;
+INT          col;
+
+    dirty.gx_rectangle_left = dirty.gx_rectangle_top = 0;
+    dirty.gx_rectangle_right = (GX_VALUE)(canvas -> gx_canvas_x_resolution - 1);
+    dirty.gx_rectangle_bottom = (GX_VALUE)(canvas -> gx_canvas_y_resolution - 1);
+
+    _gx_utility_rectangle_shift(&dirty, canvas -> gx_canvas_display_offset_x, canvas -> gx_canvas_display_offset_y);
+
+    if (_gx_utility_rectangle_overlap_detect(&dirty, &composite -> gx_canvas_dirty_area, &overlap))
+    {
+        alpha = canvas -> gx_canvas_alpha;
+        balpha = (GX_UBYTE)(256 - alpha);
+        valpha = vdupq_n_u16(alpha);
+        vbalpha = vdupq_n_u16(balpha);
+        width = overlap.gx_rectangle_right - overlap.gx_rectangle_left + 1;
+
+        read = (USHORT *)canvas -> gx_canvas_memory;
+        read += (overlap.gx_rectangle_top - dirty.gx_rectangle_top) * canvas -> gx_canvas_x_resolution;
+        read += overlap.gx_rectangle_left - dirty.gx_rectangle_left;
+
+        write = (USHORT *)composite -> gx_canvas_memory;
+        write += overlap.gx_rectangle_top * composite -> gx_canvas_x_resolution;
+        write += overlap.gx_rectangle_left;
+
+        for (row = overlap.gx_rectangle_top; row <= overlap.gx_rectangle_bottom; row++)
+        {
+            for (col = 0; col <= width - NEON_PIXELS; col += NEON_PIXELS)
+            {
+                __neon_write_pixels(write + col,
+                    _gx_drv_565rgb_neon_blend(__neon_read_pixels(read + col),
+                        __neon_read_pixels(write + col), valpha, vbalpha));
+            }
+            for (; col < width; col++)
+            {
+                __write_pixel(write + col, _gx_drv_565rgb_blend_color(__read_pixel(&read[col]),
+                    __read_pixel(&write[col]), alpha, balpha));
+            }
+            write += composite -> gx_canvas_x_resolution;
+            read += canvas -> gx_canvas_x_resolution;
+        }
+    }
+}
+
+static VOID _gx_drv_16bpp_neon_canvas_copy(GX_CANVAS *canvas, GX_CANVAS *composite)
+{
+GX_RECTANGLE dirty;
+GX_RECTANGLE overlap;
+USHORT      *read;
+USHORT      *write;
+INT          width;
+INT          row;
+INT          col;
+
+    dirty.gx_rectangle_left = dirty.gx_rectangle_top = 0;
+    dirty.gx_rectangle_right = (GX_VALUE)(canvas -> gx_canvas_x_resolution - 1);
+    dirty.gx_rectangle_bottom = (GX_VALUE)(canvas -> gx_canvas_y_resolution - 1);
+
+    _gx_utility_rectangle_shift(&dirty, canvas -> gx_canvas_display_offset_x, canvas -> gx_canvas_display_offset_y);
+
+    if (_gx_utility_rectangle_overlap_detect(&dirty, &composite -> gx_canvas_dirty_area, &overlap))
+    {
+        width = overlap.gx_rectangle_right - overlap.gx_rectangle_left + 1;
+
+        read = (USHORT *)canvas -> gx_canvas_memory;
+        read += (overlap.gx_rectangle_top - dirty.gx_rectangle_top) * canvas -> gx_canvas_x_resolution;
+        read += overlap.gx_rectangle_left - dirty.gx_rectangle_left;
+
+        write = (USHORT *)composite -> gx_canvas_memory;
+        write += overlap.gx_rectangle_top * composite -> gx_canvas_x_resolution;
+        write += overlap.gx_rectangle_left;
+
+        /* both canvases use the same byte order, no swapping needed */
+        for (row = overlap.gx_rectangle_top; row <= overlap.gx_rectangle_bottom; row++)
+        {
+            for (col = 0; col <= width - NEON_PIXELS * 2; col += NEON_PIXELS * 2)
+            {
+                uint16x8_t q0 = vld1q_u16(read + col);
+                uint16x8_t q1 = vld1q_u16(read + col + NEON_PIXELS);
+
+                vst1q_u16(write + col, q0);
+                vst1q_u16(write + col + NEON_PIXELS, q1);
+            }
+            for (; col < width; col++)
+            {
+                write[col] = read[col];
+            }
+            write += composite -> gx_canvas_x_resolution;
+            read += canvas -> gx_canvas_x_resolution;
+        }
+    }
+}
+
+static VOID _gx_drv_565rgb_neon_pixelmap_row_blend(USHORT *put,
+    GX_CONST USHORT *get, INT width, GX_UBYTE alpha)
+{
+uint16x8_t valpha = vdupq_n_u16(alpha);
+uint16x8_t vbalpha = vdupq_n_u16((GX_UBYTE)(256 - alpha));
+INT        col;
+
+    for (col = 0; col <= width - NEON_PIXELS; col += NEON_PIXELS)
+    {
+        if (alpha == 0xff)
+        {
+            __neon_write_pixels(put + col, vld1q_u16(get + col));
+        }
+        else
+        {
+            __neon_write_pixels(put + col, _gx_drv_565rgb_neon_blend(vld1q_u16(get + col),
+                __neon_read_pixels(put + col), valpha, vbalpha));
+        }
+    }
+    for (; col < width; col++)
+    {
+        if (alpha == 0xff)
+        {
+            __write_pixel(put + col, get[col]);
+        }
+        else
+        {
+            __write_pixel(put + col, _gx_drv_565rgb_blend_color(get[col],
+                __read_pixel(&put[col]), alpha, (GX_UBYTE)(256 - alpha)));
+        }
+    }
+}
+
+static VOID _gx_drv_565rgb_neon_pixelmap_row_alpha_blend(USHORT *put,
+    GX_CONST USHORT *get, GX_CONST GX_UBYTE *getalpha, INT width, GX_UBYTE alpha)
+{
+uint16x8_t combined;
+uint16x8_t fcolor;
+uint16x8_t result;
+INT        col;
+INT        combined_alpha;
+
+    for (col = 0; col <= width - NEON_PIXELS; col += NEON_PIXELS)
+    {
+        /* combined = internal * alpha / 255, exact for products below 65536.
+           A combined alpha of 0 gives a background weight of 256 and leaves
+           the pixel as it was, 255 must copy the foreground unchanged. */
+        combined = vmulq_n_u16(vmovl_u8(vld1_u8(getalpha + col)), alpha);
+        combined = vaddq_u16(combined, vshrq_n_u16(combined, 8));
+        combined = vshrq_n_u16(vaddq_u16(combined, vdupq_n_u16(1)), 8);
+
+        fcolor = vld1q_u16(get + col);
+        result = _gx_drv_565rgb_neon_blend(fcolor, __neon_read_pixels(put + col),
+            combined, vsubq_u16(vdupq_n_u16(256), combined));
+        result = vbslq_u16(vceqq_u16(combined, vdupq_n_u16(0xff)), fcolor, result);
+        __neon_write_pixels(put + col, result);
+    }
+    for (; col < width; col++)
+    {
+        combined_alpha = getalpha[col] * alpha / 255;
+        if (combined_alpha == 0xff)
+        {
+            __write_pixel(put + col, get[col]);
+        }
+        else if (combined_alpha)
+        {
+            __write_pixel(put + col, _gx_drv_565rgb_blend_color(get[col],
+                __read_pixel(&put[col]), (GX_UBYTE)combined_alpha,
+                (GX_UBYTE)(256 - combined_alpha)));
+        }
+    }
+}
+
+static VOID _gx_drv_565rgb_neon_pixelmap_blend(GX_DRAW_CONTEXT *context,
+    INT xpos, INT ypos, GX_PIXELMAP *pixelmap, GX_UBYTE alpha)
+{
+INT                skipcount;
+INT                width;
+INT                yval;
+USHORT            *putrow;
+GX_CONST USHORT   *getrow;
+GX_CONST GX_UBYTE *getrowalpha = GX_NULL;
+
+GX_RECTANGLE      *clip = context -> gx_draw_context_clip;
+
+    /* only uncompressed 565 pixelmaps are handled here */
+    if (pixelmap -> gx_pixelmap_format != GX_COLOR_FORMAT_565RGB ||
+        (pixelmap -> gx_pixelmap_flags & GX_PIXELMAP_COMPRESSED))
+    {
+        _gx_display_driver_565rgb_pixelmap_blend(context, xpos, ypos, pixelmap, alpha);
+        return;
+    }
+
+    if (alpha == 0)
+    {
+        /* Nothing to drawn. Just return. */
+        return;
+    }
+
+    skipcount = (pixelmap -> gx_pixelmap_width) * (clip -> gx_rectangle_top - ypos);
+    skipcount += (clip -> gx_rectangle_left - xpos);
+    getrow = (GX_CONST USHORT *)(pixelmap -> gx_pixelmap_data);
+    getrow += skipcount;
+    if (pixelmap -> gx_pixelmap_flags & GX_PIXELMAP_ALPHA)
+    {
+        getrowalpha = (GX_CONST GX_UBYTE *)(pixelmap -> gx_pixelmap_aux_data);
+        getrowalpha += skipcount;
+    }
+
+    putrow = (USHORT *)context -> gx_draw_context_memory;
+    putrow += context -> gx_draw_context_pitch * clip -> gx_rectangle_top;
+    putrow += clip -> gx_rectangle_left;
+
+    width = clip -> gx_rectangle_right - clip -> gx_rectangle_left + 1;
+    for (yval = clip -> gx_rectangle_top; yval <= clip -> gx_rectangle_bottom; yval++)
+    {
+        if (getrowalpha)
+        {
+            _gx_drv_565rgb_neon_pixelmap_row_alpha_blend(putrow, getrow, getrowalpha, width, alpha);
+            getrowalpha += pixelmap -> gx_pixelmap_width;
+        }
+        else
+        {
+            _gx_drv_565rgb_neon_pixelmap_row_blend(putrow, getrow, width, alpha);
+        }
+        getrow += pixelmap -> gx_pixelmap_width;
+        putrow += context -> gx_draw_context_pitch;
+    }
+}
+
+static VOID _gx_drv_565rgb_neon_setup(GX_DISPLAY *display)
+{
+    display->gx_display_driver_horizontal_line_draw =
+        _gx_drv_16bpp_neon_horizontal_line_draw;
+    display->gx_display_driver_vertical_line_draw =
+        _gx_drv_16bpp_neon_vertical_line_draw;
+    display->gx_display_driver_horizontal_pattern_line_draw =
+        _gx_drv_16bpp_neon_horizontal_pattern_line_draw;
+    display->gx_display_driver_canvas_copy = _gx_drv_16bpp_neon_canvas_copy;
+    display->gx_display_driver_canvas_blend = _gx_drv_565rgb_neon_canvas_blend;
+    display->gx_display_driver_pixelmap_blend = _gx_drv_565rgb_neon_pixelmap_blend;
+}
+#endif /* __ARM_NEON */
+
 VOID guix_rgb565_display_driver_swap_byteorder(GX_DISPLAY *display)
 {
     display->gx_display_driver_simple_line_draw = 
@@ -785,5 +1260,9 @@ VOID guix_rgb565_display_driver_swap_byteorder(GX_DISPLAY *display)
     display->gx_display_driver_pixel_write = _gx_drv_16bpp_pixel_write;
     display->gx_display_driver_canvas_blend = _gx_drv_565rgb_canvas_blend;
     display->gx_display_driver_pixel_blend = _gx_drv_565rgb_pixel_blend;
+#if defined(__ARM_NEON)
+    /* Cortex-A: replace the routines with NEON versions where there is one */
+    _gx_drv_565rgb_neon_setup(display);
+#endif
 }
 
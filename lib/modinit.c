@@ -1,4 +1,5 @@
 #include "base/modinit.h"
+#include "base/boottime.h"
 
 #include <stdio.h>
 
@@ -11,7 +12,9 @@ int _module_init(void)
     int ret = 0;
     
     RTEMS_LINKER_SET_FOREACH(module_app, item) {
+        boottime_t start = boottime_begin();
         ret = item->init();
+        boottime_end(item->name, BOOTTIME_MODULE, start);
         if (ret == MOD_BAD) {
             printf("Warnning***: %s() -> %s() initialize failed.\n", 
                 __func__, item->name);
@@ -29,7 +32,9 @@ void _module_driver_init(void)
     const struct module_operations *item;
     
     RTEMS_LINKER_SET_FOREACH(module_driver, item) {
+        boottime_t start = boottime_begin();
         item->init();
+        boottime_end(item->name, BOOTTIME_MODULE, start);
     }
 }
 
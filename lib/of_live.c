@@ -28,6 +28,24 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
 	return res;
 }
 
+/* Sort a node's property index by interned name pointer (n is small) */
+static void unflatten_sort_props(const struct property *props, u16 *order,
+				 int n)
+{
+	int i, j;
+	u16 idx;
+
+	for (i = 0; i < n; i++)
+		order[i] = i;
+	for (i = 1; i < n; i++) {
+		idx = order[i];
+		for (j = i; j > 0 && (uintptr_t)props[order[j - 1]].name >
+		     (uintptr_t)props[idx].name; j--)
+			order[j] = order[j - 1];
+		order[j] = idx;
+	}
+}
+
 /**
  * unflatten_dt_node() - Alloc and populate a device_node from the flat tree
  * @blob: The parent device tree blob
@@ -38,6 +56,10 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
  * @fpsize: Size of the node path up at t05he current depth.
  * @dryrun: If true, do not allocate device nodes but still calculate needed
  * memory size
+ *
+ * The properties of a node are stored as one array in tree order, with their
+ * names interned and an index sorted by name pointer so that
+ * of_find_property() can bisect it.
  */
 static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			       struct device_node *dad,
@@ -46,8 +68,11 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 {
 	const __be32 *p;
 	struct device_node *np;
-	struct property *pp, **prev_pp = NULL;
+	struct property *pp, *props;
 	const char *pathp;
+	bool sorted = true;
+	u16 *order;
+	int nprops, i;
 	int l;
 	unsigned int allocl;
 	static int depth;
@@ -115,14 +140,27 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		}
 		memcpy(fn, pathp, l);
 
-		prev_pp = &np->properties;
 		if (dad != NULL) {
 			np->parent = dad;
 			np->sibling = dad->child;
 			dad->child = np;
 		}
 	}
+	/* count properties, plus one in case "name" must be made up */
+	nprops = 1;
+	for (offset = fdt_first_property_offset(blob, *poffset);
+	     (offset >= 0);
+	     (offset = fdt_next_property_offset(blob, offset)))
+		nprops++;
+	props = unflatten_dt_alloc(&mem, nprops * sizeof(struct property),
+				   __alignof__(struct property));
+	order = unflatten_dt_alloc(&mem, nprops * sizeof(u16),
+				   __alignof__(u16));
+	if (nprops > U16_MAX)
+		sorted = false;
+
 	/* process properties */
+	i = 0;
 	for (offset = fdt_first_property_offset(blob, *poffset);
 	     (offset >= 0);
 	     (offset = fdt_next_property_offset(blob, offset))) {
@@ -141,8 +179,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		}
 		if (strcmp(pname, "name") == 0)
 			has_name = 1;
-		pp = unflatten_dt_alloc(&mem, sizeof(struct property),
-					__alignof__(struct property));
+		pp = &props[i++];
 		if (!dryrun) {
 			/*
 			 * We accept flattened tree phandles either in
@@ -161,11 +198,13 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			 * stuff */
 			if (strcmp(pname, "ibm,phandle") == 0)
 				np->phandle = be32_to_cpup(p);
-			pp->name = (char *)pname;
+			pp->name = (char *)of_name_intern(pname);
+			if (!pp->name) {
+				pp->name = (char *)pname;
+				sorted = false;
+			}
 			pp->length = sz;
 			pp->value = (__be32 *)p;
-			*prev_pp = pp;
-			prev_pp = &pp->next;
 		}
 	}
 	/*
@@ -174,6 +213,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 	 */
 	if (!has_name) {
 		const char *p1 = pathp, *ps = pathp, *pa = NULL;
+		void *val;
 		int sz;
 
 		while (*p1) {
@@ -186,14 +226,16 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		if (pa < ps)
 			pa = p1;
 		sz = (pa - ps) + 1;
-		pp = unflatten_dt_alloc(&mem, sizeof(struct property) + sz,
-					__alignof__(struct property));
+		pp = &props[i++];
+		val = unflatten_dt_alloc(&mem, sz, 1);
 		if (!dryrun) {
-			pp->name = "name";
+			pp->value = val;
+			pp->name = (char *)of_name_intern("name");
+			if (!pp->name) {
+				pp->name = "name";
+				sorted = false;
+			}
 			pp->length = sz;
-			pp->value = pp + 1;
-			*prev_pp = pp;
-			prev_pp = &pp->next;
 			memcpy(pp->value, ps, sz - 1);
 			((char *)pp->value)[sz - 1] = 0;
 			debug("fixed up name for %s -> %s\n", pathp,
@@ -201,7 +243,12 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		}
 	}
 	if (!dryrun) {
-		*prev_pp = NULL;
+		np->properties = i ? props : NULL;
+		np->prop_count = i;
+		if (sorted) {
+			unflatten_sort_props(props, order, i);
+			np->prop_order = order;
+		}
 		np->name = of_get_property(np, "name", NULL);
 		np->type = of_get_property(np, "device_type", NULL);
 
@@ -248,6 +295,24 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 	return mem;
 }
 
+/*
+ * Count the names in the strings block. Property names are taken from it, so
+ * this bounds the number of distinct names to intern.
+ */
+static unsigned long unflatten_count_names(const void *blob)
+{
+	const char *s = blob + fdt_off_dt_strings(blob);
+	const char *end = s + fdt_size_dt_strings(blob);
+	unsigned long count = 0;
+
+	for (; s < end; s++) {
+		if (!*s)
+			count++;
+	}
+
+	return count;
+}
+
 /**
  * unflatten_device_tree() - create tree of device_nodes from flat blob
  *
@@ -262,9 +327,10 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 static int unflatten_device_tree(const void *blob,
 				 struct device_node **mynodes)
 {
-	unsigned long size;
+	unsigned long size, names;
 	int start;
 	void *mem;
+	int ret;
 
 	debug(" -> unflatten_device_tree()\n");
 
@@ -291,25 +357,39 @@ static int unflatten_device_tree(const void *blob,
 		return -EFAULT;
 	size = ALIGN(size, 4);
 
+	/* Name table at the start of the arena, at most half full */
+	names = 16;
+	while (names < (unflatten_count_names(blob) + 1) * 2)
+		names <<= 1;
+	size += names * sizeof(char *);
+
 	debug("  size is %lx, allocating...\n", size);
 
 	/* Allocate memory for the expanded device tree */
 	mem = rtems_malloc(size + 4);
+	if (!mem)
+		return -ENOMEM;
 	memset(mem, '\0', size);
 
 	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
 
 	debug("  unflattening %p...\n", mem);
+	of_name_table_init(mem, names);
 
 	/* Second pass, do actual unflattening */
 	start = 0;
-	unflatten_dt_node(blob, mem, &start, NULL, mynodes, 0, false);
+	unflatten_dt_node(blob, mem + names * sizeof(char *), &start, NULL,
+			  mynodes, 0, false);
 	if (be32_to_cpup(mem + size) != 0xdeadbeef) {
 		debug("End of tree marker overwritten: %08x\n",
 		      be32_to_cpup(mem + size));
 		return -ENOSPC;
 	}
 
+	ret = of_build_phandle_table(*mynodes);
+	if (ret)
+		debug("No phandle table, lookups walk the tree: %d\n", ret);
+
 	debug(" <- unflatten_device_tree()\n");
 
 	return 0;
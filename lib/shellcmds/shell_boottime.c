@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rtems/shell.h>
+#include <rtems/sysinit.h>
+
+#include "base/boottime.h"
+
+#define BOOTTIME_HELP \
+    "Boot time breakdown\n" \
+    "\n" \
+    "boottime [-s][--sort] [-t][--threshold <us>]\n" \
+    "   [-e][--export]\n"
+
+
+static int shell_main_boottime(int argc, char *argv[])
+{
+    unsigned long min_us = 0;
+    bool by_duration = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--sort") ||
+            !strcmp(argv[i], "-s")) {
+            by_duration = true;
+        } else if ((!strcmp(argv[i], "--threshold") ||
+            !strcmp(argv[i], "-t")) && i + 1 < argc) {
+            min_us = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--export") ||
+            !strcmp(argv[i], "-e")) {
+            boottime_export(stdout);
+            return 0;
+        } else {
+            puts(BOOTTIME_HELP);
+            return -EINVAL;
+        }
+    }
+
+    boottime_dump(by_duration, min_us);
+    return 0;
+}
+
+static void shell_boottime_register(void)
+{
+    static rtems_shell_cmd_t shell_boottime_command = {
+        "boottime",                      /* name */
+        BOOTTIME_HELP,                   /* usage */
+        "rtems",                         /* topic */
+        shell_main_boottime,             /* command */
+        NULL,                            /* aliass */
+        NULL                             /* next */
+    };
+
+    rtems_shell_add_cmd_struct(&shell_boottime_command);
+}
+
+RTEMS_SYSINIT_ITEM(shell_boottime_register,
+    RTEMS_SYSINIT_LAST,
+    RTEMS_SYSINIT_ORDER_MIDDLE);
@@ -0,0 +1,451 @@
+/*
+ * String function benchmark
+ *
+ * Times the string and memory functions the build links in (lib/string.c,
+ * arch/arm/lib or the C library) over short and long buffers, so that
+ * builds with and without use_string_wat/string_neon can be compared. Each
+ * case first checks its result against a byte-by-byte reference and is
+ * reported as FAIL instead of timed if they differ.
+ *
+ * Before timing, every function is also run against plain C references
+ * over all source and destination alignments within a word, lengths up to
+ * a few words (covering every tail length), a difference or terminator at
+ * every position, and bytes with the top bit set, so that signed compares
+ * and misaligned heads and tails are exercised.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rtems/counter.h>
+#include <rtems/shell.h>
+#include <rtems/sysinit.h>
+
+#define STRBENCH_HELP \
+    "String function benchmark\n" \
+    "\n" \
+    "strbench [-n][--loops <count>]\n"
+
+#define STRBENCH_SIZE  4096
+#define STRBENCH_LOOPS 1000
+
+/* Alignments and lengths swept by the verify pass */
+#define STRBENCH_ALIGN   16
+#define STRBENCH_MAXLEN  80
+#define STRBENCH_REPORT  8
+
+struct strbench_ctx {
+    char *a;
+    char *b;
+    size_t len;
+};
+
+typedef size_t (*strbench_fn)(struct strbench_ctx *ctx);
+
+static size_t ref_strlen(const char *s)
+{
+    size_t n = 0;
+
+    while (s[n])
+        n++;
+    return n;
+}
+
+static int ref_memcmp(const void *a, const void *b, size_t len)
+{
+    const unsigned char *pa = a, *pb = b;
+
+    for (; len; len--, pa++, pb++)
+        if (*pa != *pb)
+            return *pa - *pb;
+    return 0;
+}
+
+static int ref_strcmp(const char *a, const char *b)
+{
+    const unsigned char *pa = (const unsigned char *)a;
+    const unsigned char *pb = (const unsigned char *)b;
+
+    while (*pa && *pa == *pb)
+        pa++, pb++;
+    return *pa - *pb;
+}
+
+static const void *ref_memchr(const void *s, int c, size_t len)
+{
+    const unsigned char *p = s;
+
+    for (; len; len--, p++)
+        if (*p == (unsigned char)c)
+            return p;
+    return NULL;
+}
+
+static const char *ref_strchr(const char *s, int c)
+{
+    for (;; s++) {
+        if (*s == (char)c)
+            return s;
+        if (!*s)
+            return NULL;
+    }
+}
+
+static size_t bench_memcpy(struct strbench_ctx *ctx)
+{
+    memcpy(ctx->b, ctx->a, ctx->len);
+    return ctx->len;
+}
+
+static size_t check_memcpy(struct strbench_ctx *ctx)
+{
+    size_t i;
+
+    memset(ctx->b, 0, ctx->len);
+    bench_memcpy(ctx);
+    for (i = 0; i < ctx->len; i++)
+        if (ctx->b[i] != ctx->a[i])
+            return 0;
+    return ctx->len;
+}
+
+static size_t bench_memmove(struct strbench_ctx *ctx)
+{
+    /* Overlapping, destination above source: the backward case */
+    memmove(ctx->b + 1, ctx->b, ctx->len);
+    return ctx->len;
+}
+
+static size_t check_memmove(struct strbench_ctx *ctx)
+{
+    size_t i;
+
+    bench_memmove(ctx);
+    for (i = 0; i < ctx->len; i++)
+        if (ctx->b[i + 1] != ctx->a[i])
+            return 0;
+    return ctx->len;
+}
+
+static size_t bench_memset(struct strbench_ctx *ctx)
+{
+    memset(ctx->b, 0x5a, ctx->len);
+    return ctx->len;
+}
+
+static size_t check_memset(struct strbench_ctx *ctx)
+{
+    size_t i;
+
+    bench_memset(ctx);
+    for (i = 0; i < ctx->len; i++)
+        if (ctx->b[i] != 0x5a)
+            return 0;
+    return ctx->len;
+}
+
+static size_t bench_memcmp(struct strbench_ctx *ctx)
+{
+    return memcmp(ctx->a, ctx->b, ctx->len) ? 0 : ctx->len;
+}
+
+static size_t bench_memchr(struct strbench_ctx *ctx)
+{
+    const char *p = memchr(ctx->a, '\0', ctx->len + 1);
+
+    return p ? (size_t)(p - ctx->a) : 0;
+}
+
+static size_t bench_strlen(struct strbench_ctx *ctx)
+{
+    return strlen(ctx->a);
+}
+
+static size_t bench_strcmp(struct strbench_ctx *ctx)
+{
+    return strcmp(ctx->a, ctx->b) ? 0 : ctx->len;
+}
+
+static size_t bench_strchr(struct strbench_ctx *ctx)
+{
+    const char *p = strchr(ctx->a, '\0');
+
+    return p - ctx->a;
+}
+
+static const struct {
+    const char *name;
+    strbench_fn fn;
+    /* Runs the case once and checks the result, returns len if correct */
+    strbench_fn check;
+    /* a and b hold the same string of len bytes before the case */
+    bool same;
+} strbench_cases[] = {
+    { "memcpy",  bench_memcpy,  check_memcpy,  false },
+    { "memmove", bench_memmove, check_memmove, true },
+    { "memset",  bench_memset,  check_memset,  false },
+    { "memcmp",  bench_memcmp,  bench_memcmp,  true },
+    { "memchr",  bench_memchr,  bench_memchr,  false },
+    { "strlen",  bench_strlen,  bench_strlen,  false },
+    { "strcmp",  bench_strcmp,  bench_strcmp,  true },
+    { "strchr",  bench_strchr,  bench_strchr,  false },
+};
+
+static const size_t strbench_lens[] = { 15, 64, 256, STRBENCH_SIZE - 1 };
+
+struct strbench_verify {
+    unsigned int cases;
+    unsigned int failures;
+};
+
+static int strbench_sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+static void strbench_fail(struct strbench_verify *v, const char *name,
+    size_t sa, size_t da, size_t len, size_t pos)
+{
+    if (v->failures++ < STRBENCH_REPORT)
+        printf("verify: %s src+%zu dst+%zu len %zu pos %zu FAIL\n",
+            name, sa, da, len, pos);
+}
+
+/* Pattern with bytes on both sides of 0x80 and no zero */
+static unsigned char strbench_byte(size_t i)
+{
+    return 1 + (i * 167) % 255;
+}
+
+static void strbench_verify_mem(struct strbench_verify *v, char *a, char *b,
+    size_t sa, size_t da, size_t len)
+{
+    unsigned char *src = (unsigned char *)a + sa;
+    /* Guard bytes on both sides of the destination */
+    unsigned char *dst = (unsigned char *)b + STRBENCH_ALIGN + da;
+    size_t i, pos;
+
+    /* memcpy: exact bytes, nothing written around the destination */
+    for (i = 0; i < len; i++)
+        src[i] = strbench_byte(i);
+    memset(b, 0xee, STRBENCH_ALIGN * 3 + STRBENCH_MAXLEN);
+    memcpy(dst, src, len);
+    v->cases++;
+    if (ref_memcmp(dst, src, len) || dst[-1] != 0xee || dst[len] != 0xee)
+        strbench_fail(v, "memcpy", sa, da, len, 0);
+
+    /* memset: with a value which has the top bit set */
+    memset(b, 0x11, STRBENCH_ALIGN * 3 + STRBENCH_MAXLEN);
+    memset(dst, 0xa5, len);
+    v->cases++;
+    for (i = 0; i < len && dst[i] == 0xa5; i++)
+        ;
+    if (i != len || dst[-1] != 0x11 || dst[len] != 0x11)
+        strbench_fail(v, "memset", sa, da, len, i);
+
+    /* memmove: overlapping, both directions, offset by the alignments */
+    for (i = 0; i < STRBENCH_ALIGN * 2 + STRBENCH_MAXLEN; i++)
+        b[i] = strbench_byte(i);
+    memmove(b + da, b + sa, len);
+    v->cases++;
+    for (i = 0; i < len; i++)
+        if ((unsigned char)b[da + i] != strbench_byte(sa + i))
+            break;
+    if (i != len)
+        strbench_fail(v, "memmove", sa, da, len, i);
+
+    /* memcmp: equal, then one byte raised or lowered at each position */
+    for (i = 0; i < len; i++)
+        src[i] = dst[i] = strbench_byte(i);
+    v->cases++;
+    if (memcmp(dst, src, len))
+        strbench_fail(v, "memcmp", sa, da, len, len);
+    for (pos = 0; pos < len; pos++) {
+        unsigned char save = dst[pos];
+
+        dst[pos] = save ^ 0x80;
+        v->cases++;
+        if (strbench_sign(memcmp(dst, src, len)) !=
+            strbench_sign(ref_memcmp(dst, src, len)))
+            strbench_fail(v, "memcmp", sa, da, len, pos);
+        dst[pos] = save;
+    }
+
+    /* memchr: the first match at each position, and no match */
+    for (pos = 0; pos <= len; pos++) {
+        for (i = 0; i < len; i++)
+            src[i] = 0x80 | (i & 0x3f);
+        if (pos < len)
+            src[pos] = 0x7f;
+        v->cases++;
+        if (memchr(src, 0x7f, len) != ref_memchr(src, 0x7f, len))
+            strbench_fail(v, "memchr", sa, da, len, pos);
+    }
+}
+
+static void strbench_verify_str(struct strbench_verify *v, char *a, char *b,
+    size_t sa, size_t da, size_t len)
+{
+    char *s1 = a + sa;
+    char *s2 = b + da;
+    size_t i, pos;
+
+    for (i = 0; i < len; i++)
+        s1[i] = s2[i] = strbench_byte(i);
+    s1[len] = s2[len] = '\0';
+    /* Non-zero bytes after the terminator must not be looked at */
+    memset(s1 + len + 1, 0x5a, STRBENCH_ALIGN);
+    memset(s2 + len + 1, 0xa5, STRBENCH_ALIGN);
+
+    v->cases++;
+    if (strlen(s1) != len)
+        strbench_fail(v, "strlen", sa, da, len, len);
+    v->cases++;
+    if (strcmp(s1, s2))
+        strbench_fail(v, "strcmp", sa, da, len, len);
+    v->cases++;
+    if (strchr(s1, '\0') != s1 + len || strchr(s1, 0x5a) != ref_strchr(s1, 0x5a))
+        strbench_fail(v, "strchr", sa, da, len, len);
+
+    for (pos = 0; pos < len; pos++) {
+        char save = s2[pos];
+
+        /* Differ at pos, flipping the top bit so the sign matters */
+        s2[pos] = save ^ 0x80;
+        v->cases++;
+        if (strbench_sign(strcmp(s1, s2)) !=
+            strbench_sign(ref_strcmp(s1, s2)) ||
+            strbench_sign(strcmp(s2, s1)) !=
+            strbench_sign(ref_strcmp(s2, s1)))
+            strbench_fail(v, "strcmp", sa, da, len, pos);
+
+        /* One string ends at pos */
+        s2[pos] = '\0';
+        v->cases++;
+        if (strbench_sign(strcmp(s1, s2)) !=
+            strbench_sign(ref_strcmp(s1, s2)) || strlen(s2) != pos)
+            strbench_fail(v, "strcmp", sa, da, len, pos);
+        s2[pos] = save;
+
+        /* A match at pos, with the top bit set */
+        s1[pos] = (char)0xff;
+        v->cases++;
+        if (strchr(s1, 0xff) != ref_strchr(s1, 0xff))
+            strbench_fail(v, "strchr", sa, da, len, pos);
+        s1[pos] = save;
+    }
+}
+
+static bool strbench_verify(struct strbench_ctx *ctx)
+{
+    struct strbench_verify v = { 0, 0 };
+    size_t sa, da, len;
+
+    for (sa = 0; sa < STRBENCH_ALIGN; sa++) {
+        for (da = 0; da < STRBENCH_ALIGN; da++) {
+            for (len = 0; len <= STRBENCH_MAXLEN; len++) {
+                strbench_verify_mem(&v, ctx->a, ctx->b, sa, da, len);
+                strbench_verify_str(&v, ctx->a, ctx->b, sa, da, len);
+            }
+        }
+    }
+    printf("verify: %u cases, %u failed\n\n", v.cases, v.failures);
+    return v.failures == 0;
+}
+
+static void strbench_fill(struct strbench_ctx *ctx, bool same)
+{
+    size_t i;
+
+    for (i = 0; i < ctx->len; i++)
+        ctx->a[i] = 'a' + i % 26;
+    ctx->a[ctx->len] = '\0';
+    if (same)
+        memcpy(ctx->b, ctx->a, ctx->len + 1);
+}
+
+static void strbench_run(struct strbench_ctx *ctx, unsigned int loops)
+{
+    rtems_counter_ticks start, ticks;
+    unsigned int c, l, i;
+    uint64_t ns;
+
+    printf("%-8s %6s %10s %10s\n", "Function", "Bytes", "ns/call", "MB/s");
+    for (c = 0; c < sizeof(strbench_cases) / sizeof(strbench_cases[0]); c++) {
+        for (l = 0; l < sizeof(strbench_lens) / sizeof(strbench_lens[0]); l++) {
+            ctx->len = strbench_lens[l];
+            strbench_fill(ctx, strbench_cases[c].same);
+            if (strbench_cases[c].check(ctx) != ctx->len ||
+                ref_strlen(ctx->a) != ctx->len) {
+                printf("%-8s %6zu %10s\n", strbench_cases[c].name,
+                    ctx->len, "FAIL");
+                continue;
+            }
+
+            strbench_fill(ctx, strbench_cases[c].same);
+            start = rtems_counter_read();
+            for (i = 0; i < loops; i++)
+                strbench_cases[c].fn(ctx);
+            ticks = rtems_counter_difference(rtems_counter_read(), start);
+
+            ns = rtems_counter_ticks_to_nanoseconds(ticks) / loops;
+            printf("%-8s %6zu %10llu %10llu\n", strbench_cases[c].name,
+                ctx->len, (unsigned long long)ns,
+                ns ? (unsigned long long)(ctx->len * 1000 / ns) : 0ULL);
+        }
+    }
+}
+
+static int shell_main_strbench(int argc, char *argv[])
+{
+    struct strbench_ctx ctx;
+    unsigned int loops = STRBENCH_LOOPS;
+
+    for (int i = 1; i < argc; i++) {
+        if ((!strcmp(argv[i], "--loops") ||
+            !strcmp(argv[i], "-n")) && i + 1 < argc) {
+            loops = strtoul(argv[++i], NULL, 0);
+        } else {
+            puts(STRBENCH_HELP);
+            return -EINVAL;
+        }
+    }
+    if (loops == 0)
+        loops = 1;
+
+    /* Spare byte in b for the overlapping memmove case */
+    ctx.a = malloc(STRBENCH_SIZE);
+    ctx.b = malloc(STRBENCH_SIZE + 1);
+    if (!ctx.a || !ctx.b) {
+        free(ctx.a);
+        free(ctx.b);
+        return -ENOMEM;
+    }
+
+    strbench_verify(&ctx);
+    strbench_run(&ctx, loops);
+
+    free(ctx.a);
+    free(ctx.b);
+    return 0;
+}
+
+static void shell_strbench_register(void)
+{
+    static rtems_shell_cmd_t shell_strbench_command = {
+        "strbench",                      /* name */
+        STRBENCH_HELP,                   /* usage */
+        "rtems",                         /* topic */
+        shell_main_strbench,             /* command */
+        NULL,                            /* aliass */
+        NULL                             /* next */
+    };
+
+    rtems_shell_add_cmd_struct(&shell_strbench_command);
+}
+
+RTEMS_SYSINIT_ITEM(shell_strbench_register,
+    RTEMS_SYSINIT_LAST,
+    RTEMS_SYSINIT_ORDER_MIDDLE);
@@ -42,6 +42,37 @@ do {\
 } while (0)
 #endif
 
+/*
+ * Word-at-a-time helpers, prefixed so as not to clash with the Linux
+ * <asm/word-at-a-time.h> API used by strscpy(). wat_has_zero() is non-zero
+ * when a word holds a zero byte; on little-endian its lowest set bit is in
+ * that first zero byte, so wat_zero_index() gives its position. Higher bits
+ * may be false positives. Aligned word loads never cross a page, so reading
+ * past the terminator of a string is safe.
+ */
+#if defined(CONFIG_STRING_WORD_AT_A_TIME) && defined(__LITTLE_ENDIAN)
+#define STRING_WAT
+#define WAT_SIZE	sizeof(unsigned long)
+#define WAT_MASK	(WAT_SIZE - 1)
+
+typedef unsigned long __attribute__((__may_alias__)) wat_t;
+
+static inline unsigned long wat_has_zero(unsigned long w)
+{
+	return (w - REPEAT_BYTE(0x01)) & ~w & REPEAT_BYTE(0x80);
+}
+
+static inline unsigned int wat_zero_index(unsigned long z)
+{
+	return __builtin_ctzl(z) >> 3;
+}
+
+static inline bool wat_aligned(const void *p)
+{
+	return !((uintptr_t)p & WAT_MASK);
+}
+#endif
+
 #ifndef __HAVE_ARCH_STRNCASECMP
 /**
  * strncasecmp - Case insensitive, length-limited string comparison
@@ -368,6 +399,24 @@ int strcmp(const char *cs, const char *ct)
 {
 	unsigned char c1, c2;
 
+#ifdef STRING_WAT
+	/* Compare whole words while neither differs nor ends the string */
+	if (wat_aligned((void *)((uintptr_t)cs ^ (uintptr_t)ct))) {
+		for (; !wat_aligned(cs); cs++, ct++) {
+			c1 = *cs;
+			c2 = *ct;
+			if (c1 != c2)
+				return c1 < c2 ? -1 : 1;
+			if (!c1)
+				return 0;
+		}
+		while (*(const wat_t *)cs == *(const wat_t *)ct &&
+		       !wat_has_zero(*(const wat_t *)cs)) {
+			cs += WAT_SIZE;
+			ct += WAT_SIZE;
+		}
+	}
+#endif
 	while (1) {
 		c1 = *cs++;
 		c2 = *ct++;
@@ -433,6 +482,18 @@ EXPORT_SYMBOL(strchr);
  */
 char *strchrnul(const char *s, int c)
 {
+#ifdef STRING_WAT
+	unsigned long pat = REPEAT_BYTE((unsigned char)c);
+	const wat_t *w;
+
+	for (; !wat_aligned(s); ++s)
+		if (*s == (char)c || *s == '\0')
+			return (char *)s;
+	for (w = (const wat_t *)s;
+	     !(wat_has_zero(*w) | wat_has_zero(*w ^ pat)); w++)
+		;
+	s = (const char *)w;
+#endif
 	while (*s && *s != (char)c)
 		s++;
 	return (char *)s;
@@ -523,10 +584,21 @@ EXPORT_SYMBOL(strim);
 size_t strlen(const char *s)
 {
 	const char *sc;
-
+#ifdef STRING_WAT
+	const wat_t *w;
+	unsigned long z;
+
+	for (sc = s; !wat_aligned(sc); ++sc)
+		if (*sc == '\0')
+			return sc - s;
+	for (w = (const wat_t *)sc; !(z = wat_has_zero(*w)); w++)
+		/* nothing */;
+	return (const char *)w - s + wat_zero_index(z);
+#else
 	for (sc = s; *sc != '\0'; ++sc)
 		/* nothing */;
 	return sc - s;
+#endif
 }
 EXPORT_SYMBOL(strlen);
 #endif
@@ -540,9 +612,24 @@ EXPORT_SYMBOL(strlen);
 size_t strnlen(const char *s, size_t count)
 {
 	const char *sc;
-
+#ifdef STRING_WAT
+	const wat_t *w;
+	unsigned long z;
+
+	for (sc = s; count && !wat_aligned(sc); ++sc, count--)
+		if (*sc == '\0')
+			return sc - s;
+	for (w = (const wat_t *)sc; count >= WAT_SIZE; w++, count -= WAT_SIZE) {
+		z = wat_has_zero(*w);
+		if (z)
+			return (const char *)w - s + wat_zero_index(z);
+	}
+	for (sc = (const char *)w; count-- && *sc != '\0'; ++sc)
+		/* nothing */;
+#else
 	for (sc = s; count-- && *sc != '\0'; ++sc)
 		/* nothing */;
+#endif
 	return sc - s;
 }
 EXPORT_SYMBOL(strnlen);
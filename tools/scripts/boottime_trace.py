@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+#
+# Convert the output of the target's 'boottime -e' shell command into a
+# Chrome trace (load it in chrome://tracing or https://ui.perfetto.dev).
+#
+#   boottime_trace.py console.log -o boot.json
+#
+
+import argparse
+import json
+import sys
+
+
+def parse(lines):
+  events = []
+  inside = False
+  for line in lines:
+    line = line.strip()
+    if line.startswith('# boottime'):
+      events = []
+      inside = True
+      continue
+    if line == '# end':
+      inside = False
+      continue
+    if not inside or not line:
+      continue
+    fields = line.split(' ', 4)
+    if len(fields) != 5:
+      continue
+    kind, cpu, begin, duration, name = fields
+    events.append({
+      'name': name,
+      'cat': kind,
+      'ph': 'X',
+      'pid': 0,
+      'tid': int(cpu),
+      'ts': int(begin) / 1000.0,
+      'dur': int(duration) / 1000.0,
+    })
+  return events
+
+
+def main():
+  parser = argparse.ArgumentParser()
+  parser.add_argument('input',
+                      help='Console log holding the boottime -e output',
+                      metavar='FILE')
+  parser.add_argument('-o', '--output',
+                      help='Chrome trace file (default: stdout)',
+                      metavar='FILE')
+  args = parser.parse_args()
+
+  with open(args.input) as f:
+    events = parse(f)
+  if not events:
+    sys.stderr.write('No boottime export found in %s\n' % args.input)
+    return 1
+
+  trace = {'traceEvents': events, 'displayTimeUnit': 'ms'}
+  if args.output:
+    with open(args.output, 'w') as f:
+      json.dump(trace, f)
+  else:
+    json.dump(trace, sys.stdout)
+  return 0
+
+if __name__ == "__main__":
+  sys.exit(main())
@@ -0,0 +1,482 @@
+#!/usr/bin/env python
+#
+# Device tree to C (of-platdata) generator
+#
+# Compiles the board's .dts, then writes the driver_info records and the
+# struct dtd_* platform data for every enabled node that has a driver, so
+# that a CONFIG_OF_PLATDATA image binds its devices without an FDT:
+#
+#   generated/dt-structs-gen.h  struct dtd_<compatible> definitions
+#   generated/dt-decl.h         declarations of the driver_info records
+#   dt-plat.c                   platform data and U_BOOT_DRVINFO() records
+#
+# Drivers are matched by scanning the sources for U_BOOT_DRIVER()/DM_DRIVER()
+# blocks and their .of_match tables, so no extra metadata is needed.
+#
+
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+FDT_MAGIC = 0xd00dfeed
+FDT_BEGIN_NODE = 1
+FDT_END_NODE = 2
+FDT_PROP = 3
+FDT_NOP = 4
+FDT_END = 9
+
+# Properties the driver model handles itself or which make no sense in C
+SKIP_PROPS = ('compatible', 'status', 'phandle', 'linux,phandle', 'name')
+
+# Phandle lists, written as struct phandle_<n>_arg arrays, and the property
+# of the target node giving the number of argument cells
+PHANDLE_PROPS = {'clocks': '#clock-cells'}
+
+TYPE_BOOL = 0
+TYPE_INT = 1
+TYPE_STRING = 2
+TYPE_BYTE = 3
+TYPE_PHANDLE = 4
+
+HEADER = '''/*
+ * DO NOT MODIFY
+ *
+ * %s
+ * This was generated by dtoc from %s
+ */
+'''
+
+
+class Prop(object):
+  def __init__(self, name, value):
+    self.name = name
+    self.value = value
+    self.type, self.count = self.classify(value)
+
+  @staticmethod
+  def classify(value):
+    if not value:
+      return TYPE_BOOL, 1
+    if value[-1:] == b'\0':
+      strings = value[:-1].split(b'\0')
+      if all(s and all(32 <= c < 127 for c in bytearray(s)) for s in strings):
+        return TYPE_STRING, len(strings)
+    if len(value) % 4 == 0:
+      return TYPE_INT, len(value) // 4
+    return TYPE_BYTE, len(value)
+
+  def strings(self):
+    return [s.decode('ascii') for s in self.value[:-1].split(b'\0')]
+
+  def cells(self):
+    return struct.unpack('>%dI' % (len(self.value) // 4), self.value)
+
+
+class Node(object):
+  def __init__(self, name, parent):
+    self.name = name
+    self.parent = parent
+    self.props = {}
+    self.order = []
+    self.subnodes = []
+    self.driver = None
+    self.compat = None
+    self.var = None
+    self.idx = -1
+    self.parent_node = None
+
+  def path(self):
+    if self.parent is None:
+      return '/'
+    base = self.parent.path()
+    return base + ('' if base == '/' else '/') + self.name
+
+
+def parse_dtb(data):
+  (magic, _, off_struct, off_strings, _, version) = \
+      struct.unpack('>6I', data[:24])
+  if magic != FDT_MAGIC:
+    raise ValueError('not a device tree blob')
+  if version < 16:
+    raise ValueError('dtb version %d is too old' % version)
+
+  def string_at(off):
+    end = data.index(b'\0', off_strings + off)
+    return data[off_strings + off:end].decode('ascii')
+
+  pos = off_struct
+  root = None
+  node = None
+  while True:
+    (token,) = struct.unpack('>I', data[pos:pos + 4])
+    pos += 4
+    if token == FDT_BEGIN_NODE:
+      end = data.index(b'\0', pos)
+      name = data[pos:end].decode('ascii')
+      pos = (end + 4) & ~3
+      child = Node(name, node)
+      if node is None:
+        root = child
+      else:
+        node.subnodes.append(child)
+      node = child
+    elif token == FDT_END_NODE:
+      node = node.parent
+    elif token == FDT_PROP:
+      (length, nameoff) = struct.unpack('>2I', data[pos:pos + 8])
+      pos += 8
+      name = string_at(nameoff)
+      node.props[name] = Prop(name, data[pos:pos + length])
+      node.order.append(name)
+      pos = (pos + length + 3) & ~3
+    elif token == FDT_NOP:
+      continue
+    elif token == FDT_END:
+      break
+    else:
+      raise ValueError('bad token %d at %#x' % (token, pos - 4))
+  return root
+
+
+def read_make_deps(path):
+  """Return the prerequisites listed in a make rule written by cpp -MD"""
+  with open(path) as f:
+    text = f.read().replace('\\\n', ' ')
+  return text.split(':', 1)[1].split()
+
+
+def compile_dts(dts, includes, deps):
+  with tempfile.TemporaryDirectory(prefix='dtoc') as tmpdir:
+    pre = os.path.join(tmpdir, 'board.dts.tmp')
+    dtb = os.path.join(tmpdir, 'board.dtb')
+    dep = os.path.join(tmpdir, 'board.d')
+    dtc_dep = os.path.join(tmpdir, 'board.dtb.d')
+    cpp = ['cpp', '-nostdinc', '-undef', '-D__DTS__',
+           '-x', 'assembler-with-cpp', '-MD', '-MF', dep, '-MT', 'board']
+    dtc = ['dtc', '-I', 'dts', '-O', 'dtb', '-o', dtb, '-d', dtc_dep]
+    for inc in includes:
+      cpp += ['-I', inc]
+      dtc += ['-i', inc]
+    subprocess.check_call(cpp + ['-o', pre, dts])
+    subprocess.check_call(dtc + [pre])
+    deps.extend(read_make_deps(dep))
+    # dtc's /include/ files; the preprocessed input itself is not a source
+    deps.extend(p for p in read_make_deps(dtc_dep) if p != pre)
+    with open(dtb, 'rb') as f:
+      return f.read()
+
+
+def scan_drivers(dirs, deps):
+  """Map each compatible string to the name of the driver handling it"""
+  id_re = re.compile(r'struct\s+udevice_id\s+(\w+)\s*\[\s*\]\s*=\s*\{(.*?)\};',
+                     re.S)
+  drv_re = re.compile(r'(?:U_BOOT|DM)_DRIVER\s*\(\s*\w+\s*\)\s*=\s*'
+                      r'\{(.*?)\n\};', re.S)
+  compat_re = re.compile(r'\.compatible\s*=\s*"([^"]+)"')
+  match_re = re.compile(r'\.of_match\s*=\s*(?:of_match_ptr\s*\(\s*)?(\w+)')
+  name_re = re.compile(r'\.name\s*=\s*"([^"]+)"')
+
+  compats = {}
+  for top in dirs:
+    for dirpath, _, files in os.walk(top):
+      for fname in sorted(files):
+        if not fname.endswith('.c'):
+          continue
+        path = os.path.join(dirpath, fname)
+        deps.append(path)
+        with open(path, errors='replace') as f:
+          src = f.read()
+        tables = dict((m.group(1), compat_re.findall(m.group(2)))
+                      for m in id_re.finditer(src))
+        for m in drv_re.finditer(src):
+          body = m.group(1)
+          name = name_re.search(body)
+          match = match_re.search(body)
+          if not name or not match or match.group(1) not in tables:
+            continue
+          for compat in tables[match.group(1)]:
+            compats.setdefault(compat, name.group(1))
+  return compats
+
+
+def conv_name(name):
+  return re.sub(r'[^A-Za-z0-9_]', '_', name)
+
+
+def enabled(node):
+  status = node.props.get('status')
+  return status is None or status.strings()[0] in ('okay', 'ok')
+
+
+def select_nodes(root, compats, warn):
+  """Pick the nodes to instantiate, in linker list order"""
+  nodes = []
+  used = set()
+
+  def walk(node, parent):
+    if not enabled(node):
+      return
+    if node.parent is not None and 'compatible' in node.props:
+      for compat in node.props['compatible'].strings():
+        if compat in compats:
+          node.compat = compat
+          node.driver = compats[compat]
+          break
+      if node.driver is None and warn:
+        sys.stderr.write('dtoc: no driver for %s (%s)\n' %
+                         (node.path(), node.props['compatible'].strings()[0]))
+    if node.driver is not None:
+      var = conv_name(node.name)
+      base, n = var, 1
+      while var in used:
+        n += 1
+        var = '%s_%d' % (base, n)
+      used.add(var)
+      node.var = var
+      node.parent_node = parent
+      nodes.append(node)
+      parent = node
+    for sub in node.subnodes:
+      walk(sub, parent)
+
+  walk(root, None)
+
+  # The linker sorts the driver_info records by name, and parent_idx and
+  # phandle indexes refer to that order
+  nodes.sort(key=lambda node: node.var)
+  for idx, node in enumerate(nodes):
+    node.idx = idx
+  for node in nodes:
+    node.parent_idx = node.parent_node.idx if node.parent_node else -1
+  return nodes
+
+
+def find_phandles(root):
+  """Map each phandle value to its node"""
+  phandles = {}
+
+  def walk(node):
+    for pname in ('phandle', 'linux,phandle'):
+      if pname in node.props:
+        phandles[node.props[pname].cells()[0]] = node
+    for sub in node.subnodes:
+      walk(sub)
+
+  walk(root)
+  return phandles
+
+
+def parse_phandles(node, pname, phandles, warn):
+  """Split a phandle list into (target index, argument cells) entries
+
+  A target without a driver gets index -1, which device_get_by_ofplat_idx()
+  rejects.
+  """
+  cells = node.props[pname].cells()
+  entries = []
+  pos = 0
+  while pos < len(cells):
+    target = phandles.get(cells[pos])
+    if target is None:
+      raise ValueError('%s: %s: no node for phandle %#x' %
+                       (node.path(), pname, cells[pos]))
+    nargs_prop = target.props.get(PHANDLE_PROPS[pname])
+    nargs = nargs_prop.cells()[0] if nargs_prop else 0
+    if target.driver is None and warn:
+      sys.stderr.write('dtoc: %s: %s: %s has no driver\n' %
+                       (node.path(), pname, target.path()))
+    entries.append((target.idx, cells[pos + 1:pos + 1 + nargs]))
+    pos += 1 + nargs
+  return entries
+
+
+def build_structs(nodes, phandles, warn):
+  """Work out the fields of each struct dtd_* across all its nodes"""
+  structs = {}
+  for node in nodes:
+    fields = structs.setdefault(node.compat, {})
+    for pname in node.order:
+      if pname in SKIP_PROPS or pname.startswith('#') or \
+         pname.startswith('u-boot,'):
+        continue
+      prop = node.props[pname]
+      old = fields.get(pname)
+      if pname in PHANDLE_PROPS:
+        prop.entries = parse_phandles(node, pname, phandles, warn)
+        nargs = max(len(args) for _, args in prop.entries)
+        if nargs > 2:
+          raise ValueError('%s: %s: %d argument cells are not supported' %
+                           (node.path(), pname, nargs))
+        if old is not None:
+          nargs = max(nargs, old[2])
+          count = max(len(prop.entries), old[1])
+        else:
+          count = len(prop.entries)
+        fields[pname] = (TYPE_PHANDLE, count, nargs)
+        continue
+      if old is None:
+        fields[pname] = (prop.type, prop.count, len(prop.value))
+      elif old[0] != prop.type:
+        # Mixed encodings, fall back to raw bytes
+        size = max(old[2], len(prop.value))
+        fields[pname] = (TYPE_BYTE, size, size)
+      else:
+        fields[pname] = (old[0], max(old[1], prop.count),
+                         max(old[2], len(prop.value)))
+  return structs
+
+
+def c_type(ftype, count, size):
+  if ftype == TYPE_PHANDLE:
+    return 'struct phandle_%d_arg' % size, '[%d]' % count
+  if ftype == TYPE_BOOL:
+    return 'bool', ''
+  if ftype == TYPE_STRING:
+    return 'const char *', '[%d]' % count if count > 1 else ''
+  if ftype == TYPE_INT:
+    return 'fdt32_t', '[%d]' % count if count > 1 else ''
+  return 'unsigned char', '[%d]' % count
+
+
+def c_value(prop, ftype, count):
+  if ftype == TYPE_PHANDLE:
+    vals = ['{%d, {%s}}' % (idx, ', '.join('0x%x' % a for a in args))
+            for idx, args in prop.entries]
+    return '{' + ', '.join(vals) + '}'
+  if ftype == TYPE_BOOL:
+    return 'true'
+  if ftype == TYPE_STRING:
+    vals = ['"%s"' % s for s in prop.strings()]
+  elif ftype == TYPE_INT:
+    vals = ['0x%x' % v for v in prop.cells()]
+  else:
+    vals = ['0x%02x' % c for c in bytearray(prop.value)]
+  if ftype != TYPE_BYTE and count == 1:
+    return vals[0]
+  return '{' + ', '.join(vals) + '}'
+
+
+def write_structs(structs, source):
+  out = [HEADER % ('Defines the structs used to hold devicetree data.', source)]
+  out.append('#include <stdbool.h>\n#include <linux/libfdt.h>\n')
+  for compat in sorted(structs):
+    out.append('struct dtd_%s {' % conv_name(compat))
+    for pname in sorted(structs[compat]):
+      ftype, count, size = structs[compat][pname]
+      ctype, dim = c_type(ftype, count, size)
+      out.append('\t%s\t%s%s;' % (ctype, conv_name(pname), dim))
+    out.append('};\n')
+  return '\n'.join(out)
+
+
+def write_decl(nodes, source):
+  out = [HEADER % ('Declares the driver_info records for all devices.',
+                   source)]
+  out.append('#include <dm/platdata.h>\n')
+  for node in nodes:
+    out.append('extern struct driver_info _rtems_list_2_driver_info_2_%s;' %
+               node.var)
+  return '\n'.join(out) + '\n'
+
+
+def write_plat(nodes, structs, source):
+  out = [HEADER % ('Declares the U_BOOT_DRVINFO() records and platform data.',
+                   source)]
+  out.append('#define DT_PLAT_C\n')
+  out.append('#include <common.h>\n#include <dm/device.h>\n'
+             '#include <dt-structs.h>\n')
+  for node in nodes:
+    sname = conv_name(node.compat)
+    fields = structs[node.compat]
+    out.append('/*\n * Node %s index %d\n * driver %s parent %s\n */' %
+               (node.path(), node.idx, node.driver,
+                'None' if node.parent_idx < 0 else
+                nodes[node.parent_idx].var))
+    out.append('static struct dtd_%s dtv_%s = {' % (sname, node.var))
+    for pname in sorted(fields):
+      if pname not in node.props:
+        continue
+      ftype, count, _ = fields[pname]
+      out.append('\t.%s\t\t= %s,' % (conv_name(pname),
+                                     c_value(node.props[pname], ftype, count)))
+    out.append('};')
+    out.append('U_BOOT_DRVINFO(%s) = {' % node.var)
+    out.append('\t.name\t\t= "%s",' % node.driver)
+    out.append('\t.plat\t\t= &dtv_%s,' % node.var)
+    out.append('\t.plat_size\t= sizeof(dtv_%s),' % node.var)
+    out.append('\t.parent_idx\t= %d,' % node.parent_idx)
+    out.append('};\n')
+  return '\n'.join(out)
+
+
+def write_file(path, text):
+  with open(path, 'w') as f:
+    f.write(text)
+
+
+def write_depfile(path, target, deps):
+  """Write a make rule so the build reruns dtoc when an input changes"""
+  escape = lambda p: p.replace(' ', '\\ ')
+  with open(path, 'w') as f:
+    f.write('%s: \\\n' % escape(target))
+    f.write(' \\\n'.join('  ' + escape(p) for p in sorted(set(deps))))
+    f.write('\n')
+
+
+def main():
+  parser = argparse.ArgumentParser()
+  parser.add_argument('--dts',
+                      help='Board device tree source',
+                      metavar='FILE')
+  parser.add_argument('--dtb',
+                      help='Already compiled device tree (skips cpp/dtc)',
+                      metavar='FILE')
+  parser.add_argument('-I', '--include', action='append', default=[],
+                      help='Include directory for cpp and dtc',
+                      metavar='DIR')
+  parser.add_argument('-d', '--drivers', action='append', default=[],
+                      help='Source directory to scan for drivers',
+                      metavar='DIR')
+  parser.add_argument('-o', '--output-dir',
+                      help='Directory for dt-plat.c and generated/',
+                      metavar='DIR')
+  parser.add_argument('-w', '--warn', action='store_true',
+                      help='Report nodes which have no driver')
+  parser.add_argument('--depfile',
+                      help='Write the .dts and driver sources read to FILE',
+                      metavar='FILE')
+  args = parser.parse_args()
+
+  deps = []
+  if args.dtb:
+    source = os.path.basename(args.dtb)
+    deps.append(args.dtb)
+    with open(args.dtb, 'rb') as f:
+      data = f.read()
+  else:
+    source = os.path.basename(args.dts)
+    data = compile_dts(args.dts, args.include, deps)
+
+  root = parse_dtb(data)
+  nodes = select_nodes(root, scan_drivers(args.drivers, deps), args.warn)
+  structs = build_structs(nodes, find_phandles(root), args.warn)
+
+  gen_dir = os.path.join(args.output_dir, 'generated')
+  if not os.path.isdir(gen_dir):
+    os.makedirs(gen_dir)
+  write_file(os.path.join(gen_dir, 'dt-structs-gen.h'),
+                   write_structs(structs, source))
+  write_file(os.path.join(gen_dir, 'dt-decl.h'),
+                   write_decl(nodes, source))
+  plat = os.path.join(args.output_dir, 'dt-plat.c')
+  write_file(plat, write_plat(nodes, structs, source))
+  if args.depfile:
+    write_depfile(args.depfile, plat, deps)
+  return 0
+
+if __name__ == "__main__":
+  sys.exit(main())